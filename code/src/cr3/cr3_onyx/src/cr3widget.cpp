@@ -1173,6 +1173,13 @@ void CR3View::OnFormatProgress( int percent )
     CRLog::info( "OnFormatProgress(%d%%)", percent );
 }
 
+/// pages around current position are formatted and may be drawn before formatting is finished
+void CR3View::OnFormatFirstPagesReady( int page )
+{
+    CRLog::info( "OnFormatFirstPagesReady(%d) - painting current page", page );
+    repaint();
+}
+
 /// first page is loaded from file an can be formatted for preview
 void CR3View::OnLoadFileFirstPagesReady()
 {
@@ -136,6 +136,8 @@ class CR3View : public QWidget, public LVDocViewCallback
         virtual void OnLoadFileProgress( int percent );
         /// format progress, called with values 0..100
         virtual void OnFormatProgress( int percent );
+        /// pages around current position are formatted and may be drawn before formatting is finished
+        virtual void OnFormatFirstPagesReady( int page );
 
     public slots:
         void contextMenu( QPoint pos );
@@ -133,6 +133,7 @@ OnyxMainWindow::OnyxMainWindow(QWidget *parent)
 
     QString hyphDir = exeDir + "hyph" + QDir::separator();
     ldomDocCache::init( qt2cr( cacheDir ), DOC_CACHE_SIZE );
+    fontMan->setWidthCacheFile( qt2cr( cacheDir + QDir::separator() + "fontwidths.dat" ) );
     view_->setPropsChangeCallback( this );
     if ( !view_->loadSettings( iniFile ) )
         view_->loadSettings( iniFile2 );
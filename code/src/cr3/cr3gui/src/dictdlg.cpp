@@ -70,10 +70,13 @@ lString8 CRTinyDict::translate(const lString8 & w)
     lString8 word = UnicodeToUtf8( s16 );
     lString8 body;
     TinyDictResultList results;
+    // look up original spelling too (e.g. proper names), in the same pass over dictionaries
+    const char * forms[2] = { word.c_str(), w.c_str() };
+    int formCount = ( w == word ) ? 1 : 2;
     if ( dicts.length() == 0 ) {
     	// should not happen
         body << "<title><p>No dictionaries found</p></title>";
-    } else if ( dicts.find(results, word.c_str(), TINY_DICT_OPTION_STARTS_WITH ) ) {
+    } else if ( dicts.find(results, forms, formCount, TINY_DICT_OPTION_STARTS_WITH ) ) {
         for ( int d = 0; d<results.length(); d++ ) {
             TinyDictWordList * words = results.get(d);
             if ( words->length()>0 )
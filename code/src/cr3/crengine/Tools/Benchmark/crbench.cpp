@@ -0,0 +1,464 @@
+// Cool Reader Engine
+// crbench: headless benchmark for document loading, rendering, drawing and search
+// this program is distributed under the terms of GNU GPL2 license
+//
+// Usage:
+//   crbench [options] <file> [<file> ...]
+//     -f <font.ttf>      register font (may be repeated, at least one is required)
+//     -s <n,n,...>       font sizes to paginate with (default 22,28,36)
+//     -W <width>         page width (default 600)
+//     -H <height>        page height (default 800)
+//     -b <bpp>           LVGrayDrawBuf bits per pixel (default 4)
+//     -p <count>         max pages to draw, 0 for all (default 0)
+//     -q <text>          search pattern (default: a word picked from the middle page)
+//     -r <count>         repeat each file N times, timings keep median value (default 3)
+//     -d <dir>           document cache directory (default ./crbench.cache)
+//     -o <file>          write results to file instead of stdout
+//
+//   crbench -c <base.tsv> <new.tsv> [-t <percent>] [-m <ms>]
+//     compare two result files, report timing/memory regressions above
+//     threshold (default 10%); exit code is 1 if any regression is found;
+//     timing differences below <ms> (default 5) are ignored; timings are
+//     compared only if both files have medians of 2 or more runs (-r)
+//
+// Results are written one metric per line: file <TAB> metric <TAB> value.
+// Metrics ending with _ms are timings in milliseconds, with _kb - memory in kilobytes;
+// both are "lower is better". Other metrics (page counts, search hits) should
+// not change between commits unless rendering has changed.
+// peak_rss_kb is process-wide, run one file per process to get per-file peaks.
+// Files smaller than 30000 bytes are not cached by LVDocView, so they have no
+// cache_save_ms, load_warm_ms and render_warm_ms metrics.
+
+#include "crengine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#define CRBENCH_FORMAT_VERSION 1
+/// default number of runs per file; timings are medians of runs
+#define CRBENCH_DEFAULT_REPEAT 3
+/// default timing change (in ms) below which it is treated as noise when comparing
+#define CRBENCH_MIN_TIME_DELTA 5.0
+/// LVDocView::swapToCache() doesn't save files smaller than this, they have no warm load metrics
+#define CRBENCH_MIN_CACHED_FILE_SIZE 30000
+
+/// returns current time, in milliseconds
+static double benchTimeMs()
+{
+    timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/// returns peak resident set size of the process, in kilobytes
+static int benchPeakRssKb()
+{
+    rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage ) )
+        return 0;
+    return (int)usage.ru_maxrss;
+}
+
+/// single measured value
+struct BenchMetric {
+    lString8 file;
+    lString8 name;
+    double value;
+    LVArray<double> samples; ///< values of timing in each run, sorted
+    BenchMetric( const lString8 & f, const lString8 & n, double v ) : file(f), name(n), value(v) { }
+    /// adds timing of one more run, value becomes median of runs
+    void addSample( double v )
+    {
+        int pos = samples.length();
+        while ( pos > 0 && samples[pos - 1] > v )
+            pos--;
+        samples.insert( pos, v );
+        int n = samples.length();
+        value = (n & 1) ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    }
+};
+
+/// returns true for metrics where lower value is better (timings and memory)
+static bool isCostMetric( const lString8 & name )
+{
+    return name.endsWith( "_ms" ) || name.endsWith( "_kb" );
+}
+
+/// ordered list of benchmark results
+class BenchResults {
+    LVPtrVector<BenchMetric> _items;
+    int _repeat;
+public:
+    BenchResults() : _repeat(0) { }
+    /// number of runs of each file, as written in header of results file
+    int getRepeat() const { return _repeat; }
+    int length() const { return _items.length(); }
+    BenchMetric * get( int index ) { return _items[index]; }
+    BenchMetric * find( const lString8 & file, const lString8 & name )
+    {
+        for ( int i=0; i<_items.length(); i++ )
+            if ( _items[i]->name == name && _items[i]->file == file )
+                return _items[i];
+        return NULL;
+    }
+    /// add value; for repeated runs timings keep median, memory keeps maximum
+    void add( const lString8 & file, const lString8 & name, double value )
+    {
+        BenchMetric * item = find( file, name );
+        if ( !item ) {
+            item = new BenchMetric( file, name, value );
+            _items.add( item );
+        }
+        if ( name.endsWith( "_ms" ) ) {
+            item->addSample( value );
+        } else if ( name.endsWith( "_kb" ) ) {
+            if ( value > item->value )
+                item->value = value;
+        } else {
+            item->value = value;
+        }
+    }
+    void write( FILE * out )
+    {
+        for ( int i=0; i<_items.length(); i++ )
+            fprintf( out, "%s\t%s\t%.3f\n", _items[i]->file.c_str(), _items[i]->name.c_str(), _items[i]->value );
+        fflush( out );
+    }
+    /// read results written by write(), comment lines are skipped except repeat count of header
+    bool read( const char * fname )
+    {
+        FILE * f = fopen( fname, "rt" );
+        if ( !f )
+            return false;
+        char line[4096];
+        while ( fgets( line, sizeof(line), f ) ) {
+            if ( line[0]=='#' ) {
+                const char * repeat = strstr( line, " repeat=" );
+                if ( repeat )
+                    _repeat = atoi( repeat + 8 );
+                continue;
+            }
+            char * tab1 = strchr( line, '\t' );
+            char * tab2 = tab1 ? strchr( tab1 + 1, '\t' ) : NULL;
+            if ( !tab2 )
+                continue;
+            *tab1 = 0;
+            *tab2 = 0;
+            _items.add( new BenchMetric( lString8(line), lString8(tab1 + 1), atof(tab2 + 1) ) );
+        }
+        fclose( f );
+        return true;
+    }
+};
+
+/// benchmark settings
+struct BenchOptions {
+    LVArray<int> fontSizes;
+    int width;
+    int height;
+    int bpp;
+    int maxDrawPages;
+    int repeat;
+    lString16 pattern;
+    lString16 cacheDir;
+    BenchOptions() : width(600), height(800), bpp(4), maxDrawPages(0), repeat(CRBENCH_DEFAULT_REPEAT), cacheDir(L"crbench.cache") { }
+};
+
+static LVDocView * createBenchView( const BenchOptions & opts )
+{
+    LVDocView * view = new LVDocView( opts.bpp );
+    // cache is saved explicitly to measure save time separately from rendering
+    CRPropRef props = LVCreatePropsContainer();
+    props->setInt( PROP_MIN_FILE_SIZE_TO_CACHE, 0x7FFFFFFF );
+    view->propsApply( props );
+    view->setFontSize( opts.fontSizes[0] );
+    view->Resize( opts.width, opts.height );
+    return view;
+}
+
+/// returns first word of at least 5 letters from the middle page, to use as search pattern
+static lString16 pickSearchPattern( LVDocView * view )
+{
+    LVRendPageList * pages = view->getPageList();
+    ldomDocument * doc = view->getDocument();
+    for ( int p = pages->length() / 2; p < pages->length(); p++ ) {
+        LVRendPageInfo * page = (*pages)[p];
+        ldomXPointer start = doc->createXPointer( lvPoint(0, page->start) );
+        ldomXPointer end = doc->createXPointer( lvPoint(0, page->start + page->height - 1) );
+        if ( start.isNull() || end.isNull() )
+            continue;
+        ldomXRange range( start, end );
+        lString16 text = range.getRangeText();
+        int wordStart = 0;
+        int len = (int)text.length();
+        for ( int i=0; i<=len; i++ ) {
+            if ( i < len && (lGetCharProps(text[i]) & CH_PROP_ALPHA) )
+                continue;
+            if ( i - wordStart >= 5 )
+                return text.substr( wordStart, i - wordStart );
+            wordStart = i + 1;
+        }
+    }
+    return lString16();
+}
+
+/// draw pages into gray buffer, report average and max time per page
+static void benchDraw( LVDocView * view, const BenchOptions & opts, const lString8 & file, BenchResults & results )
+{
+    LVGrayDrawBuf buf( opts.width, opts.height, opts.bpp );
+    int count = view->getPageCount();
+    if ( opts.maxDrawPages > 0 && count > opts.maxDrawPages )
+        count = opts.maxDrawPages;
+    double total = 0;
+    double maxTime = 0;
+    for ( int p=0; p<count; p++ ) {
+        view->goToPage( p );
+        double t = benchTimeMs();
+        view->Draw( buf );
+        t = benchTimeMs() - t;
+        total += t;
+        if ( t > maxTime )
+            maxTime = t;
+    }
+    results.add( file, lString8("draw_pages"), count );
+    results.add( file, lString8("draw_total_ms"), total );
+    results.add( file, lString8("draw_page_avg_ms"), count ? total / count : 0 );
+    results.add( file, lString8("draw_page_max_ms"), maxTime );
+}
+
+/// run all measurements for single file
+static bool benchFile( const char * fname, const BenchOptions & opts, BenchResults & results )
+{
+    lString8 file( fname );
+
+    // cold load: parse with empty cache
+    ldomDocCache::clear();
+    LVDocView * view = createBenchView( opts );
+    double t = benchTimeMs();
+    if ( !view->LoadDocument( fname ) ) {
+        fprintf( stderr, "crbench: cannot open %s\n", fname );
+        delete view;
+        return false;
+    }
+    results.add( file, lString8("load_cold_ms"), benchTimeMs() - t );
+
+    // pagination for each font size, first one is rendered right after loading
+    for ( int i=0; i<opts.fontSizes.length(); i++ ) {
+        lString8 size = lString8::itoa( opts.fontSizes[i] );
+        if ( i > 0 ) {
+            view->setFontSize( opts.fontSizes[i] );
+            view->requestRender();
+        }
+        t = benchTimeMs();
+        view->checkRender();
+        results.add( file, lString8("render_") + size + "_ms", benchTimeMs() - t );
+        results.add( file, lString8("pages_") + size, view->getPageCount() );
+    }
+    if ( opts.fontSizes.length() > 1 ) {
+        view->setFontSize( opts.fontSizes[0] );
+        view->checkRender();
+    }
+
+    benchDraw( view, opts, file, results );
+
+    lString16 pattern = opts.pattern.empty() ? pickSearchPattern( view ) : opts.pattern;
+    if ( !pattern.empty() ) {
+        LVArray<ldomWord> words;
+        t = benchTimeMs();
+        view->getDocument()->findText( pattern, true, false, -1, -1, words, 0x7FFFFFFF, -1 );
+        results.add( file, lString8("search_ms"), benchTimeMs() - t );
+        results.add( file, lString8("search_hits"), words.length() );
+    }
+
+    bool cached = view->getDocProps()->getIntDef( DOC_PROP_FILE_SIZE, 0 ) >= CRBENCH_MIN_CACHED_FILE_SIZE;
+    if ( cached ) {
+        t = benchTimeMs();
+        view->swapToCache();
+        results.add( file, lString8("cache_save_ms"), benchTimeMs() - t );
+    }
+    delete view;
+
+    if ( cached ) {
+        // warm load: document and rendering restored from cache
+        view = createBenchView( opts );
+        t = benchTimeMs();
+        if ( view->LoadDocument( fname ) ) {
+            results.add( file, lString8("load_warm_ms"), benchTimeMs() - t );
+            t = benchTimeMs();
+            view->checkRender();
+            results.add( file, lString8("render_warm_ms"), benchTimeMs() - t );
+        }
+        delete view;
+    }
+
+    results.add( file, lString8("peak_rss_kb"), benchPeakRssKb() );
+    return true;
+}
+
+/// compare two result files; returns number of regressions
+static int compareResults( const char * baseName, const char * newName, double threshold, double minTimeDelta )
+{
+    BenchResults base;
+    BenchResults current;
+    if ( !base.read( baseName ) || !current.read( newName ) ) {
+        fprintf( stderr, "crbench: cannot read %s or %s\n", baseName, newName );
+        return -1;
+    }
+    // timings of single run are not reliable enough to report regressions
+    bool compareTimings = base.getRepeat() > 1 && current.getRepeat() > 1;
+    if ( !compareTimings )
+        fprintf( stderr, "crbench: %s has single-run timings, run with -r 3 or more to compare them\n",
+                 base.getRepeat() > 1 ? newName : baseName );
+    int regressions = 0;
+    printf( "# file\tmetric\tbase\tnew\tchange%%\tstatus\n" );
+    for ( int i=0; i<current.length(); i++ ) {
+        BenchMetric * item = current.get( i );
+        BenchMetric * old = base.find( item->file, item->name );
+        if ( !old )
+            continue;
+        double change = old->value != 0 ? (item->value - old->value) * 100.0 / old->value : (item->value != 0 ? 100.0 : 0.0);
+        const char * status = "ok";
+        bool noise = item->name.endsWith( "_ms" ) && ( !compareTimings
+                || ( item->value - old->value < minTimeDelta && old->value - item->value < minTimeDelta ) );
+        if ( isCostMetric( item->name ) ) {
+            if ( noise ) {
+                // too small difference to judge
+            } else if ( change > threshold ) {
+                status = "REGRESSION";
+                regressions++;
+            } else if ( change < -threshold ) {
+                status = "improved";
+            }
+        } else if ( item->value != old->value ) {
+            status = "CHANGED";
+        }
+        printf( "%s\t%s\t%.3f\t%.3f\t%+.1f\t%s\n", item->file.c_str(), item->name.c_str(), old->value, item->value, change, status );
+    }
+    printf( "# %d regression(s) above %.1f%%\n", regressions, threshold );
+    return regressions;
+}
+
+static void usage()
+{
+    printf( "usage: crbench [-f font.ttf]... [-s 22,28,36] [-W width] [-H height] [-b bpp] [-p maxpages]\n"
+            "               [-q pattern] [-r repeat] [-d cachedir] [-o out.tsv] file...\n"
+            "       crbench -c base.tsv new.tsv [-t threshold%%] [-m min_ms]\n" );
+}
+
+int main( int argc, const char ** argv )
+{
+    if ( argc >= 4 && !strcmp( argv[1], "-c" ) ) {
+        double threshold = 10;
+        double minTimeDelta = CRBENCH_MIN_TIME_DELTA;
+        for ( int i=4; i + 1 < argc; i += 2 ) {
+            if ( !strcmp( argv[i], "-t" ) )
+                threshold = atof( argv[i + 1] );
+            else if ( !strcmp( argv[i], "-m" ) )
+                minTimeDelta = atof( argv[i + 1] );
+            else {
+                usage();
+                return 2;
+            }
+        }
+        int res = compareResults( argv[2], argv[3], threshold, minTimeDelta );
+        return res ? 1 : 0;
+    }
+
+    CRLog::setStderrLogger();
+    CRLog::setLogLevel( CRLog::LL_ERROR );
+    InitFontManager( lString8() );
+
+    BenchOptions opts;
+    lString8Collection files;
+    const char * outName = NULL;
+    int fontCount = 0;
+    for ( int i=1; i<argc; i++ ) {
+        const char * arg = argv[i];
+        if ( arg[0]=='-' && arg[1] && !arg[2] && i + 1 < argc ) {
+            const char * value = argv[++i];
+            switch ( arg[1] ) {
+            case 'f':
+                if ( fontMan->RegisterFont( lString8(value) ) )
+                    fontCount++;
+                else
+                    fprintf( stderr, "crbench: cannot register font %s\n", value );
+                break;
+            case 's':
+                for ( const char * p = value; *p; ) {
+                    int n = atoi( p );
+                    if ( n > 0 )
+                        opts.fontSizes.add( n );
+                    while ( *p && *p != ',' )
+                        p++;
+                    if ( *p )
+                        p++;
+                }
+                break;
+            case 'W': opts.width = atoi( value ); break;
+            case 'H': opts.height = atoi( value ); break;
+            case 'b': opts.bpp = atoi( value ); break;
+            case 'p': opts.maxDrawPages = atoi( value ); break;
+            case 'r': opts.repeat = atoi( value ); break;
+            case 'q': opts.pattern = Utf8ToUnicode( lString8(value) ); break;
+            case 'd': opts.cacheDir = LocalToUnicode( lString8(value) ); break;
+            case 'o': outName = value; break;
+            default:
+                usage();
+                return 2;
+            }
+        } else if ( arg[0]=='-' ) {
+            usage();
+            return 2;
+        } else {
+            files.add( lString8(arg) );
+        }
+    }
+    if ( !files.length() || !fontCount || opts.width <= 0 || opts.height <= 0 ) {
+        usage();
+        ShutdownFontManager();
+        return 2;
+    }
+    if ( opts.bpp < 1 || opts.bpp > 8 )
+        opts.bpp = 4;
+    if ( opts.repeat < 1 )
+        opts.repeat = 1;
+    if ( !opts.fontSizes.length() ) {
+        opts.fontSizes.add( 22 );
+        opts.fontSizes.add( 28 );
+        opts.fontSizes.add( 36 );
+    }
+    if ( !ldomDocCache::init( opts.cacheDir, 0x10000000 ) )
+        fprintf( stderr, "crbench: cannot init cache in %s, cache metrics are not meaningful\n", UnicodeToUtf8(opts.cacheDir).c_str() );
+
+    FILE * out = stdout;
+    if ( outName ) {
+        out = fopen( outName, "wt" );
+        if ( !out ) {
+            fprintf( stderr, "crbench: cannot write %s\n", outName );
+            ShutdownFontManager();
+            return 2;
+        }
+    }
+    fprintf( out, "# crbench %d page=%dx%d bpp=%d repeat=%d\n", CRBENCH_FORMAT_VERSION, opts.width, opts.height, opts.bpp, opts.repeat );
+
+    BenchResults results;
+    int failed = 0;
+    for ( int i=0; i<(int)files.length(); i++ ) {
+        for ( int r=0; r<opts.repeat; r++ ) {
+            if ( !benchFile( files[i].c_str(), opts, results ) ) {
+                failed++;
+                break;
+            }
+        }
+    }
+    results.write( out );
+    if ( out != stdout )
+        fclose( out );
+
+    ldomDocCache::clear();
+    ldomDocCache::close();
+    ShutdownFontManager();
+    return failed ? 1 : 0;
+}
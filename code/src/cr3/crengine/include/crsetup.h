@@ -106,6 +106,11 @@
 #define GLYPH_CACHE_SIZE 0x40000
 #endif
 
+#ifndef GLYPH_CACHE_SHARDS
+/// number of independently locked LRU lists glyph cache is split into
+#define GLYPH_CACHE_SHARDS 4
+#endif
+
 
 // disable some features for SYMBIAN
 #if defined(__SYMBIAN32__)
@@ -175,6 +180,16 @@
 #define ZIP_STREAM_BUFFER_SIZE 0x10000
 #endif
 
+/// distance between inflate checkpoints in ZIP member seek index (in unpacked bytes), 0 to disable index
+#ifndef ZIP_SEEK_INDEX_SPAN
+#define ZIP_SEEK_INDEX_SPAN 0x100000
+#endif
+
+/// minimal unpacked size of ZIP member to build seek index for
+#ifndef ZIP_SEEK_INDEX_MIN_SIZE
+#define ZIP_SEEK_INDEX_MIN_SIZE 0x200000
+#endif
+
 /// document stream buffer size
 #ifndef FILE_STREAM_BUFFER_SIZE
 #define FILE_STREAM_BUFFER_SIZE 0x40000
@@ -248,6 +263,16 @@
 #define MAX_SKIN_IMAGE_CACHE_ITEM_UNPACKED_SIZE 80*80*4
 #endif
 
+/// max memory used to keep decoded and scaled document images for redraw, bytes; 0 to decode image on each draw
+#ifndef SCALED_IMAGE_CACHE_SIZE
+#define SCALED_IMAGE_CACHE_SIZE 0x400000 // 4Mb
+#endif
+
+/// max memory used to keep formatted paragraphs (final blocks) for drawing and hit testing, bytes
+#ifndef RENDER_BLOCK_CACHE_SIZE
+#define RENDER_BLOCK_CACHE_SIZE 0x100000 // 1Mb
+#endif
+
 // max skin image file size to hold as a packed copy in memory
 #ifndef MAX_SKIN_IMAGE_CACHE_ITEM_RAM_COPY_PACKED_SIZE
 #define MAX_SKIN_IMAGE_CACHE_ITEM_RAM_COPY_PACKED_SIZE 10000
@@ -77,6 +77,7 @@
 #define PROP_FORCED_MIN_FILE_SIZE_TO_CACHE  "crengine.cache.forced.filesize.min"
 #define PROP_PROGRESS_SHOW_FIRST_PAGE  "crengine.progress.show.first.page"
 #define PROP_HIGHLIGHT_COMMENT_BOOKMARKS "crengine.highlight.bookmarks"
+#define PROP_PAGE_IMAGE_CACHE_SIZE   "crengine.page.image.cache.size"
 // image scaling settings
 // mode: 0=disabled, 1=integer scaling factors, 2=free scaling
 // scale: 0=auto based on font size, 1=no zoom, 2=scale up to *2, 3=scale up to *3
@@ -134,99 +135,64 @@ public:
 
 typedef LVRef<LVDocImageHolder> LVDocImageRef;
 
+/// default memory limit for page image cache, in bytes
+#ifndef PAGE_IMAGE_CACHE_SIZE
+#define PAGE_IMAGE_CACHE_SIZE 0x400000
+#endif
+
 /// page image cache
+/**
+    Keeps several page images within memory limit (but at least two pages),
+    least recently used images are removed first.
+    Shares mutex with document view: background renderer holds it while drawing page,
+    and LVDocImageRef returned by get() keeps it locked while image is in use.
+*/
 class LVDocViewImageCache
 {
     private:
-        LVMutex _mutex;
+        LVMutex & _mutex;
         class Item {
             public:
                 LVRef<LVDrawBuf> _drawbuf;
-                LVRef<LVThread> _thread;
                 int _offset;
                 int _page;
-                bool _ready;
-                bool _valid;
+                lUInt32 _lastAccess;
+                bool matches( int offset, int page )
+                {
+                    return (_offset == offset && offset!=-1) || (_page==page && page!=-1);
+                }
+                int getSize()
+                {
+                    return _drawbuf->GetRowSize() * _drawbuf->GetHeight();
+                }
         };
-        Item _items[2];
-        int _last;
+        LVPtrVector<Item> _items;
+        int _maxSize;
+        lUInt32 _accessCounter;
+        int _generation;
+        int find( int offset, int page );
+        void removeExtraItems( int keepOffset, int keepPage );
     public:
         /// return mutex
         LVMutex & getMutex() { return _mutex; }
-        /// set page to cache
-        void set( int offset, int page, LVRef<LVDrawBuf> drawbuf, LVRef<LVThread> thread )
-        {
-            LVLock lock( _mutex );
-            _last = (_last + 1) & 1;
-            _items[_last]._ready = false;
-            _items[_last]._thread = thread;
-            _items[_last]._drawbuf = drawbuf;
-            _items[_last]._offset = offset;
-            _items[_last]._page = page;
-            _items[_last]._valid = true;
-        }
-        /// return page image, wait until ready
-        LVRef<LVDrawBuf> getWithoutLock( int offset, int page )
-        {
-            for ( int i=0; i<2; i++ ) {
-                if ( _items[i]._valid &&
-                     ( (_items[i]._offset == offset && offset!=-1)
-                      || (_items[i]._page==page && page!=-1)) ) {
-                    if ( !_items[i]._ready ) {
-                        _items[i]._thread->join();
-                        _items[i]._thread = NULL;
-                        _items[i]._ready = true;
-                    }
-                    _last = i;
-                    return _items[i]._drawbuf;
-                }
-            }
-            return LVRef<LVDrawBuf>();
-        }
-        /// return page image, wait until ready
-        LVDocImageRef get( int offset, int page )
-        {
-            _mutex.lock();
-            LVRef<LVDrawBuf> buf = getWithoutLock( offset, page );
-            if ( !buf.isNull() )
-                return LVDocImageRef( new LVDocImageHolder(getWithoutLock( offset, page ), _mutex) );
-            return LVDocImageRef( NULL );
-        }
-        bool has( int offset, int page )
-        {
-            _mutex.lock();
-            for ( int i=0; i<2; i++ ) {
-                if ( _items[i]._valid && ( (_items[i]._offset == offset && offset!=-1)
-                      || (_items[i]._page==page && page!=-1)) ) {
-                    return true;
-                }
-            }
-            return false;
-        }
-        void clear()
-        {
-            LVLock lock( _mutex );
-            for ( int i=0; i<2; i++ ) {
-                if ( _items[i]._valid && !_items[i]._ready ) {
-                    _items[i]._thread->join();
-                }
-                _items[i]._thread.Clear();
-                _items[i]._valid = false;
-                _items[i]._drawbuf.Clear();
-                _items[i]._offset = -1;
-                _items[i]._page = -1;
-            }
-        }
-        LVDocViewImageCache()
-        : _last(0)
-        {
-            for ( int i=0; i<2; i++ )
-                _items[i]._valid = false;
-        }
-        ~LVDocViewImageCache()
-        {
-            clear();
-        }
+        /// put page image to cache, removes least recently used pages if memory limit is exceeded
+        void set( int offset, int page, LVRef<LVDrawBuf> drawbuf );
+        /// return page image, keeping mutex locked until returned reference is destroyed; NULL if not found
+        LVDocImageRef get( int offset, int page );
+        /// returns true if page image is in cache
+        bool has( int offset, int page );
+        /// remove all page images
+        void clear();
+        /// returns counter which is increased on each clear(), to detect outdated background render requests
+        int getGeneration() { return _generation; }
+        /// set memory limit, bytes
+        void setMaxSize( int maxSize );
+        /// returns memory limit, bytes
+        int getMaxSize() { return _maxSize; }
+        /// returns memory used by page images, bytes
+        int getSize();
+        LVDocViewImageCache( LVMutex & mutex );
+        ~LVDocViewImageCache();
 };
 #endif
 
@@ -360,9 +326,13 @@ typedef LVArray<int> LVBookMarkPercentInfo;
 
     Supports scroll view of document.
 */
+class LVDocViewRenderThread;
+class LVDocViewFormatCallback;
+
 class LVDocView : public CacheLoadingCallback
 {
-    friend class LVDrawThread;
+    friend class LVDocViewRenderThread;
+    friend class LVDocViewFormatCallback;
 private:
     int m_bitsPerPixel;
     int m_dx;
@@ -445,9 +415,24 @@ private:
     LVArray<int> m_section_bounds;
     bool m_section_bounds_valid;
 
+    /// page numbers of TOC items are valid until next render
+    bool m_toc_pages_valid;
+
     LVMutex _mutex;
 #if CR_ENABLE_PAGE_IMAGE_CACHE==1
     LVDocViewImageCache m_imageCache;
+    LVDocViewRenderThread * m_renderThread;
+    int m_lastImagePage;
+    int m_lastImageOffset;
+    int m_pageImageDirection;
+    /// create buffer and draw page image into it
+    LVRef<LVDrawBuf> createPageImage( int offset, int page );
+    /// draw page image in background thread, unless it's already cached or cache is reset since request
+    void prerenderPageImage( int offset, int page, int generation );
+    /// schedule background rendering of pages around current one, in reading direction
+    void prefetchPageImages();
+    /// returns offset and page to draw for current page + delta, false if out of document
+    bool getPageImagePosition( int delta, int & offset, int & page );
 #endif
 
 
@@ -681,6 +666,8 @@ public:
     bool IsDrawed();
     /// cache page image (render in background if necessary) (0=current, -1=prev, 1=next)
     void cachePageImage( int delta );
+    /// set page image cache memory limit, bytes
+    void setPageImageCacheSize( int bytes );
 #endif
     /// return view mutex
     LVMutex & getMutex() { return _mutex; }
@@ -745,6 +732,8 @@ public:
     bool getFlatToc( LVPtrVector<LVTocItem, false> & items );
     /// update page numbers for items
     void updatePageNumbers( LVTocItem * item );
+    /// update page numbers of whole TOC, if not done since last render
+    void updateTocPages();
     /// set view mode (pages/scroll)
     void setViewMode( LVDocViewMode view_mode, int visiblePageCount=-1 );
     /// get view mode (pages/scroll)
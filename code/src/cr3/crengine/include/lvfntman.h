@@ -24,6 +24,7 @@
 #include "lvptrvec.h"
 #include "hyphman.h"
 #include "lvdrawbuf.h"
+#include "lvthread.h"
 
 #if !defined(__SYMBIAN32__) && defined(_WIN32)
 extern "C" {
@@ -34,57 +35,98 @@ extern "C" {
 class LVDrawBuf;
 
 struct LVFontGlyphCacheItem;
+class LVFontLocalGlyphCache;
 
+/// glyph cache usage statistics
+struct LVFontGlyphCacheStats
+{
+    lUInt32 hits;      ///< glyphs found in cache
+    lUInt32 misses;    ///< glyphs which had to be rendered
+    lUInt32 evictions; ///< glyphs removed to fit cache size
+    int items;         ///< number of cached glyphs
+    int bytes;         ///< size of cached glyphs
+    int maxBytes;      ///< cache size limit
+    int slabBytes;     ///< memory reserved by glyph slab pages
+};
+
+/// LRU of glyphs of all fonts, split into separately locked shards
 class LVFontGlobalGlyphCache
 {
 private:
-    LVFontGlyphCacheItem * head;
-    LVFontGlyphCacheItem * tail;
-    int size;
+    struct Shard {
+        LVMutex mutex;
+        LVFontGlyphCacheItem * head;
+        LVFontGlyphCacheItem * tail;
+        int size;
+        int max_size;
+        int items;
+        lUInt32 hits;
+        lUInt32 misses;
+        lUInt32 evictions;
+        Shard() : head(NULL), tail(NULL), size(0), max_size(0), items(0), hits(0), misses(0), evictions(0) { }
+    };
+    Shard _shards[GLYPH_CACHE_SHARDS];
     int max_size;
+    void unlink( Shard & shard, LVFontGlyphCacheItem * item );
+    void pushFront( Shard & shard, LVFontGlyphCacheItem * item );
 public:
-    LVFontGlobalGlyphCache( int maxSize )
-        : head(NULL), tail(NULL), size(0), max_size(maxSize )
-    {
-    }
+    LVFontGlobalGlyphCache( int maxSize );
     ~LVFontGlobalGlyphCache()
     {
         clear();
     }
+    static int getShardIndex( const LVFontLocalGlyphCache * local_cache, lUInt16 ch )
+    {
+        return (int)((((lUInt32)(size_t)local_cache >> 4) * 31 + ch) % GLYPH_CACHE_SHARDS);
+    }
+    /// find glyph of font, moves found glyph to LRU head
+    LVFontGlyphCacheItem * get( LVFontLocalGlyphCache * local_cache, lUInt16 ch );
+    /// add glyph, removes least recently used glyphs of shard if size limit is exceeded
     void put( LVFontGlyphCacheItem * item );
-    void remove( LVFontGlyphCacheItem * item );
-    void refresh( LVFontGlyphCacheItem * item );
+    /// remove and free all glyphs of font
+    void clear( LVFontLocalGlyphCache * local_cache );
+    /// remove and free all glyphs
     void clear();
+    /// retrieve usage statistics
+    void getStats( LVFontGlyphCacheStats & stats );
 };
 
+/// per font glyph index by character; items are owned by global cache
 class LVFontLocalGlyphCache
 {
+    friend class LVFontGlobalGlyphCache;
 private:
-    LVFontGlyphCacheItem * head;
-    LVFontGlyphCacheItem * tail;
+    LVMutex _mutex;
+    LVFontGlyphCacheItem ** _index;
+    int _indexSize;
+    int _count;
     LVFontGlobalGlyphCache * global_cache;
-    int size;
+    LVFontGlyphCacheItem * find( lUInt16 ch );
+    void add( LVFontGlyphCacheItem * item );
+    void remove( LVFontGlyphCacheItem * item );
 public:
     LVFontLocalGlyphCache( LVFontGlobalGlyphCache * globalCache )
-        : head(NULL), tail(NULL), global_cache( globalCache )
+        : _index(NULL), _indexSize(0), _count(0), global_cache( globalCache )
     { }
     ~LVFontLocalGlyphCache()
     {
         clear();
+        if ( _index )
+            free( _index );
     }
-    void clear();
-    LVFontGlyphCacheItem * get( lUInt16 ch );
-    void put( LVFontGlyphCacheItem * item );
-    void remove( LVFontGlyphCacheItem * item );
+    void clear() { global_cache->clear( this ); }
+    LVFontGlyphCacheItem * get( lUInt16 ch ) { return global_cache->get( this, ch ); }
+    void put( LVFontGlyphCacheItem * item ) { global_cache->put( item ); }
 };
 
+/// cached glyph bitmap; allocated from glyph slab pages
 struct LVFontGlyphCacheItem
 {
     LVFontGlyphCacheItem * prev_global;
     LVFontGlyphCacheItem * next_global;
-    LVFontGlyphCacheItem * prev_local;
     LVFontGlyphCacheItem * next_local;
     LVFontLocalGlyphCache * local_cache;
+    int size;        ///< allocated bytes, kept since w*h passed to newItem may not fit bmp_width/bmp_height
     lChar16 ch;
     lUInt8 bmp_width;
     lUInt8 bmp_height;
@@ -95,30 +137,10 @@ struct LVFontGlyphCacheItem
     //=======================================================================
     int getSize()
     {
-        return sizeof(LVFontGlyphCacheItem)
-            + (bmp_width * bmp_height - 1) * sizeof(lUInt8);
-    }
-    static LVFontGlyphCacheItem * newItem( LVFontLocalGlyphCache * local_cache, lChar16 ch, int w, int h )
-    {
-        LVFontGlyphCacheItem * item = (LVFontGlyphCacheItem *)malloc( sizeof(LVFontGlyphCacheItem)
-            + (w*h - 1)*sizeof(lUInt8) );
-        item->ch = ch;
-        item->bmp_width = w;
-        item->bmp_height = h;
-        item->origin_x =   0;
-        item->origin_y =   0;
-        item->advance =    0;
-        item->prev_global = NULL;
-        item->next_global = NULL;
-        item->prev_local = NULL;
-        item->next_local = NULL;
-        item->local_cache = local_cache;
-        return item;
-    }
-    static void freeItem( LVFontGlyphCacheItem * item )
-    {
-        free( item );
+        return size;
     }
+    static LVFontGlyphCacheItem * newItem( LVFontLocalGlyphCache * local_cache, lChar16 ch, int w, int h );
+    static void freeItem( LVFontGlyphCacheItem * item );
 };
 
 
@@ -279,6 +301,12 @@ public:
     virtual lUInt32 GetFontListHash() { return 0; }
     /// clear glyph cache
     virtual void clearGlyphCache() { }
+    /// retrieves glyph cache usage statistics, returns false if font engine has no glyph cache
+    virtual bool getGlyphCacheStats( LVFontGlyphCacheStats & stats ) { return false; }
+    /// sets file to keep glyph widths and kerning pairs of fonts between sessions, returns false if not supported
+    virtual bool setWidthCacheFile( lString16 fileName ) { return false; }
+    /// writes glyph widths and kerning pairs of fonts to width cache file
+    virtual bool saveWidthCache() { return false; }
 
     /// get antialiasing mode
     virtual int GetAntialiasMode() { return _antialiasMode; }
@@ -20,6 +20,7 @@
 
 class LVImageSource;
 class ldomNode;
+class ldomDocument;
 class LVColorDrawBuf;
 
 /// image decoding callback interface
@@ -74,6 +75,12 @@ LVImageSourceRef LVCreateUnpackedImageSource( LVImageSourceRef srcImage, int max
 LVImageSourceRef LVCreateUnpackedImageSource( LVImageSourceRef srcImage, int maxSize, int bpp );
 /// creates image source based on draw buffer
 LVImageSourceRef LVCreateDrawBufImageSource( LVColorDrawBuf * buf, bool own );
+/// returns decoded copy of document image scaled to width x height (as gray+alpha if gray==true), from cache if already decoded; NULL if image cannot be cached
+LVImageSourceRef LVGetCachedScaledImage( LVImageSourceRef srcImage, int width, int height, bool gray );
+/// removes decoded images of specified document from cache, all images if doc==NULL
+void LVClearScaledImageCache( ldomDocument * doc = NULL );
+/// sets memory limit for decoded images cache, bytes; 0 disables caching
+void LVSetScaledImageCacheSize( int maxSize );
 
 
 class LVFont;
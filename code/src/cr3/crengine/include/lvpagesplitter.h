@@ -221,7 +221,22 @@ public:
 
 class LVRendPageList : public LVPtrVector<LVRendPageInfo>
 {
+    /// max of page ends for pages 0..i, non-decreasing, to binary search in FindNearestPage;
+    /// extended lazily for appended pages, truncated by clear() and erase()
+    LVArray<int> _maxPageEnds;
+    void updateMaxPageEnds();
 public:
+    void clear()
+    {
+        _maxPageEnds.clear();
+        LVPtrVector<LVRendPageInfo>::clear();
+    }
+    void erase( int pos, int count )
+    {
+        if ( _maxPageEnds.length() > pos )
+            _maxPageEnds.erase( pos, _maxPageEnds.length() - pos );
+        LVPtrVector<LVRendPageInfo>::erase( pos, count );
+    }
     int FindNearestPage( int y, int direction );
     bool serialize( SerialBuf & buf );
     bool deserialize( SerialBuf & buf );
@@ -311,6 +326,8 @@ public:
 };
 
 class LVDocViewCallback;
+class ldomNode;
+struct PageSplitState;
 class LVRendPageContext
 {
 
@@ -341,6 +358,26 @@ class LVRendPageContext
 
     LVFootNote * curr_note;
 
+    // progressive pagination: preliminary pages are split while lines are added
+    PageSplitState * progress_split;
+    // index of next line to pass to progressive splitter
+    int progress_line;
+    // number of pages in page_list before rendering (e.g. cover)
+    int page_list_base;
+    // splitter state after last page added before a line linking to footnote
+    // which is not rendered yet; Finalize() keeps pages before it
+    PageSplitState * progress_checkpoint;
+    // first line to split from checkpoint state, -1 to split whole document again
+    int progress_checkpoint_line;
+    int progress_checkpoint_pages;
+    // a line linking to footnote which is not rendered yet is split
+    bool progress_pending;
+    // block containing current position; NULL when found or not set
+    ldomNode * first_screen_node;
+    // y of current position, -1 if its block is not rendered yet
+    int first_screen_y;
+    bool first_screen_ready;
+
     LVFootNote * getOrCreateFootNote( lString16 id )
     {
         LVFootNoteRef ref = footNotes.get(id);
@@ -352,6 +389,12 @@ class LVRendPageContext
     }
 
     void split();
+    /// split lines starting from startLine, continuing from splitter state s
+    void splitLines( PageSplitState & s, int startLine );
+    /// returns true if line links to footnote which may get more lines later
+    bool hasPendingFootNotes( LVRendLineInfo * line );
+    /// pass newly added lines to progressive splitter, notify callback when first pages are ready
+    void splitProgressive();
 public:
 
 
@@ -376,7 +419,17 @@ public:
     /// returns page list pointer
     LVRendPageList * getPageList() { return page_list; }
 
+    /// enable progressive pagination: node is the one to show first (NULL for document start)
+    void setFirstScreenNode( ldomNode * node );
+    /// returns block which is waited for to show first screen, NULL if none
+    ldomNode * getFirstScreenNode() { return first_screen_node; }
+    /// returns true if pages may be drawn before document is rendered
+    bool isFirstScreenPending() { return progress_split && !first_screen_ready; }
+    /// called from renderer when lines of first screen node are added
+    void setFirstScreenPosition( int y );
+
     LVRendPageContext(LVRendPageList * pageList, int pageHeight);
+    ~LVRendPageContext();
 
     /// add source line
     void AddLine( int starty, int endy, int flags );
@@ -118,6 +118,9 @@ public:
     void setAttr( lUInt16 id, lString16 value ) { _attrid = id; _value = value; }
     LVCssSelectorRule * getNext() { return _next; }
     void setNext(LVCssSelectorRule * next) { _next = next; }
+    LVCssSelectorRuleType getType() const { return _type; }
+    lUInt16 getId() const { return _id; }
+    const lString16 & getValue() const { return _value; }
     ~LVCssSelectorRule() { if (_next) delete _next; }
     /// check condition for node
     bool check( const ldomNode * & node );
@@ -155,13 +158,18 @@ public:
         if (check( node ))
             _decl->apply(style);
     }
+    /// apply declaration without checking rules
+    void applyDeclaration( css_style_rec_t * style ) const { _decl->apply(style); }
     void setDeclaration( LVCssDeclRef decl ) { _decl = decl; }
     int getSpecificity() { return _specificity; }
     LVCssSelector * getNext() { return _next; }
     void setNext(LVCssSelector * next) { _next = next; }
+    LVCssSelectorRule * getRules() { return _rules; }
     lUInt32 getHash();
 };
 
+class LVCssSelectorIndex;
+
 
 /** \brief stylesheet
     
@@ -175,6 +183,10 @@ public:
 class LVStyleSheet {
     lxmlDocBase * _doc;
     LVPtrVector <LVCssSelector> _selectors;
+    /// class/id buckets over _selectors, built on first apply()
+    LVCssSelectorIndex * _index;
+    /// drop selector index after rules change
+    void invalidateIndex();
 
     LVPtrVector <LVPtrVector <LVCssSelector> > _stack;
     LVPtrVector <LVCssSelector> * dup()
@@ -211,13 +223,15 @@ public:
     }
 
     /// remove all rules from stylesheet
-    void clear() { _selectors.clear(); }
+    void clear() { _selectors.clear(); invalidateIndex(); }
     /// set document to retrieve ID values from
     void setDocument( lxmlDocBase * doc ) { _doc = doc; }
     /// constructor
-    LVStyleSheet( lxmlDocBase * doc = NULL ) : _doc(doc) { }
+    LVStyleSheet( lxmlDocBase * doc = NULL ) : _doc(doc), _index(NULL) { }
     /// copy constructor
     LVStyleSheet( LVStyleSheet & sheet );
+    /// destructor
+    ~LVStyleSheet();
     /// parse stylesheet, compile and add found rules to sheet
     bool parse( const char * str );
     /// apply stylesheet to node style
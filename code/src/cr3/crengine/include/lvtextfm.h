@@ -298,6 +298,9 @@ public:
         return m_pbuffer->frmlines[index];
     }
 
+    /// returns approximate size of source and formatted data, in bytes
+    int GetMemorySize();
+
     void Draw( LVDrawBuf * buf, int x, int y, ldomMarkedRangeList * marks,  ldomMarkedRangeList *bookmarks = NULL );
 
     LFormattedText() { m_pbuffer = lvtextAllocFormatter( 0 ); }
@@ -75,7 +75,12 @@ private:
 public:
     LVMutex()
     {
-        _valid = ( pthread_mutex_init(&_mutex, NULL) !=0 );
+        // recursive: document view methods which lock mutex call each other
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init( &attr );
+        pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+        _valid = ( pthread_mutex_init(&_mutex, &attr) == 0 );
+        pthread_mutexattr_destroy( &attr );
     }
     ~LVMutex()
     {
@@ -101,6 +106,41 @@ public:
     }
 };
 
+/// auto-reset event: wait() blocks until set() is called, then event is reset
+class LVEvent {
+private:
+    pthread_mutex_t _mutex;
+    pthread_cond_t _cond;
+    bool _signaled;
+public:
+    LVEvent()
+    : _signaled(false)
+    {
+        pthread_mutex_init( &_mutex, NULL );
+        pthread_cond_init( &_cond, NULL );
+    }
+    ~LVEvent()
+    {
+        pthread_cond_destroy( &_cond );
+        pthread_mutex_destroy( &_mutex );
+    }
+    void set()
+    {
+        pthread_mutex_lock( &_mutex );
+        _signaled = true;
+        pthread_cond_signal( &_cond );
+        pthread_mutex_unlock( &_mutex );
+    }
+    void wait()
+    {
+        pthread_mutex_lock( &_mutex );
+        while ( !_signaled )
+            pthread_cond_wait( &_cond, &_mutex );
+        _signaled = false;
+        pthread_mutex_unlock( &_mutex );
+    }
+};
+
 #elif defined(_WIN32)
 
 class LVThread {
@@ -189,6 +229,32 @@ class LVMutex {
         }
 };
 
+/// auto-reset event: wait() blocks until set() is called, then event is reset
+class LVEvent {
+    private:
+        HANDLE _event;
+    public:
+        LVEvent()
+        {
+            _event = CreateEvent( NULL, FALSE, FALSE, NULL );
+        }
+        ~LVEvent()
+        {
+            if ( _event != NULL )
+                CloseHandle( _event );
+        }
+        void set()
+        {
+            if ( _event != NULL )
+                SetEvent( _event );
+        }
+        void wait()
+        {
+            if ( _event != NULL )
+                WaitForSingleObject( _event, INFINITE );
+        }
+};
+
 
 #endif
 
@@ -242,6 +308,16 @@ class LVMutex {
         }
 };
 
+class LVEvent {
+    public:
+        void set()
+        {
+        }
+        void wait()
+        {
+        }
+};
+
 #endif
 
 class LVLock {
@@ -94,7 +94,52 @@
 //#if BUILD_LITE!=1
 /// final block cache
 typedef LVRef<LFormattedText> LFormattedTextRef;
-typedef LVCacheMap< ldomNode *, LFormattedTextRef> CVRendBlockCache;
+
+/// LRU cache of formatted final blocks, hashed by node and limited by memory size
+class CVRendBlockCache
+{
+    struct Item {
+        ldomNode * node;
+        LFormattedTextRef text;
+        int size;
+        Item * prev;         ///< more recently used item
+        Item * next;         ///< less recently used item
+        Item * nextInBucket; ///< hash chain
+    };
+    Item ** _table;
+    int _tableSize;
+    Item * _head;
+    Item * _tail;
+    int _count;
+    int _memSize;
+    int _maxMemSize;
+    int _hits;
+    int _misses;
+    Item ** findSlot( ldomNode * node );
+    void unlink( Item * item );
+    void removeItem( Item * item );
+    void resizeTable( int newSize );
+    // no copy: items and hash table are owned by cache
+    CVRendBlockCache( const CVRendBlockCache & );
+    CVRendBlockCache & operator = ( const CVRendBlockCache & );
+public:
+    CVRendBlockCache( int maxMemSize );
+    ~CVRendBlockCache();
+    /// returns cached formatted text for node, moving it to top of LRU list
+    bool get( ldomNode * node, LFormattedTextRef & text );
+    /// adds or replaces formatted text for node, removes least recently used items above size limit
+    void set( ldomNode * node, LFormattedTextRef text );
+    bool remove( ldomNode * node );
+    void clear();
+    /// change memory size limit
+    void setMaxMemSize( int maxMemSize );
+    int getMaxMemSize() { return _maxMemSize; }
+    int length() { return _count; }
+    /// approximate memory used by cached items, in bytes
+    int getMemSize() { return _memSize; }
+    int getHits() { return _hits; }
+    int getMisses() { return _misses; }
+};
 //#endif
 
 
@@ -189,6 +234,11 @@ public:
     virtual void OnFormatEnd() { }
     /// format progress, called with values 0..100
     virtual void OnFormatProgress( int percent ) { }
+    /// preliminary page count while formatting is in progress (final pages are known after OnFormatEnd)
+    virtual void OnFormatPagesReady( int pageCount ) { }
+    /// pages around current position are formatted and may be drawn before formatting is finished;
+    /// LVDocView is marked as rendered at this moment, so drawing doesn't start another render
+    virtual void OnFormatFirstPagesReady( int page ) { }
     /// format progress, called with values 0..100
     virtual void OnExportProgress( int percent ) { }
     /// file load finiished with error
@@ -1899,6 +1949,51 @@ public:
 };
 typedef LVRef<ListNumberingProps> ListNumberingPropsRef;
 
+#if BUILD_LITE!=1
+/// full text search index: text nodes in document order, grouped into blocks with bitmap of lowercase bigrams and trigrams
+class ldomTextSearchIndex
+{
+    int _textCount;           // text node counter of document at the moment index has been built
+    LVArray<lUInt32> _nodes;  // data indexes of text nodes, in document order
+    LVArray<lInt32> _order;   // text node number -> position in _nodes
+    LVArray<lInt32> _blocks;  // position of first node of each block
+    LVArray<lUInt32> _bits;   // n-gram bitmaps of blocks
+    bool _changed;
+    void updateOrder();
+    int findBlock( int pos ) const;
+    bool isCandidate( int block, const LVArray<lUInt32> & bits ) const;
+public:
+    ldomTextSearchIndex();
+    /// removes all data
+    void clear();
+    /// returns true if index is not built
+    bool isEmpty() const { return _blocks.empty(); }
+    /// returns true if index has been built after last save
+    bool isChanged() const { return _changed; }
+    void setChanged( bool changed ) { _changed = changed; }
+    /// returns text node counter of document index has been built for
+    int getTextCount() const { return _textCount; }
+    /// walks through all text nodes of document and fills index
+    void build( ldomDocument * doc, int textCount );
+    /// returns number of indexed nodes
+    int length() const { return _nodes.length(); }
+    /// returns data index of text node at specified position
+    lUInt32 getNodeIndex( int pos ) const { return _nodes[pos]; }
+    /// returns position of text node in index, -1 if node is not indexed
+    int find( ldomNode * node ) const;
+    /// returns n-gram bit numbers of lowercase pattern, false if pattern is too short to use index
+    static bool getPatternBits( const lString16 & pattern, LVArray<lUInt32> & bits );
+    /// returns first position >= pos of node which may contain pattern, -1 if not found
+    int nextCandidate( int pos, const LVArray<lUInt32> & bits ) const;
+    /// returns last position <= pos of node which may contain pattern, -1 if not found
+    int prevCandidate( int pos, const LVArray<lUInt32> & bits ) const;
+    /// serialize to buffer
+    bool serialize( SerialBuf & buf );
+    /// deserialize from buffer, fails if document has different text node count
+    bool deserialize( SerialBuf & buf, int textCount );
+};
+#endif
+
 class ldomDocument : public lxmlDocBase
 {
     friend class ldomDocumentWriter;
@@ -1912,6 +2007,7 @@ private:
     int _page_width;
     bool _rendered;
     ldomXRangeList _selections;
+    ldomTextSearchIndex _searchIndex;
 #endif
 
     lString16 _docStylesheetFileName;
@@ -2006,6 +2102,8 @@ public:
     int getFullHeight();
     /// returns page height setting
     int getPageHeight() { return _page_height; }
+    /// returns false while render is in progress (first screen may be drawn at this time)
+    bool isRendered() { return _rendered; }
 #endif
     /// saves document contents as XML to stream with specified encoding
     bool saveToStream( LVStreamRef stream, const char * codepage, bool treeLayout=false );
@@ -2019,7 +2117,7 @@ public:
     virtual ~ldomDocument();
 #if BUILD_LITE!=1
     /// renders (formats) document in memory
-    virtual int render( LVRendPageList * pages, LVDocViewCallback * callback, int width, int dy, bool showCover, int y0, font_ref_t def_font, int def_interline_space, CRPropRef props );
+    virtual int render( LVRendPageList * pages, LVDocViewCallback * callback, int width, int dy, bool showCover, int y0, font_ref_t def_font, int def_interline_space, CRPropRef props, ldomNode * firstScreenNode = NULL );
     /// renders (formats) document in memory
     virtual bool setRenderProps( int width, int dy, bool showCover, int y0, font_ref_t def_font, int def_interline_space, CRPropRef props );
 #endif
@@ -2048,6 +2146,8 @@ public:
     CVRendBlockCache & getRendBlockCache() { return _renderedBlockCache; }
 
     bool findText( lString16 pattern, bool caseInsensitive, bool reverse, int minY, int maxY, LVArray<ldomWord> & words, int maxCount, int maxHeight );
+    /// returns full text search index, builds it if necessary
+    ldomTextSearchIndex * getTextSearchIndex();
 #endif
 };
 
@@ -91,9 +91,55 @@ public:
 #define TXTFLG_ENCODING_MASK                0xFF00
 #define TXTFLG_ENCODING_SHIFT               8
 #define TXTFLG_CONVERT_8BIT_ENTITY_ENCODING 0x10000
+/// pass text to OnText() as is: callback calls PreProcessXmlText() itself
+#define TXTFLG_RAW_TEXT                     0x20000
 
 /// converts XML text: decode character entities, convert space chars
 void PreProcessXmlString( lString16 & s, lUInt32 flags, const lChar16 * enc_table=NULL );
+/// processing of text which XML parser does before OnText() call: PreProcessXmlString() and trimming, according to flags
+void PreProcessXmlText( lString16 & s, lUInt32 flags, const lChar16 * enc_table=NULL );
+
+/// records XML parser events to replay them later, e.g. to parse in worker thread and build DOM in main thread
+class LVXMLParserEventBuffer : public LVXMLParserCallback
+{
+    struct Event {
+        int type;
+        int s1; // string offsets in _chars, or text length
+        int s2;
+        int s3;
+        const lChar16 * table;
+    };
+    LVArray<Event> _events;
+    LVArray<lChar16> _chars;
+    int addString( const lChar16 * s, int len = -1 );
+    void addEvent( int type, int s1 = -1, int s2 = -1, int s3 = -1, const lChar16 * table = NULL );
+public:
+    /// text is recorded raw, to process it on replay according to flags of target callback
+    virtual lUInt32 getFlags() { return TXTFLG_RAW_TEXT; }
+    /// called on document encoding definition
+    virtual void OnEncoding( const lChar16 * name, const lChar16 * table );
+    /// called on parsing start
+    virtual void OnStart( LVFileFormatParser * parser );
+    /// called on parsing end
+    virtual void OnStop();
+    /// called on opening tag <
+    virtual ldomNode * OnTagOpen( const lChar16 * nsname, const lChar16 * tagname );
+    /// called after > of opening tag (when entering tag body)
+    virtual void OnTagBody();
+    /// called on tag close
+    virtual void OnTagClose( const lChar16 * nsname, const lChar16 * tagname );
+    /// called on element attribute
+    virtual void OnAttribute( const lChar16 * nsname, const lChar16 * attrname, const lChar16 * attrvalue );
+    /// called on text
+    virtual void OnText( const lChar16 * text, int len, lUInt32 flags );
+    /// BLOBs are not recorded: parser of HTML doesn't produce them
+    virtual bool OnBlob(lString16, const lUInt8 *, int) { return false; }
+    /// passes recorded events to callback; parser is not available to callback
+    void replay( LVXMLParserCallback * callback );
+    /// removes all recorded events
+    void clear() { _events.clear(); _chars.clear(); }
+    virtual ~LVXMLParserEventBuffer() { }
+};
 
 #define MAX_PERSISTENT_BUF_SIZE 16384
 
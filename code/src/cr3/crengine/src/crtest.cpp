@@ -171,6 +171,7 @@ LVStreamRef LVCreateCompareTestStream( LVStreamRef stream1, LVStreamRef stream2
 
 // external tests declarations
 void testTxtSelector();
+void testDrawBuf();
 
 
 void runCRUnitTests()
@@ -179,5 +180,6 @@ void runCRUnitTests()
     //runCHMUnitTest();
     runTinyDomUnitTests();
     testTxtSelector();
+    testDrawBuf();
 #endif
 }
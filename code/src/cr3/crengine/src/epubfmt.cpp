@@ -1,4 +1,15 @@
 #include "../include/epubfmt.h"
+#include "../include/lvthread.h"
+
+/// number of spine items parsed ahead in worker threads while DOM is built from current one, 0 to parse sequentially;
+/// requires threads and allocators which are safe to use from several threads
+#ifndef EPUB_IMPORT_PREFETCH_ITEMS
+#if (CR_USE_THREADS==1) && (LDOM_USE_OWN_MEM_MAN!=1)
+#define EPUB_IMPORT_PREFETCH_ITEMS 2
+#else
+#define EPUB_IMPORT_PREFETCH_ITEMS 0
+#endif
+#endif
 
 
 class EpubItem {
@@ -34,6 +45,37 @@ public:
     }
 };
 
+#if EPUB_IMPORT_PREFETCH_ITEMS>0
+/// parses spine item into event buffer in worker thread, to be replayed into document in spine order
+class EpubFragmentParser : public LVThread
+{
+    LVStreamRef _stream;
+    LVXMLParserEventBuffer _events;
+    bool _formatDetected;
+    bool _parsed;
+protected:
+    virtual void run()
+    {
+        LVHTMLParser parser( _stream, &_events );
+        _formatDetected = parser.CheckFormat();
+        _parsed = _formatDetected && parser.Parse();
+    }
+public:
+    /// stream should be accessed by this parser only: archive streams are not thread safe
+    EpubFragmentParser( LVStreamRef stream )
+        : _stream( stream ), _formatDetected( false ), _parsed( false )
+    { }
+    /// passes parsed fragment to writer, returns true if fragment is valid
+    bool replay( LVXMLParserCallback * writer )
+    {
+        join();
+        if ( _formatDetected )
+            _events.replay( writer );
+        return _parsed;
+    }
+};
+#endif
+
 static void dumpZip( LVContainerRef arc ) {
     lString16 arcName = LVExtractFilenameWithoutExtension( arc->GetName() );
     if ( arcName.empty() )
@@ -313,9 +355,46 @@ bool ImportEpubDocument( LVStreamRef stream, ldomDocument * m_doc, LVDocViewCall
             appender.addPathSubstitution( name, lString16(L"_doc_fragment_") + lString16::itoa(i) );
         }
     }
+#if EPUB_IMPORT_PREFETCH_ITEMS>0
+    // items are unpacked here, and parsed in worker threads
+    LVArray<EpubFragmentParser*> parsers( spineItems.length(), NULL );
+    int nextParser = 0;
+#endif
     for ( int i=0; i<spineItems.length(); i++ ) {
         if ( spineItems[i]->mediaType==L"application/xhtml+xml" ) {
             lString16 name = codeBase + spineItems[i]->href;
+#if EPUB_IMPORT_PREFETCH_ITEMS>0
+            // keep current item and few next ones parsing
+            for ( int k=i, ahead=0; k<spineItems.length() && ahead<=EPUB_IMPORT_PREFETCH_ITEMS; k++ ) {
+                if ( spineItems[k]->mediaType!=L"application/xhtml+xml" )
+                    continue;
+                ahead++;
+                if ( k<nextParser )
+                    continue; // already started
+                nextParser = k + 1;
+                LVStreamRef stream = m_arc->OpenStream((codeBase + spineItems[k]->href).c_str(), LVOM_READ);
+                if ( stream.isNull() )
+                    continue;
+                LVStreamRef data = LVCreateMemoryStream( stream );
+                if ( data.isNull() )
+                    continue; // will be parsed directly
+                data->SetName( stream->GetName() );
+                parsers[k] = new EpubFragmentParser( data );
+                data.Clear(); // reference counters are not thread safe, stream is owned by parser from now
+                parsers[k]->start();
+            }
+            if ( parsers[i] ) {
+                CRLog::debug("Checking fragment: %s", LCSTR(name));
+                appender.setCodeBase( name );
+                if ( parsers[i]->replay( &appender ) )
+                    fragmentCount++;
+                else
+                    CRLog::error("Document type is not XML/XHTML for fragment %s", LCSTR(name));
+                delete parsers[i];
+                parsers[i] = NULL;
+                continue;
+            }
+#endif
             {
                 CRLog::debug("Checking fragment: %s", LCSTR(name));
                 LVStreamRef stream = m_arc->OpenStream(name.c_str(), LVOM_READ);
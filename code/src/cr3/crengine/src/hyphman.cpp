@@ -38,6 +38,7 @@
 #include "../include/hyphman.h"
 #include "../include/lvfnt.h"
 #include "../include/lvstring.h"
+#include "../include/lvthread.h"
 
 
 #ifdef ANDROID
@@ -56,20 +57,191 @@ HyphDictionary * HyphMan::_selectedDictionary = NULL;
 HyphDictionaryList * HyphMan::_dictList = NULL;
 
 #define MAX_PATTERN_SIZE  8
-#define PATTERN_HASH_SIZE 16384
+
+/// max number of hyphenated words remembered by each dictionary
+#ifndef HYPH_WORD_CACHE_SIZE
+#define HYPH_WORD_CACHE_SIZE 2048
+#endif
+
 class TexPattern;
+class TexPatternTrieBuilder;
+
+/// compiled pattern trie node; children of node are stored contiguously, sorted by char
+struct TexPatternTrieNode {
+    lChar16 ch;     ///< char of edge leading to this node
+    lUInt16 count;  ///< number of children
+    lUInt32 first;  ///< index of first child
+    lInt32  attr;   ///< offset of zero terminated pattern digits in attrs pool, -1 if node is not pattern end
+};
+
+/// LRU cache of hyphenation masks for lowercased words; items are allocated on first use, growing up to cache size
+class TexHyphWordCache
+{
+    struct Item {
+        lUInt32 hash;
+        int len;       ///< word length
+        bool found;    ///< false if no pattern matched the word
+        int prev;      ///< LRU list
+        int next;
+        int hashNext;  ///< bucket chain
+        lChar16 word[WORD_LENGTH];
+        char mask[WORD_LENGTH+4];
+    };
+    Item * _items;
+    int * _buckets;
+    int _size;
+    int _capacity; ///< number of allocated items
+    int _head;
+    int _tail;
+    int _used;
+    static lUInt32 calcHash( const lChar16 * word, int len )
+    {
+        lUInt32 hash = 0;
+        for ( int i=0; i<len; i++ )
+            hash = hash * 31 + word[i];
+        return hash;
+    }
+    void unlink( int index )
+    {
+        Item & item = _items[index];
+        if ( item.prev>=0 )
+            _items[item.prev].next = item.next;
+        else
+            _head = item.next;
+        if ( item.next>=0 )
+            _items[item.next].prev = item.prev;
+        else
+            _tail = item.prev;
+    }
+    void pushFront( int index )
+    {
+        Item & item = _items[index];
+        item.prev = -1;
+        item.next = _head;
+        if ( _head>=0 )
+            _items[_head].prev = index;
+        _head = index;
+        if ( _tail<0 )
+            _tail = index;
+    }
+    /// allocates hash buckets and more items, keeping used ones
+    void grow()
+    {
+        if ( !_buckets ) {
+            _buckets = new int[ _size ];
+            for ( int i=0; i<_size; i++ )
+                _buckets[i] = -1;
+        }
+        int newCapacity = _capacity ? _capacity * 2 : 64;
+        if ( newCapacity > _size )
+            newCapacity = _size;
+        Item * items = new Item[ newCapacity ];
+        if ( _used )
+            memcpy( items, _items, _used * sizeof(Item) );
+        if ( _items )
+            delete[] _items;
+        _items = items;
+        _capacity = newCapacity;
+    }
+    void removeFromBucket( int index )
+    {
+        int * p = &_buckets[ _items[index].hash % _size ];
+        while ( *p>=0 ) {
+            if ( *p==index ) {
+                *p = _items[index].hashNext;
+                return;
+            }
+            p = &_items[*p].hashNext;
+        }
+    }
+public:
+    TexHyphWordCache( int size ) : _items(NULL), _buckets(NULL), _size(size), _capacity(0), _head(-1), _tail(-1), _used(0)
+    {
+    }
+    ~TexHyphWordCache()
+    {
+        clear();
+    }
+    /// removes all words and frees memory
+    void clear()
+    {
+        if ( _items )
+            delete[] _items;
+        if ( _buckets )
+            delete[] _buckets;
+        _items = NULL;
+        _buckets = NULL;
+        _capacity = 0;
+        _head = _tail = -1;
+        _used = 0;
+    }
+    /// returns true if word is found in cache; mask is filled only if some pattern matched
+    bool get( const lChar16 * word, int len, char * mask, bool & found )
+    {
+        if ( !_buckets )
+            return false;
+        lUInt32 hash = calcHash( word, len );
+        for ( int index = _buckets[hash % _size]; index>=0; index = _items[index].hashNext ) {
+            Item & item = _items[index];
+            if ( item.hash==hash && item.len==len && !memcmp( item.word, word, len * sizeof(lChar16) ) ) {
+                if ( index!=_head ) {
+                    unlink( index );
+                    pushFront( index );
+                }
+                found = item.found;
+                if ( found )
+                    memcpy( mask, item.mask, len + 4 );
+                return true;
+            }
+        }
+        return false;
+    }
+    void put( const lChar16 * word, int len, const char * mask, bool found )
+    {
+        if ( len>WORD_LENGTH )
+            return;
+        int index;
+        if ( _used<_size ) {
+            if ( _used>=_capacity )
+                grow();
+            index = _used++;
+        } else {
+            // reuse least recently used item
+            index = _tail;
+            unlink( index );
+            removeFromBucket( index );
+        }
+        Item & item = _items[index];
+        item.hash = calcHash( word, len );
+        item.len = len;
+        item.found = found;
+        memcpy( item.word, word, len * sizeof(lChar16) );
+        if ( found )
+            memcpy( item.mask, mask, len + 4 );
+        item.hashNext = _buckets[item.hash % _size];
+        _buckets[item.hash % _size] = index;
+        pushFront( index );
+    }
+};
+
 class TexHyph : public HyphMethod
 {
-    TexPattern * table[PATTERN_HASH_SIZE];
+    TexPatternTrieNode * _trie;
+    int _trieSize;
+    char * _attrs;
     lUInt32 _hash;
+    TexHyphWordCache _cache;
+    LVMutex _cacheMutex;
+    inline int findChild( const TexPatternTrieNode & node, lChar16 ch ) const;
 public:
     bool match( const lChar16 * str, char * mask );
     virtual bool hyphenate( const lChar16 * str, int len, lUInt16 * widths, lUInt8 * flags, lUInt16 hyphCharWidth, lUInt16 maxWidth );
-    void addPattern( TexPattern * pattern );
     TexHyph();
     virtual ~TexHyph();
     bool load( LVStreamRef stream );
     bool load( lString16 fileName );
+    /// replace pattern trie with compiled content of builder
+    void compile( TexPatternTrieBuilder & builder );
     virtual lUInt32 getHash() { return _hash; }
 };
 
@@ -335,73 +507,16 @@ class TexPattern {
 public:
     lChar16 word[MAX_PATTERN_SIZE];
     char attr[MAX_PATTERN_SIZE+1];
-    TexPattern * next;
-
-    int cmp( TexPattern * v )
-    {
-        return lStr_cmp( word, v->word );
-    }
-
-    static int hash( const lChar16 * s )
-    {
-        return (((s[0] *31 + s[1])*31 + s[2]) * 31 + s[3]) % PATTERN_HASH_SIZE;
-    }
-
-    static int hash3( const lChar16 * s )
-    {
-        return (((s[0] *31 + s[1])*31 + s[2]) * 31 + 0) % PATTERN_HASH_SIZE;
-    }
-
-    static int hash2( const lChar16 * s )
-    {
-        return (((s[0] *31 + s[1])*31 + 0) * 31 + 0) % PATTERN_HASH_SIZE;
-    }
-
-    static int hash1( const lChar16 * s )
-    {
-        return (((s[0] *31 + 0)*31 + 0) * 31 + 0) % PATTERN_HASH_SIZE;
-    }
 
-    int hash()
+    static void apply( const char * attr, char * mask )
     {
-        return (((word[0] *31 + word[1])*31 + word[2]) * 31 + word[3]) % PATTERN_HASH_SIZE;
-    }
-
-    bool match( const lChar16 * s, char * mask )
-    {
-        TexPattern * p = this;
-        bool found = false;
-        while ( p ) {
-            bool res = true;
-            for ( int i=2; p->word[i]; i++ )
-                if ( p->word[i]!=s[i] ) {
-                    res = false;
-                    break;
-                }
-            if ( res ) {
-                if ( p->word[0]==s[0] && (p->word[1]==0 || p->word[1]==s[1]) ) {
-#if DUMP_PATTERNS==1
-                    CRLog::debug("Pattern matched: %s %s on %s %s", LCSTR(lString16(p->word)), p->attr, LCSTR(lString16(s)), mask);
-#endif
-                    p->apply(mask);
-                    found = true;
-                }
-            }
-            p = p->next;
-        }
-        return found;
-    }
-
-    void apply( char * mask )
-    {
-        ;
-        for ( char * p = attr; *p && *mask; p++, mask++ ) {
+        for ( const char * p = attr; *p && *mask; p++, mask++ ) {
             if ( *mask < *p )
                 *mask = *p;
         }
     }
 
-    TexPattern( const lString16 &s ) : next( NULL )
+    TexPattern( const lString16 &s )
     {
         memset( word, 0, sizeof(word) );
         memset( attr, 0, sizeof(attr) );
@@ -428,6 +543,57 @@ public:
     }
 };
 
+/// collects patterns into trie while dictionary is being loaded
+class TexPatternTrieBuilder
+{
+public:
+    struct Node {
+        lChar16 ch;
+        bool terminal;
+        char attr[MAX_PATTERN_SIZE+2];
+        LVArray<int> children;
+        Node( lChar16 c ) : ch(c), terminal(false) { memset( attr, 0, sizeof(attr) ); }
+    };
+    LVPtrVector<Node> nodes;
+    int attrsSize;
+    int patternCount;
+
+    TexPatternTrieBuilder() : attrsSize(0), patternCount(0) { nodes.add( new Node(0) ); }
+
+    int getChild( int index, lChar16 ch )
+    {
+        LVArray<int> & children = nodes[index]->children;
+        for ( int i=0; i<children.length(); i++ )
+            if ( nodes[children[i]]->ch == ch )
+                return children[i];
+        nodes.add( new Node(ch) );
+        children.add( nodes.length() - 1 );
+        return nodes.length() - 1;
+    }
+
+    /// add pattern to trie, takes ownership of pattern
+    void add( TexPattern * pattern )
+    {
+#if DUMP_PATTERNS==1
+        CRLog::debug("Pattern: '%s' - %s", LCSTR(lString16(pattern->word, MAX_PATTERN_SIZE)), pattern->attr);
+#endif
+        int index = 0;
+        for ( int i=0; i<MAX_PATTERN_SIZE && pattern->word[i]; i++ )
+            index = getChild( index, pattern->word[i] );
+        Node * node = nodes[index];
+        if ( !node->terminal ) {
+            node->terminal = true;
+            attrsSize += MAX_PATTERN_SIZE + 2;
+        }
+        // digits are applied up to first zero, same pattern text may come several times
+        for ( int i=0; i<MAX_PATTERN_SIZE+1 && pattern->attr[i]; i++ )
+            if ( node->attr[i] < pattern->attr[i] )
+                node->attr[i] = pattern->attr[i];
+        patternCount++;
+        delete pattern;
+    }
+};
+
 class HyphPatternReader : public LVXMLParserCallback
 {
 protected:
@@ -471,37 +637,83 @@ public:
 };
 
 TexHyph::TexHyph()
+: _trie(NULL), _trieSize(0), _attrs(NULL), _cache( HYPH_WORD_CACHE_SIZE )
 {
-    memset( table, 0, sizeof(table) );
     _hash = 123456;
 }
 
 TexHyph::~TexHyph()
 {
-    for ( int i=0; i<PATTERN_HASH_SIZE; i++ ) {
-        TexPattern * p = table[i];
-        while (p) {
-            TexPattern * tmp = p;
-            p = p->next;
-            delete tmp;
+    if ( _trie )
+        delete[] _trie;
+    if ( _attrs )
+        delete[] _attrs;
+}
+
+void TexHyph::compile( TexPatternTrieBuilder & builder )
+{
+    if ( _trie )
+        delete[] _trie;
+    if ( _attrs )
+        delete[] _attrs;
+    _trieSize = builder.nodes.length();
+    _trie = new TexPatternTrieNode[ _trieSize ];
+    _attrs = new char[ builder.attrsSize + 1 ];
+    int attrsPos = 0;
+    // breadth first order: children of each node get contiguous range
+    LVArray<int> order;
+    order.add( 0 );
+    int next = 1;
+    for ( int i=0; i<order.length(); i++ ) {
+        TexPatternTrieBuilder::Node * src = builder.nodes[ order[i] ];
+        TexPatternTrieNode & dst = _trie[i];
+        dst.ch = src->ch;
+        dst.count = (lUInt16)src->children.length();
+        dst.first = next;
+        dst.attr = -1;
+        if ( src->terminal && src->attr[0] ) {
+            dst.attr = attrsPos;
+            int n = strlen( src->attr );
+            memcpy( _attrs + attrsPos, src->attr, n + 1 );
+            attrsPos += n + 1;
         }
+        // sort children by char for binary search
+        LVArray<int> & children = src->children;
+        for ( int j=1; j<children.length(); j++ ) {
+            int v = children[j];
+            int k = j;
+            for ( ; k>0 && builder.nodes[children[k-1]]->ch > builder.nodes[v]->ch; k-- )
+                children[k] = children[k-1];
+            children[k] = v;
+        }
+        for ( int j=0; j<children.length(); j++ )
+            order.add( children[j] );
+        next += children.length();
     }
+    _cache.clear();
 }
 
-void TexHyph::addPattern( TexPattern * pattern )
+inline int TexHyph::findChild( const TexPatternTrieNode & node, lChar16 ch ) const
 {
-    int h = pattern->hash();
-    TexPattern * * p = &table[h];
-    while ( *p && pattern->cmp(*p)<0 )
-        p = &((*p)->next);
-    pattern->next = *p;
-    *p = pattern;
+    int a = node.first;
+    int b = node.first + node.count;
+    while ( a < b ) {
+        int c = (a + b) >> 1;
+        lChar16 cc = _trie[c].ch;
+        if ( cc == ch )
+            return c;
+        if ( cc < ch )
+            a = c + 1;
+        else
+            b = c;
+    }
+    return -1;
 }
 
 bool TexHyph::load( LVStreamRef stream )
 {
     int w = isCorrectHyphFile(stream.get());
-    int patternCount = 0;
+    TexPatternTrieBuilder builder;
     if (w) {
         _hash = stream->crc32();
         int        i;
@@ -541,12 +753,7 @@ bool TexHyph::load( LVStreamRef stream )
                 pat[1] = hyph.mask0[0];
                 pat[2] = hyph.mask0[1];
                 pat[3] = 0;
-                TexPattern * pattern = new TexPattern(pat, 1, charMap);
-#if DUMP_PATTERNS==1
-                CRLog::debug("Pattern: '%s' - %s", LCSTR(lString16(pattern->word)), pattern->attr );
-#endif
-                addPattern( pattern );
-                patternCount++;
+                builder.add( new TexPattern(pat, 1, charMap) );
             }
         }
 
@@ -570,17 +777,10 @@ bool TexHyph::load( LVStreamRef stream )
                 lUInt8 sz = *p++;
                 if ( p + sz > end_p )
                     break;
-                TexPattern * pattern = new TexPattern( p, sz, charMap );
-#if DUMP_PATTERNS==1
-                CRLog::debug("Pattern: '%s' - %s", LCSTR(lString16(pattern->word)), pattern->attr);
-#endif
-                addPattern( pattern );
-                patternCount++;
+                builder.add( new TexPattern( p, sz, charMap ) );
                 p += sz + sz + 1;
             }
         }
-
-        return patternCount>0;
     } else {
         // tex xml format as for FBReader
         lString16Collection data;
@@ -592,16 +792,13 @@ bool TexHyph::load( LVStreamRef stream )
             return false;
         if ( !data.length() )
             return false;
-        for ( int i=0; i<(int)data.length(); i++ ) {
-            TexPattern * pattern = new TexPattern( data[i] );
-#if DUMP_PATTERNS==1
-            CRLog::debug("Pattern: '%s' - %s", LCSTR(lString16(pattern->word)), pattern->attr);
-#endif
-            addPattern( pattern );
-            patternCount++;
-        }
-        return patternCount>0;
+        for ( int i=0; i<(int)data.length(); i++ )
+            builder.add( new TexPattern( data[i] ) );
     }
+    if ( !builder.patternCount )
+        return false;
+    compile( builder );
+    return true;
 }
 
 bool TexHyph::load( lString16 fileName )
@@ -615,22 +812,22 @@ bool TexHyph::load( lString16 fileName )
 
 bool TexHyph::match( const lChar16 * str, char * mask )
 {
+    if ( !_trie )
+        return false;
     bool found = false;
-    TexPattern * res = table[ TexPattern::hash( str ) ];
-    if ( res ) {
-        found = res->match( str, mask ) || found;
-    }
-    res = table[ TexPattern::hash3( str ) ];
-    if ( res ) {
-        found = res->match( str, mask ) || found;
-    }
-    res = table[ TexPattern::hash2( str ) ];
-    if ( res ) {
-        found = res->match( str, mask ) || found;
-    }
-    res = table[ TexPattern::hash1( str ) ];
-    if ( res ) {
-        found = res->match( str, mask ) || found;
+    int index = 0;
+    // every pattern which is prefix of str is applied
+    for ( int i=0; str[i]; i++ ) {
+        index = findChild( _trie[index], str[i] );
+        if ( index<0 )
+            break;
+        if ( _trie[index].attr>=0 ) {
+#if DUMP_PATTERNS==1
+            CRLog::debug("Pattern matched: %s %s on %s %s", LCSTR(lString16(str, i+1)), _attrs + _trie[index].attr, LCSTR(lString16(str)), mask);
+#endif
+            TexPattern::apply( _attrs + _trie[index].attr, mask );
+            found = true;
+        }
     }
     return found;
 }
@@ -659,7 +856,7 @@ bool TexHyph::hyphenate( const lChar16 * str, int len, lUInt16 * widths, lUInt8
 {
     if ( len<=3 )
         return false;
-    if ( len>WORD_LENGTH )
+    if ( len>WORD_LENGTH - 2 )
         len = WORD_LENGTH - 2;
     lChar16 word[WORD_LENGTH+3];
     char mask[WORD_LENGTH+3];
@@ -670,11 +867,20 @@ bool TexHyph::hyphenate( const lChar16 * str, int len, lUInt16 * widths, lUInt8
     word[len+2] = 0;
     word[len+3] = 0;
     word[len+4] = 0;
-    memset( mask, '0', len+3 );
-    mask[len+3] = 0;
     bool found = false;
-    for ( int i=0; i<len; i++ ) {
-        found = match( word + i, mask + i ) || found;
+    bool cacheHit;
+    {
+        LVLock lock( _cacheMutex );
+        cacheHit = _cache.get( word+1, len, mask, found );
+    }
+    if ( !cacheHit ) {
+        memset( mask, '0', len+3 );
+        mask[len+3] = 0;
+        for ( int i=0; i<len; i++ ) {
+            found = match( word + i, mask + i ) || found;
+        }
+        LVLock lock( _cacheMutex );
+        _cache.put( word+1, len, mask, found );
     }
     if ( !found )
         return false;
@@ -98,6 +98,77 @@ static css_font_family_t DEFAULT_FONT_FAMILY = css_ff_sans_serif;
 
 static int def_font_sizes[] = { 18, 20, 22, 24, 29, 33, 39, 44 };
 
+#if CR_ENABLE_PAGE_IMAGE_CACHE==1
+/// background page image renderer: processes requests one by one, waits for new ones when queue is empty
+class LVDocViewRenderThread : public LVThread {
+	struct Request {
+		int offset;
+		int page;
+		int generation;
+		Request() : offset(-1), page(-1), generation(0) { }
+		Request( int o, int p, int g ) : offset(o), page(p), generation(g) { }
+	};
+	LVDocView * _view;
+	LVMutex _queueMutex;
+	LVEvent _event;
+	LVArray<Request> _queue;
+	bool _stopRequested;
+public:
+	LVDocViewRenderThread( LVDocView * view )
+	: _view(view), _stopRequested(false)
+	{
+	}
+	/// add request to queue; if clearQueue is true, pending requests are cancelled
+	void post( int offset, int page, int generation, bool clearQueue )
+	{
+		{
+			LVLock lock( _queueMutex );
+			if ( clearQueue )
+				_queue.clear();
+			_queue.add( Request( offset, page, generation ) );
+		}
+		_event.set();
+	}
+	/// cancel pending requests
+	void cancel()
+	{
+		LVLock lock( _queueMutex );
+		_queue.clear();
+	}
+	/// cancel pending requests and wait until thread is finished
+	void stop()
+	{
+		{
+			LVLock lock( _queueMutex );
+			_stopRequested = true;
+			_queue.clear();
+		}
+		_event.set();
+		join();
+	}
+	virtual void run()
+	{
+		for (;;) {
+			Request request;
+			bool found = false;
+			{
+				LVLock lock( _queueMutex );
+				if ( _stopRequested )
+					break;
+				if ( _queue.length() > 0 ) {
+					request = _queue.remove( 0 );
+					found = true;
+				}
+			}
+			if ( found )
+				_view->prerenderPageImage( request.offset, request.page, request.generation );
+			else
+				_event.wait();
+		}
+	}
+};
+#endif
+
 LVDocView::LVDocView(int bitsPerPixel) :
 	m_bitsPerPixel(bitsPerPixel), m_dx(400), m_dy(200), _pos(0), _page(0),
 			_posIsSet(false), m_battery_state(CR_BATTERY_STATE_NO_BATTERY)
@@ -136,7 +207,13 @@ LVDocView::LVDocView(int bitsPerPixel) :
 #if CR_INTERNAL_PAGE_ORIENTATION==1
 			, m_rotateAngle(CR_ROTATE_ANGLE_0)
 #endif
-			, m_section_bounds_valid(false), m_doc_format(doc_format_none),
+			, m_section_bounds_valid(false)
+			, m_toc_pages_valid(false)
+#if CR_ENABLE_PAGE_IMAGE_CACHE==1
+			, m_imageCache(_mutex), m_renderThread(NULL), m_lastImagePage(-1)
+			, m_lastImageOffset(-1), m_pageImageDirection(1)
+#endif
+			, m_doc_format(doc_format_none),
 			m_callback(NULL), m_swapDone(false), m_drawBufferBits(
 					GRAY_BACKBUFFER_BITS) {
 #if (COLOR_BACKBUFFER==1)
@@ -173,6 +250,13 @@ LVDocView::LVDocView(int bitsPerPixel) :
 }
 
 LVDocView::~LVDocView() {
+#if CR_ENABLE_PAGE_IMAGE_CACHE==1
+	if ( m_renderThread ) {
+		m_renderThread->stop();
+		delete m_renderThread;
+		m_renderThread = NULL;
+	}
+#endif
 	Clear();
 }
 
@@ -410,6 +494,7 @@ void LVDocView::Clear() {
 		m_cursorPos.clear();
 		m_filename.clear();
 		m_section_bounds_valid = false;
+		m_toc_pages_valid = false;
 	}
 	clearImageCache();
 	_navigationHistory.clear();
@@ -421,6 +506,7 @@ void LVDocView::clearImageCache() {
 	m_imageCache.clear();
 #endif
     m_section_bounds_valid = false;
+    m_toc_pages_valid = false;
 	if (m_callback != NULL)
 		m_callback->OnImageCacheClear();
 }
@@ -470,6 +556,129 @@ void LVDocView::checkPos() {
 }
 
 #if CR_ENABLE_PAGE_IMAGE_CACHE==1
+LVDocViewImageCache::LVDocViewImageCache( LVMutex & mutex )
+: _mutex(mutex), _maxSize(PAGE_IMAGE_CACHE_SIZE), _accessCounter(0), _generation(0)
+{
+}
+
+LVDocViewImageCache::~LVDocViewImageCache()
+{
+	clear();
+}
+
+/// returns index of page image item, -1 if not found
+int LVDocViewImageCache::find( int offset, int page )
+{
+	for ( int i=0; i<_items.length(); i++ )
+		if ( _items[i]->matches( offset, page ) )
+			return i;
+	return -1;
+}
+
+/// returns memory used by page images, bytes
+int LVDocViewImageCache::getSize()
+{
+	LVLock lock( _mutex );
+	int sz = 0;
+	for ( int i=0; i<_items.length(); i++ )
+		sz += _items[i]->getSize();
+	return sz;
+}
+
+/// removes least recently used images until memory limit is satisfied (keeps specified page and at least two pages)
+void LVDocViewImageCache::removeExtraItems( int keepOffset, int keepPage )
+{
+	int sz = getSize();
+	while ( sz > _maxSize && _items.length() > 2 ) {
+		int oldest = -1;
+		for ( int i=0; i<_items.length(); i++ ) {
+			if ( _items[i]->matches( keepOffset, keepPage ) )
+				continue;
+			if ( oldest<0 || _items[i]->_lastAccess < _items[oldest]->_lastAccess )
+				oldest = i;
+		}
+		if ( oldest<0 )
+			break;
+		sz -= _items[oldest]->getSize();
+		delete _items.remove( oldest );
+	}
+}
+
+/// put page image to cache, removes least recently used pages if memory limit is exceeded
+void LVDocViewImageCache::set( int offset, int page, LVRef<LVDrawBuf> drawbuf )
+{
+	LVLock lock( _mutex );
+	int index = find( offset, page );
+	Item * item;
+	if ( index>=0 ) {
+		item = _items[index];
+	} else {
+		item = new Item();
+		_items.add( item );
+	}
+	item->_drawbuf = drawbuf;
+	item->_offset = offset;
+	item->_page = page;
+	item->_lastAccess = ++_accessCounter;
+	removeExtraItems( offset, page );
+}
+
+/// return page image, keeping mutex locked until returned reference is destroyed; NULL if not found
+LVDocImageRef LVDocViewImageCache::get( int offset, int page )
+{
+	_mutex.lock();
+	int index = find( offset, page );
+	if ( index<0 ) {
+		_mutex.unlock();
+		return LVDocImageRef( NULL );
+	}
+	_items[index]->_lastAccess = ++_accessCounter;
+	// holder unlocks mutex on destroy
+	return LVDocImageRef( new LVDocImageHolder( _items[index]->_drawbuf, _mutex ) );
+}
+
+/// returns true if page image is in cache
+bool LVDocViewImageCache::has( int offset, int page )
+{
+	LVLock lock( _mutex );
+	return find( offset, page ) >= 0;
+}
+
+/// remove all page images
+void LVDocViewImageCache::clear()
+{
+	LVLock lock( _mutex );
+	_items.clear();
+	_generation++;
+}
+
+/// set memory limit, bytes
+void LVDocViewImageCache::setMaxSize( int maxSize )
+{
+	LVLock lock( _mutex );
+	_maxSize = maxSize;
+	removeExtraItems( -1, -1 );
+}
+
+/// returns offset and page to draw for current page + delta, false if out of document
+bool LVDocView::getPageImagePosition( int delta, int & offset, int & page )
+{
+	offset = -1;
+	page = -1;
+	if ( isPageMode() ) {
+		page = _page + delta * getVisiblePageCount();
+		return page>=0 && page<m_pages.length();
+	}
+	if ( delta<-1 || delta>1 )
+		return false; // only adjacent pages are known in scroll mode
+	offset = _pos;
+	if ( delta<0 )
+		offset = getPrevPageOffset();
+	else if ( delta>0 )
+		offset = getNextPageOffset();
+	return true;
+}
+
 /// returns true if current page image is ready
 bool LVDocView::IsDrawed()
 {
@@ -480,89 +689,106 @@ bool LVDocView::IsDrawed()
 bool LVDocView::isPageImageReady( int delta )
 {
 	if ( !m_is_rendered || !_posIsSet )
-	return false;
-	LVDocImageRef ref;
-	if ( isPageMode() ) {
-		int p = _page;
-		if ( delta<0 )
-		p--;
-		else if ( delta>0 )
-		p++;
-		//CRLog::trace("getPageImage: checking cache for page [%d] (delta=%d)", offset, delta);
-		ref = m_imageCache.get( -1, p );
+		return false;
+	int offset, p;
+	if ( !getPageImagePosition( delta, offset, p ) )
+		return false;
+	return m_imageCache.has( offset, p );
+}
+
+/// create buffer and draw page image into it
+LVRef<LVDrawBuf> LVDocView::createPageImage( int offset, int page )
+{
+	LVLock lock( getMutex() );
+	LVDrawBuf * buf = NULL;
+	if ( m_bitsPerPixel==-1 ) {
+#if (COLOR_BACKBUFFER==1)
+        buf = new LVColorDrawBuf( m_dx, m_dy, DEF_COLOR_BUFFER_BPP );
+#else
+		buf = new LVGrayDrawBuf( m_dx, m_dy, m_drawBufferBits );
+#endif
 	} else {
-		int offset = _pos;
-		if ( delta<0 )
-		offset = getPrevPageOffset();
-		else if ( delta>0 )
-		offset = getNextPageOffset();
-		//CRLog::trace("getPageImage: checking cache for page [%d] (delta=%d)", offset, delta);
-		ref = m_imageCache.get( offset, -1 );
+        if ( m_bitsPerPixel==32 || m_bitsPerPixel==16 ) {
+            buf = new LVColorDrawBuf( m_dx, m_dy, m_bitsPerPixel );
+		} else {
+			buf = new LVGrayDrawBuf( m_dx, m_dy, m_bitsPerPixel );
+		}
+	}
+	LVRef<LVDrawBuf> drawbuf( buf );
+	Draw( *drawbuf, offset, page, true );
+	return drawbuf;
+}
+
+/// draw page image in background thread, unless it's already cached or cache is reset since request
+void LVDocView::prerenderPageImage( int offset, int page, int generation )
+{
+	LVLock lock( getMutex() );
+	if ( generation != m_imageCache.getGeneration() || !m_is_rendered )
+		return; // outdated request
+	if ( (page>=0 && page>=m_pages.length()) || m_imageCache.has( offset, page ) )
+		return;
+	m_imageCache.set( offset, page, createPageImage( offset, page ) );
+}
+
+/// schedule background rendering of pages around current one, in reading direction
+void LVDocView::prefetchPageImages()
+{
+#if (CR_USE_THREADS==1)
+	if ( !m_is_rendered || !_posIsSet )
+		return;
+	// next two pages in reading direction, then one page back
+	int deltas[3] = { m_pageImageDirection, m_pageImageDirection * 2, -m_pageImageDirection };
+	bool first = true;
+	for ( int i=0; i<3; i++ ) {
+		int offset, p;
+		if ( !getPageImagePosition( deltas[i], offset, p ) || m_imageCache.has( offset, p ) )
+			continue;
+		if ( !m_renderThread ) {
+			m_renderThread = new LVDocViewRenderThread( this );
+			m_renderThread->start();
+		}
+		// requests for previous position are cancelled
+		m_renderThread->post( offset, p, m_imageCache.getGeneration(), first );
+		first = false;
 	}
-	return ( !ref.isNull() );
+	if ( first && m_renderThread )
+		m_renderThread->cancel();
+#endif
 }
 
 /// get page image
 LVDocImageRef LVDocView::getPageImage( int delta )
 {
 	checkPos();
-	// find existing object in cache
-	LVDocImageRef ref;
-	int p = -1;
-	int offset = -1;
-	if ( isPageMode() ) {
-		p = _page;
-		if ( delta<0 )
-		p--;
-		else if ( delta>0 )
-		p++;
-		if ( p<0 || p>=m_pages.length() )
-		return ref;
-		ref = m_imageCache.get( -1, p );
-		if ( !ref.isNull() ) {
-			//CRLog::trace("getPageImage: + page [%d] found in cache", offset);
-			return ref;
-		}
-	} else {
-		offset = _pos;
-		if ( delta<0 )
-		offset = getPrevPageOffset();
-		else if ( delta>0 )
-		offset = getNextPageOffset();
-		//CRLog::trace("getPageImage: checking cache for page [%d] (delta=%d)", offset, delta);
-		ref = m_imageCache.get( offset, -1 );
-		if ( !ref.isNull() ) {
-			//CRLog::trace("getPageImage: + page [%d] found in cache", offset);
-			return ref;
-		}
+	int offset, p;
+	if ( !getPageImagePosition( delta, offset, p ) )
+		return LVDocImageRef();
+	if ( delta==0 ) {
+		// detect reading direction
+		int last = isPageMode() ? m_lastImagePage : m_lastImageOffset;
+		int current = isPageMode() ? p : offset;
+		if ( last>=0 && current!=last )
+			m_pageImageDirection = current > last ? 1 : -1;
+		m_lastImagePage = p;
+		m_lastImageOffset = offset;
 	}
-	while ( ref.isNull() ) {
+	// find existing object in cache
+	LVDocImageRef ref = m_imageCache.get( offset, p );
+	if ( ref.isNull() ) {
 		//CRLog::trace("getPageImage: - page [%d] not found, force rendering", offset);
-		cachePageImage( delta );
+		m_imageCache.set( offset, p, createPageImage( offset, p ) );
 		ref = m_imageCache.get( offset, p );
 	}
-	//CRLog::trace("getPageImage: page [%d] is ready", offset);
+	if ( delta==0 )
+		prefetchPageImages();
 	return ref;
 }
 
-class LVDrawThread : public LVThread {
-	LVDocView * _view;
-	int _offset;
-	int _page;
-	LVRef<LVDrawBuf> _drawbuf;
-public:
-	LVDrawThread( LVDocView * view, int offset, int page, LVRef<LVDrawBuf> drawbuf )
-	: _view(view), _offset(offset), _page(page), _drawbuf(drawbuf)
-	{
-		start();
-	}
-	virtual void run()
-	{
-		//CRLog::trace("LVDrawThread::run() offset==%d", _offset);
-		_view->Draw( *_drawbuf, _offset, _page, true );
-		//_drawbuf->Rotate( _view->GetRotateAngle() );
-	}
-};
+/// set page image cache memory limit, bytes
+void LVDocView::setPageImageCacheSize( int bytes )
+{
+	m_imageCache.setMaxSize( bytes );
+}
 #endif
 
 /// draw current page to specified buffer
@@ -585,47 +811,23 @@ void LVDocView::Draw(LVDrawBuf & drawbuf) {
 /// cache page image (render in background if necessary)
 void LVDocView::cachePageImage( int delta )
 {
-	int offset = -1;
-	int p = -1;
-	if ( isPageMode() ) {
-		p = _page;
-		if ( delta<0 )
-		p--;
-		else if ( delta>0 )
-		p++;
-		if ( p<0 || p>=m_pages.length() )
+	int offset, p;
+	if ( !getPageImagePosition( delta, offset, p ) )
 		return;
-	} else {
-		offset = _pos;
-		if ( delta<0 )
-		offset = getPrevPageOffset();
-		else if ( delta>0 )
-		offset = getNextPageOffset();
-	}
 	//CRLog::trace("cachePageImage: request to cache page [%d] (delta=%d)", offset, delta);
 	if ( m_imageCache.has(offset, p) ) {
 		//CRLog::trace("cachePageImage: Page [%d] is found in cache", offset);
 		return;
 	}
-	//CRLog::trace("cachePageImage: starting new render task for page [%d]", offset);
-	LVDrawBuf * buf = NULL;
-	if ( m_bitsPerPixel==-1 ) {
-#if (COLOR_BACKBUFFER==1)
-        buf = new LVColorDrawBuf( m_dx, m_dy, DEF_COLOR_BUFFER_BPP );
+#if (CR_USE_THREADS==1)
+	if ( !m_renderThread ) {
+		m_renderThread = new LVDocViewRenderThread( this );
+		m_renderThread->start();
+	}
+	m_renderThread->post( offset, p, m_imageCache.getGeneration(), false );
 #else
-		buf = new LVGrayDrawBuf( m_dx, m_dy, m_drawBufferBits );
+	m_imageCache.set( offset, p, createPageImage( offset, p ) );
 #endif
-	} else {
-        if ( m_bitsPerPixel==32 || m_bitsPerPixel==16 ) {
-            buf = new LVColorDrawBuf( m_dx, m_dy, m_bitsPerPixel );
-		} else {
-			buf = new LVGrayDrawBuf( m_dx, m_dy, m_bitsPerPixel );
-		}
-	}
-	LVRef<LVDrawBuf> drawbuf( buf );
-	LVRef<LVThread> thread( new LVDrawThread( this, offset, p, drawbuf ) );
-	m_imageCache.set( offset, p, drawbuf, thread );
-	//CRLog::trace("cachePageImage: caching page [%d] is finished", offset);
 }
 #endif
 
@@ -652,7 +854,7 @@ void dumpSection(ldomNode * elem) {
 LVTocItem * LVDocView::getToc() {
 	if (!m_doc)
 		return NULL;
-	updatePageNumbers(m_doc->getToc());
+	updateTocPages();
 	return m_doc->getToc();
 }
 
@@ -733,11 +935,11 @@ int getSectionPage(ldomNode * section, LVRendPageList & pages) {
 
 /// update page numbers for items
 void LVDocView::updatePageNumbers(LVTocItem * item) {
-	if (!item->getXPointer().isNull()) {
-		lvPoint p = item->getXPointer().toPoint();
-		int y = p.y;
+	ldomXPointer ptr = item->getXPointer();
+	if (!ptr.isNull()) {
+		int y = ptr.toPoint().y;
 		int h = GetFullHeight();
-		int page = getBookmarkPage(item->_position);
+		int page = y >= 0 ? m_pages.FindNearestPage(y, 0) : 0;
 		if (page >= 0 && page < getPageCount())
 			item->_page = page;
 		else
@@ -757,6 +959,17 @@ void LVDocView::updatePageNumbers(LVTocItem * item) {
 	}
 }
 
+/// update page numbers of whole TOC, if not done since last render
+void LVDocView::updateTocPages() {
+	LVLock lock(getMutex());
+	checkRender();
+	if (m_toc_pages_valid || !m_doc)
+		return;
+	LVTocItem * toc = m_doc->getToc();
+	updatePageNumbers(toc);
+	m_toc_pages_valid = true;
+}
+
 /// returns cover page image stream, if any
 LVStreamRef LVDocView::getCoverPageImageStream() {
     lString16 fileName;
@@ -2306,6 +2519,35 @@ void LVDocView::setRenderProps(int dx, int dy) {
             + m_pageMargins.bottom * 4 : 0, m_font, m_def_interline_space, m_props);
 }
 
+/// passes formatting events to view callback; when pages around current position
+/// are formatted, marks view as rendered so that callback can draw them
+class LVDocViewFormatCallback : public LVDocViewCallback {
+	LVDocView * _view;
+	LVDocViewCallback * _callback;
+	bool _firstPagesShown;
+public:
+	LVDocViewFormatCallback( LVDocView * view, LVDocViewCallback * callback )
+	: _view(view), _callback(callback), _firstPagesShown(false)
+	{
+	}
+	bool isFirstPagesShown() { return _firstPagesShown; }
+	virtual void OnFormatStart() { _callback->OnFormatStart(); }
+	virtual void OnFormatEnd() { _callback->OnFormatEnd(); }
+	virtual void OnFormatProgress( int percent ) { _callback->OnFormatProgress( percent ); }
+	virtual void OnFormatPagesReady( int pageCount ) { _callback->OnFormatPagesReady( pageCount ); }
+	virtual void OnFormatFirstPagesReady( int page )
+	{
+		// drawing uses preliminary page list instead of starting another render
+		_view->m_is_rendered = true;
+		_view->_posIsSet = false;
+		_view->checkPos();
+		_view->clearImageCache();
+		_firstPagesShown = true;
+		_callback->OnFormatFirstPagesReady( page );
+	}
+	virtual void OnImageCacheClear() { _callback->OnImageCacheClear(); }
+};
+
 void LVDocView::Render(int dx, int dy, LVRendPageList * pages) {
 	LVLock lock(getMutex());
 	{
@@ -2329,10 +2571,22 @@ void LVDocView::Render(int dx, int dy, LVRendPageList * pages) {
 
 		CRLog::debug("Render(width=%d, height=%d, fontSize=%d)", dx, dy,
 				m_font_size);
+		LVDocViewCallback * callback = isDocumentOpened() ? m_callback : NULL;
+		// pages around current position may be drawn before whole document is formatted
+		LVDocViewFormatCallback formatCallback( this, callback );
+		if ( callback && pages == &m_pages )
+			callback = &formatCallback;
+		ldomXPointer bookmark = _posBookmark;
 		//CRLog::trace("calling render() for document %08X font=%08X", (unsigned int)m_doc, (unsigned int)m_font.get() );
-		m_doc->render(pages, isDocumentOpened() ? m_callback : NULL, dx, dy,
+		m_doc->render(pages, callback, dx, dy,
 				m_showCover, m_showCover ? dy + m_pageMargins.bottom * 4 : 0,
-                m_font, m_def_interline_space, m_props);
+                m_font, m_def_interline_space, m_props, bookmark.getNode());
+		if ( formatCallback.isFirstPagesShown() ) {
+			// drawing preliminary pages moved position to page start; restore it for final pages
+			_posBookmark = bookmark;
+			_posIsSet = false;
+			clearImageCache();
+		}
 
 #if 0
 		FILE * f = fopen("pagelist.log", "wt");
@@ -2346,6 +2600,7 @@ void LVDocView::Render(int dx, int dy, LVRendPageList * pages) {
 #endif
 		fontMan->gc();
 		m_is_rendered = true;
+		m_toc_pages_valid = false;
 		//CRLog::debug("Making TOC...");
 		//makeToc();
 		CRLog::debug("Updating selections...");
@@ -3749,6 +4004,7 @@ void LVDocView::createEmptyDocument() {
 
 	//m_doc ? m_doc->getDocFlags() : DOC_FLAG_DEFAULTS;
 	m_is_rendered = false;
+	m_toc_pages_valid = false;
 	if (m_doc)
 		delete m_doc;
 	m_doc = new ldomDocument();
@@ -5023,6 +5279,7 @@ void LVDocView::propsUpdateDefaults(CRPropRef props) {
 	props->setIntDef(PROP_FORCED_MIN_FILE_SIZE_TO_CACHE,
 			DOCUMENT_CACHING_MIN_SIZE); // 32K
 	props->setIntDef(PROP_PROGRESS_SHOW_FIRST_PAGE, 1);
+	props->setIntDef(PROP_PAGE_IMAGE_CACHE_SIZE, PAGE_IMAGE_CACHE_SIZE);
 
 	props->limitValueList(PROP_FONT_ANTIALIASING, def_aa_props,
 			sizeof(def_aa_props) / sizeof(int));
@@ -5350,6 +5607,11 @@ CRPropRef LVDocView::propsApply(CRPropRef props) {
                 m_highlightBookmarks = value;
                 updateBookMarksRanges();
             }
+#if CR_ENABLE_PAGE_IMAGE_CACHE==1
+        } else if (name == PROP_PAGE_IMAGE_CACHE_SIZE) {
+            int value = props->getIntDef(PROP_PAGE_IMAGE_CACHE_SIZE, PAGE_IMAGE_CACHE_SIZE);
+            setPageImageCacheSize(value);
+#endif
         } else if (name == PROP_PAGE_VIEW_MODE) {
 			LVDocViewMode m =
 					props->getIntDef(PROP_PAGE_VIEW_MODE, 1) ? DVM_PAGES
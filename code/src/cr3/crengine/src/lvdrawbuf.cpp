@@ -135,16 +135,14 @@ lUInt32 DitherNBitColor( lUInt32 color, lUInt32 x, lUInt32 y, int bits )
     return cl & mask;
 }
 
-lUInt32 Dither2BitColor( lUInt32 color, lUInt32 x, lUInt32 y )
+// 2bpp dither of color, d is dither matrix value for pixel position
+static inline lUInt32 dither2Bit( lUInt32 color, int d )
 {
     int cl = ((((color>>16) & 255) + ((color>>8) & 255) + ((color) & 255)) * (256/3)) >> 8;
     if (cl<5)
         return 0;
     else if (cl>=250)
         return 3;
-    //int d = dither_2bpp_4x4[(x&3) | ( (y&3) << 2 )] - 1;
-    int d = dither_2bpp_8x8[(x&7) | ( (y&7) << 3 )] - 1;
-
     cl = ( cl + d - 32 );
     if (cl<5)
         return 0;
@@ -153,16 +151,14 @@ lUInt32 Dither2BitColor( lUInt32 color, lUInt32 x, lUInt32 y )
     return (cl >> 6) & 3;
 }
 
-lUInt32 Dither1BitColor( lUInt32 color, lUInt32 x, lUInt32 y )
+// 1bpp dither of color, d is dither matrix value for pixel position
+static inline lUInt32 dither1Bit( lUInt32 color, int d )
 {
     int cl = ((((color>>16) & 255) + ((color>>8) & 255) + ((color) & 255)) * (256/3)) >> 8;
     if (cl<16)
         return 0;
     else if (cl>=240)
         return 1;
-    //int d = dither_2bpp_4x4[(x&3) | ( (y&3) << 2 )] - 1;
-    int d = dither_2bpp_8x8[(x&7) | ( (y&7) << 3 )] - 1;
-
     cl = ( cl + d - 32 );
     if (cl<5)
         return 0;
@@ -171,6 +167,18 @@ lUInt32 Dither1BitColor( lUInt32 color, lUInt32 x, lUInt32 y )
     return (cl >> 7) & 1;
 }
 
+lUInt32 Dither2BitColor( lUInt32 color, lUInt32 x, lUInt32 y )
+{
+    //int d = dither_2bpp_4x4[(x&3) | ( (y&3) << 2 )] - 1;
+    return dither2Bit( color, dither_2bpp_8x8[(x&7) | ( (y&7) << 3 )] - 1 );
+}
+
+lUInt32 Dither1BitColor( lUInt32 color, lUInt32 x, lUInt32 y )
+{
+    //int d = dither_2bpp_4x4[(x&3) | ( (y&3) << 2 )] - 1;
+    return dither1Bit( color, dither_2bpp_8x8[(x&7) | ( (y&7) << 3 )] - 1 );
+}
+
 static lUInt8 revByteBits1( lUInt8 b )
 {
     return ( (b&1)<<7 )
@@ -179,8 +187,8 @@ static lUInt8 revByteBits1( lUInt8 b )
         |  ( (b&8)<<1 )
         |  ( (b&16)>>1 )
         |  ( (b&32)>>3 )
-        |  ( (b&64)>>4 )
-        |  ( (b&128)>>5 );
+        |  ( (b&64)>>5 )
+        |  ( (b&128)>>7 );
 }
 
 lUInt8 revByteBits2( lUInt8 b )
@@ -191,6 +199,160 @@ lUInt8 revByteBits2( lUInt8 b )
         |  ( (b&0xC0)>>6 );
 }
 
+//=======================================================
+// packed 1 and 2 bpp pixel kernels
+//=======================================================
+
+/// lookup tables for packed 1 and 2 bpp pixels
+struct LVPackedPixelTables
+{
+    lUInt8 rev1[256]; ///< byte with 1bpp pixels in reverse order
+    lUInt8 rev2[256]; ///< byte with 2bpp pixels in reverse order
+    lUInt8 high2[256]; ///< high bits of four 2bpp pixels, as 4 low bits
+    lUInt8 dither2[2][256]; ///< four 2bpp pixels dithered to 1bpp, for even and odd rows
+    LVPackedPixelTables()
+    {
+        static const lUInt8 cmap[4][4] = {
+            { 0, 0, 0, 0},
+            { 0, 0, 1, 0},
+            { 0, 1, 0, 1},
+            { 1, 1, 1, 1},
+        };
+        for ( int b=0; b<256; b++ ) {
+            rev1[b] = revByteBits1( (lUInt8)b );
+            rev2[b] = revByteBits2( (lUInt8)b );
+            lUInt8 h = 0;
+            lUInt8 d0 = 0;
+            lUInt8 d1 = 0;
+            for ( int i=0; i<4; i++ ) {
+                int cl = (b >> (6-i*2)) & 3;
+                h = (lUInt8)((h << 1) | (cl >> 1));
+                // same mapping as per-pixel code had: cmap is applied twice
+                d0 = (lUInt8)((d0 << 1) | cmap[ cmap[cl][i&1] ][ i&1 ]);
+                d1 = (lUInt8)((d1 << 1) | cmap[ cmap[cl][(i&1) + 2] ][ (i&1) + 2 ]);
+            }
+            high2[b] = h;
+            dither2[0][b] = d0;
+            dither2[1][b] = d1;
+        }
+    }
+};
+
+static LVPackedPixelTables packedPixelTables;
+
+/// transposes 8x8 1bpp block: pixel j of dst[c] = pixel c of src[j]
+static inline void transpose1bpp( const lUInt8 * src, lUInt8 * dst )
+{
+    lUInt32 x = ((lUInt32)src[0] << 24) | ((lUInt32)src[1] << 16) | ((lUInt32)src[2] << 8) | src[3];
+    lUInt32 y = ((lUInt32)src[4] << 24) | ((lUInt32)src[5] << 16) | ((lUInt32)src[6] << 8) | src[7];
+    lUInt32 t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC;  x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;  y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+    dst[0] = (lUInt8)(x >> 24); dst[1] = (lUInt8)(x >> 16); dst[2] = (lUInt8)(x >> 8); dst[3] = (lUInt8)x;
+    dst[4] = (lUInt8)(y >> 24); dst[5] = (lUInt8)(y >> 16); dst[6] = (lUInt8)(y >> 8); dst[7] = (lUInt8)y;
+}
+
+/// transposes 4x4 2bpp block: pixel j of dst[c] = pixel c of src[j]
+static inline void transpose2bpp( const lUInt8 * src, lUInt8 * dst )
+{
+    lUInt32 x = ((lUInt32)src[0] << 24) | ((lUInt32)src[1] << 16) | ((lUInt32)src[2] << 8) | src[3];
+    lUInt32 t;
+    t = (x ^ (x >> 6)) & 0x00CC00CC;  x = x ^ t ^ (t << 6);
+    t = (x ^ (x >> 12)) & 0x0000F0F0;  x = x ^ t ^ (t << 12);
+    dst[0] = (lUInt8)(x >> 24); dst[1] = (lUInt8)(x >> 16); dst[2] = (lUInt8)(x >> 8); dst[3] = (lUInt8)x;
+}
+
+/// rotates packed 1 or 2 bpp image by 90 (cw==true) or 270 degrees, dst must be large enough for rotated image
+/**
+    Each destination byte is a column of 8 (1bpp) or 4 (2bpp) source pixels,
+    so image is processed by square blocks transposed with a few word operations.
+*/
+static void rotatePacked( const lUInt8 * src, int dx, int dy, int rowsize, lUInt8 * dst, int newrowsize, int bpp, bool cw )
+{
+    int ppb = 8 / bpp; // pixels per byte
+    const lUInt8 * rows[8];
+    lUInt8 in[8];
+    lUInt8 out[8];
+    for ( int k=0; k<newrowsize; k++ ) {
+        // source rows for destination pixels of k-th byte column: dst x = cw ? dy-1-y : y
+        for ( int j=0; j<ppb; j++ ) {
+            int dstx = k*ppb + j;
+            rows[j] = dstx<dy ? src + rowsize * (cw ? dy-1-dstx : dstx) : NULL;
+        }
+        for ( int xb=0; xb<rowsize; xb++ ) {
+            for ( int j=0; j<ppb; j++ )
+                in[j] = rows[j] ? rows[j][xb] : 0;
+            if ( bpp==1 )
+                transpose1bpp( in, out );
+            else
+                transpose2bpp( in, out );
+            // dst y = cw ? x : dx-1-x
+            int x = xb*ppb;
+            int n = dx - x < ppb ? dx - x : ppb;
+            if ( cw ) {
+                lUInt8 * p = dst + newrowsize * x + k;
+                for ( int c=0; c<n; c++, p+=newrowsize )
+                    *p = out[c];
+            } else {
+                lUInt8 * p = dst + newrowsize * (dx-1-x) + k;
+                for ( int c=0; c<n; c++, p-=newrowsize )
+                    *p = out[c];
+            }
+        }
+    }
+}
+
+/// rotates byte per pixel image by 90 (cw==true) or 270 degrees, processing by tiles to stay in cache
+static void rotateBytes( const lUInt8 * src, int dx, int dy, lUInt8 * dst, bool cw )
+{
+    const int TILE = 32;
+    for ( int y0=0; y0<dy; y0+=TILE ) {
+        int y1 = y0 + TILE < dy ? y0 + TILE : dy;
+        for ( int x0=0; x0<dx; x0+=TILE ) {
+            int x1 = x0 + TILE < dx ? x0 + TILE : dx;
+            for ( int y=y0; y<y1; y++ ) {
+                const lUInt8 * s = src + dx*y;
+                if ( cw ) {
+                    lUInt8 * d = dst + (dy-1-y);
+                    for ( int x=x0; x<x1; x++ )
+                        d[ dy*x ] = s[x];
+                } else {
+                    lUInt8 * d = dst + y;
+                    for ( int x=x0; x<x1; x++ )
+                        d[ dy*(dx-1-x) ] = s[x];
+                }
+            }
+        }
+    }
+}
+
+/// reverses order of bytes in buffer, replacing each byte using table (NULL for no replacement)
+static void reverseBytes( lUInt8 * data, int sz, const lUInt8 * table )
+{
+    lUInt8 * p = data;
+    lUInt8 * q = data + sz - 1;
+    if ( table ) {
+        for ( ; p<q; p++, q-- ) {
+            lUInt8 tmp = table[*p];
+            *p = table[*q];
+            *q = tmp;
+        }
+        if ( p==q )
+            *p = table[*p];
+    } else {
+        for ( ; p<q; p++, q-- ) {
+            lUInt8 tmp = *p;
+            *p = *q;
+            *q = tmp;
+        }
+    }
+}
+
 /// rotates buffer contents by specified angle
 void LVGrayDrawBuf::Rotate( cr_rotate_angle_t angle )
 {
@@ -198,57 +360,22 @@ void LVGrayDrawBuf::Rotate( cr_rotate_angle_t angle )
         return;
     int sz = (_rowsize * _dy);
     if ( angle==CR_ROTATE_ANGLE_180 ) {
-        if ( _bpp==DRAW_BUF_1_BPP ) {
-            for ( int i=sz/2-1; i>=0; i-- ) {
-                lUInt8 tmp = revByteBits1( _data[i] );
-                _data[i] = revByteBits1( _data[sz-i-1] );
-                _data[sz-i-1] = tmp;
-            }
-        } else if ( _bpp==DRAW_BUF_2_BPP ) {
-            for ( int i=sz/2-1; i>=0; i-- ) {
-                lUInt8 tmp = revByteBits2( _data[i] );
-                _data[i] = revByteBits2( _data[sz-i-1] );
-                _data[sz-i-1] = tmp;
-            }
-        } else { // DRAW_BUF_3_BPP, DRAW_BUF_4_BPP, DRAW_BUF_8_BPP
-            lUInt8 * buf = (lUInt8 *) _data;
-            for ( int i=sz/2-1; i>=0; i-- ) {
-                lUInt8 tmp = buf[i];
-                buf[i] = buf[sz-i-1];
-                buf[sz-i-1] = tmp;
-            }
-        }
+        if ( _bpp==DRAW_BUF_1_BPP )
+            reverseBytes( _data, sz, packedPixelTables.rev1 );
+        else if ( _bpp==DRAW_BUF_2_BPP )
+            reverseBytes( _data, sz, packedPixelTables.rev2 );
+        else // DRAW_BUF_3_BPP, DRAW_BUF_4_BPP, DRAW_BUF_8_BPP
+            reverseBytes( _data, sz, NULL );
         return;
     }
     int newrowsize = _bpp<=2 ? (_dy * _bpp + 7) / 8 : _dy;
     sz = (newrowsize * _dx);
     lUInt8 * dst = (lUInt8 *)malloc(sz);
-    memset( dst, 0, sz );
-    for ( int y=0; y<_dy; y++ ) {
-        lUInt8 * src = _data + _rowsize*y;
-        int dstx, dsty;
-        for ( int x=0; x<_dx; x++ ) {
-            if ( angle==CR_ROTATE_ANGLE_90 ) {
-                dstx = _dy-1-y;
-                dsty = x;
-            } else {
-                dstx = y;
-                dsty = _dx-1-x;
-            }
-            if ( _bpp==DRAW_BUF_1_BPP ) {
-                lUInt8 px = (src[ x >> 3 ] << (x&7)) & 0x80;
-                lUInt8 * dstrow = dst + newrowsize * dsty;
-                dstrow[ dstx >> 3 ] |= (px >> (dstx&7));
-            } else if (_bpp==DRAW_BUF_2_BPP ) {
-                lUInt8 px = (src[ x >> 2 ] << ((x&3)<<1)) & 0xC0;
-                lUInt8 * dstrow = dst + newrowsize * dsty;
-                dstrow[ dstx >> 2 ] |= (px >> ((dstx&3)<<1));
-            } else { // DRAW_BUF_3_BPP, DRAW_BUF_4_BPP, DRAW_BUF_8_BPP
-                lUInt8 * dstrow = dst + newrowsize * dsty;
-                dstrow[ dstx ] = src[ x ];
-            }
-        }
-    }
+    bool cw = angle==CR_ROTATE_ANGLE_90;
+    if ( _bpp<=2 )
+        rotatePacked( _data, _dx, _dy, _rowsize, dst, newrowsize, _bpp, cw );
+    else // DRAW_BUF_3_BPP, DRAW_BUF_4_BPP, DRAW_BUF_8_BPP
+        rotateBytes( _data, _dx, _dy, dst, cw );
     free( _data );
     _data = dst;
     int tmp = _dx;
@@ -509,6 +636,11 @@ public:
                 //fprintf( stderr, "." );
                 lUInt8 * row = (lUInt8 *)dst->GetScanLine( yy+dst_y );
                 //row += dst_x;
+                // dither matrix row for this line
+                const short * drow = dither_2bpp_8x8 + ((yy&7) << 3);
+                // pixels are collected in byte and stored once per 4 pixels
+                int curindex = -1;
+                lUInt8 cur = 0;
                 for (int x=0; x<dst_dx; x++)
                 {
                     lUInt32 cl = data[xmap ? xmap[x] : x];
@@ -520,9 +652,15 @@ public:
                     int byteindex = (xx >> 2);
                     int bitindex = (3-(xx & 3))<<1;
                     lUInt8 mask = 0xC0 >> (6 - bitindex);
+                    if ( byteindex!=curindex ) {
+                        if ( curindex>=0 )
+                            row[ curindex ] = cur;
+                        curindex = byteindex;
+                        cur = row[ byteindex ];
+                    }
 
                     if ( alpha ) {
-                        lUInt32 origColor = (row[ byteindex ] & mask)>>bitindex;
+                        lUInt32 origColor = (cur & mask)>>bitindex;
                         origColor = origColor | (origColor<<2);
                         origColor = origColor | (origColor<<4);
                         origColor = origColor | (origColor<<8) | (origColor<<16);
@@ -533,22 +671,29 @@ public:
                     lUInt32 dcl = 0;
                     if ( dither ) {
 #if (GRAY_INVERSE==1)
-                        dcl = Dither2BitColor( cl, x, yy ) ^ 3;
+                        dcl = dither2Bit( cl, drow[x&7] - 1 ) ^ 3;
 #else
-                        dcl = Dither2BitColor( cl, x, yy );
+                        dcl = dither2Bit( cl, drow[x&7] - 1 );
 #endif
                     } else {
                         dcl = rgbToGrayMask( cl, 2 ) & 3;
                     }
                     dcl = dcl << bitindex;
-                    row[ byteindex ] = (lUInt8)((row[ byteindex ] & (~mask)) | dcl);
+                    cur = (lUInt8)((cur & (~mask)) | dcl);
                 }
+                if ( curindex>=0 )
+                    row[ curindex ] = cur;
             }
             else if ( bpp == 1 )
             {
                 //fprintf( stderr, "." );
                 lUInt8 * row = (lUInt8 *)dst->GetScanLine( yy+dst_y );
                 //row += dst_x;
+                // dither matrix row for this line
+                const short * drow = dither_2bpp_8x8 + ((yy&7) << 3);
+                // pixels are collected in byte and stored once per 8 pixels
+                int curindex = -1;
+                lUInt8 cur = 0;
                 for (int x=0; x<dst_dx; x++)
                 {
                     lUInt32 cl = data[xmap ? xmap[x] : x];
@@ -559,9 +704,9 @@ public:
                     lUInt32 dcl = 0;
                     if ( dither ) {
 #if (GRAY_INVERSE==1)
-                        dcl = Dither1BitColor( cl, x, yy ) ^ 1;
+                        dcl = dither1Bit( cl, drow[x&7] - 1 ) ^ 1;
 #else
-                        dcl = Dither1BitColor( cl, x, yy ) ^ 0;
+                        dcl = dither1Bit( cl, drow[x&7] - 1 ) ^ 0;
 #endif
                     } else {
                         dcl = rgbToGrayMask( cl, 1 ) & 1;
@@ -569,9 +714,17 @@ public:
                     int byteindex = (xx >> 3);
                     int bitindex = ((xx & 7));
                     lUInt8 mask = 0x80 >> (bitindex);
+                    if ( byteindex!=curindex ) {
+                        if ( curindex>=0 )
+                            row[ curindex ] = cur;
+                        curindex = byteindex;
+                        cur = row[ byteindex ];
+                    }
                     dcl = dcl << (7-bitindex);
-                    row[ byteindex ] = (lUInt8)((row[ byteindex ] & (~mask)) | dcl);
+                    cur = (lUInt8)((cur & (~mask)) | dcl);
                 }
+                if ( curindex>=0 )
+                    row[ curindex ] = cur;
             }
             else
             {
@@ -606,6 +759,10 @@ void LVGrayDrawBuf::Draw( LVImageSourceRef img, int x, int y, int width, int hei
     //fprintf( stderr, "LVGrayDrawBuf::Draw( img(%d, %d), %d, %d, %d, %d\n", img->GetWidth(), img->GetHeight(), x, y, width, height );
     if ( width<=0 || height<=0 )
         return;
+    // use decoded copy if image was already drawn with the same size; 1 and 2 bpp dithering needs RGB
+    LVImageSourceRef cached = LVGetCachedScaledImage( img, width, height, _bpp > 2 );
+    if ( !cached.isNull() )
+        img = cached;
     LVImageScaledDrawCallback drawcb( this, img, x, y, width, height, dither );
     img->Decode( &drawcb );
 }
@@ -761,6 +918,26 @@ static const lUInt8 inverted_bytes[] = {
 #else
 #define GET_INVERTED_BYTE(x) ~(x)
 #endif
+
+/// inverts count bytes of 2bpp pixels, processing 4 bytes at once
+static void invertPixels2bpp( lUInt8 * dst, int count )
+{
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        lUInt32 w;
+        memcpy( &w, dst + i, 4 );
+#ifdef INVERT_PRSERVE_GRAYS
+        // only black and white pixels (both bits equal) are inverted
+        lUInt32 same = ~(w ^ (w >> 1)) & 0x55555555;
+        w ^= same | (same << 1);
+#else
+        w = ~w;
+#endif
+        memcpy( dst + i, &w, 4 );
+    }
+    for ( ; i < count; i++ )
+        dst[i] = GET_INVERTED_BYTE(dst[i]);
+}
 void LVGrayDrawBuf::InvertRect(int x0, int y0, int x1, int y1)
 {
     if (x0<_clip.left)
@@ -793,9 +970,7 @@ void LVGrayDrawBuf::InvertRect(int x0, int y0, int x1, int y1)
 				dst[0] = ((dst[0] & ~before) | (color & before));
 				dst++;
 			}
-			for (int x = 0; x < w; x++) {
-				dst[x] = GET_INVERTED_BYTE(dst[x]);
-			}
+			invertPixels2bpp( dst, w );
 			dst += w;
 			if (after) {
 				lUInt8 color = GET_INVERTED_BYTE(dst[0]);
@@ -1087,10 +1262,34 @@ void LVGrayDrawBuf::ConvertToBitmap(bool flgDither)
     if (_bpp==1)
         return;
     // TODO: implement for byte per pixel mode
-    int sz = GetRowSize();
+    int sz = ((_dx+7)/8) * _dy;
     lUInt8 * bitmap = (lUInt8*) malloc( sizeof(lUInt8) * sz );
     memset( bitmap, 0, sz );
-    if (flgDither)
+    if ( _bpp==2 )
+    {
+        // two source bytes give one destination byte
+        int fullBytes = _dx / 4;
+        for (int y=0; y<_dy; y++)
+        {
+            lUInt8 * src = GetScanLine(y);
+            lUInt8 * dst = bitmap + ((_dx+7)/8)*y;
+            const lUInt8 * table = flgDither ? packedPixelTables.dither2[y&1] : packedPixelTables.high2;
+            int i = 0;
+            for ( ; i + 1 < fullBytes; i += 2 )
+                dst[i>>1] = (lUInt8)((table[src[i]] << 4) | table[src[i+1]]);
+            int x = i * 4;
+            if ( i < fullBytes ) {
+                dst[i>>1] = (lUInt8)(table[src[i]] << 4);
+                x += 4;
+            }
+            // rest of pixels in last byte, padding bits are left 0
+            if ( x < _dx ) {
+                lUInt8 mask = (lUInt8)(0xFF << (4 - (_dx - x)));
+                dst[x>>3] |= (lUInt8)((table[src[x>>2]] & (mask & 0x0F)) << (4 - (x&4)));
+            }
+        }
+    }
+    else if (flgDither)
     {
         static const lUInt8 cmap[4][4] = {
             { 0, 0, 0, 0},
@@ -1147,6 +1346,10 @@ int  LVColorDrawBuf::GetBitsPerPixel()
 void LVColorDrawBuf::Draw( LVImageSourceRef img, int x, int y, int width, int height, bool dither )
 {
     //fprintf( stderr, "LVColorDrawBuf::Draw( img(%d, %d), %d, %d, %d, %d\n", img->GetWidth(), img->GetHeight(), x, y, width, height );
+    // use decoded copy if image was already drawn with the same size
+    LVImageSourceRef cached = LVGetCachedScaledImage( img, width, height, false );
+    if ( !cached.isNull() )
+        img = cached;
     LVImageScaledDrawCallback drawcb( this, img, x, y, width, height, dither );
     img->Decode( &drawcb );
 }
@@ -1523,71 +1726,43 @@ void LVGrayDrawBuf::DrawTo( LVDrawBuf * buf, int x, int y, int options, lUInt32
 	if ( buf->GetBitsPerPixel()!=GetBitsPerPixel() )
 		return; // not supported yet
     int bpp = buf->GetBitsPerPixel();
+    int ppb = bpp<=2 ? 8 / bpp : 1; // pixels per byte
+    // source bytes which first pixel is inside of clip rect: [first, last)
+    int first = clip.left - x > 0 ? (clip.left - x + ppb - 1) / ppb : 0;
+    int last = clip.right - x > 0 ? (clip.right - x + ppb - 1) / ppb : 0;
+    int srcBytes = bpp<=2 ? _rowsize : _dx;
+    if ( last > srcBytes )
+        last = srcBytes;
+    if ( first >= last )
+        return;
+    int dstRowSize = buf->GetRowSize();
     for (int yy=0; yy<_dy; yy++)
     {
         if (y+yy >= clip.top && y+yy < clip.bottom)
         {
             lUInt8 * src = (lUInt8 *)GetScanLine(yy);
-            if (bpp==1)
-            {
-                int shift = x & 7;
-                lUInt8 * dst = buf->GetScanLine(y+yy) + (x>>3);
-                for (int xx=0; xx<_dx; xx+=8)
-                {
-                    if ( x+xx >= clip.left && x+xx < clip.right )
-                    {
-                        //lUInt8 mask = ~((lUInt8)0xC0>>shift);
-                        lUInt16 cl = (*src << 8)>>shift;
-                        lUInt16 mask = (0xFF00)>>shift;
-						lUInt8 c = *dst;
-						c &= ~(mask>>8);
-						c |= (cl>>8);
-                        *dst = c;
-						c = *(dst+1);
-						c &= ~(mask&0xFF);
-						c |= (cl&0xFF);
-                        *(dst+1) = c;
-                    }    
-                    dst++;
-                    src++;
-                }
-            }
-            else if (bpp==2)
+            lUInt8 * dstRow = buf->GetScanLine(y+yy);
+            if ( bpp<=2 )
             {
-                int shift = (x & 3) * 2;
-                lUInt8 * dst = buf->GetScanLine(y+yy) + (x>>2);
-                for (int xx=0; xx<_dx; xx+=4)
-                {
-                    if ( x+xx >= clip.left && x+xx < clip.right )
-                    {
-                        //lUInt8 mask = ~((lUInt8)0xC0>>shift);
-                        lUInt16 cl = (*src << 8)>>shift;
-                        lUInt16 mask = (0xFF00)>>shift;
-						lUInt8 c = *dst;
-						c &= ~(mask>>8);
-						c |= (cl>>8);
-                        *dst = c;
-						c = *(dst+1);
-						c &= ~(mask&0xFF);
-						c |= (cl&0xFF);
-                        *(dst+1) = c;
-                    }    
-                    dst++;
-                    src++;
+                int shift = bpp==1 ? (x & 7) : (x & 3) * 2;
+                lUInt8 * dst = dstRow + (bpp==1 ? (x>>3) : (x>>2));
+                if ( !shift ) {
+                    memcpy( dst + first, src + first, last - first );
+                } else {
+                    // bytes are shifted right by shift bits: each destination byte
+                    // is made of tail of previous and head of current source byte
+                    lUInt8 lowMask = (lUInt8)(0xFF >> shift);
+                    dst[first] = (lUInt8)((dst[first] & ~lowMask) | (src[first] >> shift));
+                    for ( int i=first+1; i<last; i++ )
+                        dst[i] = (lUInt8)((src[i-1] << (8-shift)) | (src[i] >> shift));
+                    // tail of last source byte goes to next byte, if it's inside of destination row
+                    if ( dst + last < dstRow + dstRowSize )
+                        dst[last] = (lUInt8)((dst[last] & lowMask) | (src[last-1] << (8-shift)));
                 }
             }
             else
             {
-                lUInt8 * dst = buf->GetScanLine(y+yy) + x;
-                for (int xx=0; xx<_dx; xx++)
-                {
-                    if ( x+xx >= clip.left && x+xx < clip.right )
-                    {
-                        *dst = *src;
-                    }
-                    dst++;
-                    src++;
-                }
+                memcpy( dstRow + x + first, src + first, last - first );
             }
         }
     }
@@ -1840,3 +2015,181 @@ void LVColorDrawBuf::ConvertToBitmap(bool flgDither)
 {
 }
 
+
+#ifdef _DEBUG
+#include "../include/crtest.h"
+
+static void fillRandom( LVGrayDrawBuf & buf, lUInt32 seed )
+{
+    int sz = buf.GetRowSize() * buf.GetHeight();
+    lUInt8 * p = buf.GetScanLine(0);
+    for ( int i=0; i<sz; i++ ) {
+        seed = seed * 1103515245 + 12345;
+        p[i] = (lUInt8)(seed >> 16);
+    }
+}
+
+// per-pixel reference of DrawTo for packed pixels
+static void drawToReference( LVGrayDrawBuf & src, LVGrayDrawBuf & dst, int x, int y )
+{
+    lvRect clip;
+    dst.GetClipRect( &clip );
+    int bpp = src.GetBitsPerPixel();
+    int ppb = 8 / bpp;
+    for ( int yy=0; yy<src.GetHeight(); yy++ ) {
+        if ( y+yy < clip.top || y+yy >= clip.bottom )
+            continue;
+        for ( int xx=0; xx<src.GetRowSize()*ppb; xx++ ) {
+            int byteStart = x + (xx / ppb) * ppb;
+            int dx = x + xx;
+            if ( byteStart < clip.left || byteStart >= clip.right || dx < 0 || dx >= dst.GetRowSize()*ppb )
+                continue;
+            int v = (src.GetScanLine(yy)[xx/ppb] >> (8 - bpp - (xx%ppb)*bpp)) & ((1<<bpp)-1);
+            lUInt8 * p = dst.GetScanLine(y+yy) + dx/ppb;
+            int sh = 8 - bpp - (dx%ppb)*bpp;
+            *p = (lUInt8)((*p & ~(((1<<bpp)-1) << sh)) | (v << sh));
+        }
+    }
+}
+
+static void testDrawBufRotate( int bpp, int dx, int dy, cr_rotate_angle_t angle )
+{
+    LVGrayDrawBuf buf( dx, dy, bpp );
+    fillRandom( buf, dx * 31 + dy );
+    LVGrayDrawBuf orig( dx, dy, bpp );
+    memcpy( orig.GetScanLine(0), buf.GetScanLine(0), buf.GetRowSize() * dy );
+    buf.Rotate( angle );
+    if ( angle==CR_ROTATE_ANGLE_180 ) {
+        LVGrayDrawBuf back( dx, dy, bpp );
+        memcpy( back.GetScanLine(0), buf.GetScanLine(0), buf.GetRowSize() * dy );
+        back.Rotate( angle );
+        MYASSERT( !memcmp( back.GetScanLine(0), orig.GetScanLine(0), buf.GetRowSize() * dy ), "rotate 180 twice" );
+        return;
+    }
+    MYASSERT( buf.GetWidth()==dy && buf.GetHeight()==dx, "rotated size" );
+    for ( int y=0; y<dy; y++ )
+        for ( int x=0; x<dx; x++ ) {
+            lUInt32 v = angle==CR_ROTATE_ANGLE_90 ? buf.GetPixel( dy-1-y, x ) : buf.GetPixel( y, dx-1-x );
+            MYASSERT( v==orig.GetPixel( x, y ), "rotated pixel" );
+        }
+    if ( bpp<=2 && (dy*bpp)%8 ) {
+        // padding bits of rotated rows must be cleared
+        int ppb = 8 / bpp;
+        for ( int y=0; y<dx; y++ )
+            for ( int x=dy; x<buf.GetRowSize()*ppb; x++ )
+                MYASSERT( !((buf.GetScanLine(y)[x/ppb] >> (8 - bpp - (x%ppb)*bpp)) & ((1<<bpp)-1)), "rotated padding" );
+    }
+}
+
+static void testDrawBufKernels()
+{
+    CRLog::info("Starting LVGrayDrawBuf kernels unit test");
+    static const int sizes[][2] = { {1, 1}, {7, 3}, {8, 8}, {13, 21}, {37, 16}, {64, 9}, {61, 83} };
+    for ( int s=0; s<7; s++ ) {
+        int bpps[] = { 1, 2, 8 };
+        for ( int b=0; b<3; b++ ) {
+            testDrawBufRotate( bpps[b], sizes[s][0], sizes[s][1], CR_ROTATE_ANGLE_90 );
+            testDrawBufRotate( bpps[b], sizes[s][0], sizes[s][1], CR_ROTATE_ANGLE_270 );
+            testDrawBufRotate( bpps[b], sizes[s][0], sizes[s][1], CR_ROTATE_ANGLE_180 );
+        }
+    }
+    // DrawTo with arbitrary bit offset and clipping
+    for ( int bpp=1; bpp<=2; bpp++ ) {
+        for ( int x=-9; x<12; x++ ) {
+            LVGrayDrawBuf src( 37, 5, bpp );
+            fillRandom( src, x + 100 );
+            LVGrayDrawBuf dst( 64, 9, bpp );
+            LVGrayDrawBuf ref( 64, 9, bpp );
+            fillRandom( dst, 7 );
+            fillRandom( ref, 7 );
+            lvRect clip( 5, 1, 41, 8 );
+            dst.SetClipRect( &clip );
+            ref.SetClipRect( &clip );
+            src.DrawTo( &dst, x, 2, 0, NULL );
+            drawToReference( src, ref, x, 2 );
+            MYASSERT( !memcmp( dst.GetScanLine(0), ref.GetScanLine(0), dst.GetRowSize() * dst.GetHeight() ), "DrawTo" );
+        }
+    }
+    // InvertRect
+    for ( int x0=0; x0<9; x0++ ) {
+        LVGrayDrawBuf buf( 61, 4, 2 );
+        fillRandom( buf, x0 );
+        LVGrayDrawBuf ref( 61, 4, 2 );
+        memcpy( ref.GetScanLine(0), buf.GetScanLine(0), buf.GetRowSize() * 4 );
+        int x1 = 61 - x0 * 3;
+        buf.InvertRect( x0, 1, x1, 3 );
+        for ( int y=0; y<4; y++ )
+            for ( int x=0; x<61; x++ ) {
+                lUInt32 v = ref.GetPixel( x, y );
+                if ( y>=1 && y<3 && x>=x0 && x<x1 && (v==0 || v==3) )
+                    v ^= 3;
+                MYASSERT( buf.GetPixel( x, y )==v, "InvertRect" );
+            }
+    }
+    // ConvertToBitmap
+    for ( int dither=0; dither<2; dither++ ) {
+        for ( int dx=1; dx<20; dx++ ) {
+            LVGrayDrawBuf buf( dx, 3, 2 );
+            fillRandom( buf, dx );
+            LVGrayDrawBuf ref( dx, 3, 2 );
+            memcpy( ref.GetScanLine(0), buf.GetScanLine(0), buf.GetRowSize() * 3 );
+            buf.ConvertToBitmap( dither!=0 );
+            MYASSERT( buf.GetBitsPerPixel()==1 && buf.GetRowSize()==(dx+7)/8, "ConvertToBitmap format" );
+            for ( int y=0; y<3; y++ ) {
+                for ( int x=0; x<(dx+7)/8*8; x++ ) {
+                    lUInt32 v = 0;
+                    if ( x<dx ) {
+                        v = ref.GetPixel( x, y );
+                        v = dither ? ( (v&1) && !(x&1) && (y&1) ) : (v>>1);
+                    }
+                    MYASSERT( ((buf.GetScanLine(y)[x>>3] >> (7-(x&7))) & 1)==v, "ConvertToBitmap pixel" );
+                }
+            }
+        }
+    }
+}
+
+static void runDrawBufBenchmark()
+{
+    const int dx = 600;
+    const int dy = 800;
+    const int count = 100;
+    for ( int bpp=1; bpp<=2; bpp++ ) {
+        LVGrayDrawBuf buf( dx, dy, bpp );
+        fillRandom( buf, 1 );
+        CRTimerUtil timer;
+        for ( int i=0; i<count; i++ )
+            buf.Rotate( (i&1) ? CR_ROTATE_ANGLE_270 : CR_ROTATE_ANGLE_90 );
+        CRLog::info("LVGrayDrawBuf %dbpp %dx%d: Rotate 90/270 %d calls in %d ms", bpp, dx, dy, count, (int)timer.elapsed());
+        timer.restart();
+        for ( int i=0; i<count; i++ )
+            buf.Rotate( CR_ROTATE_ANGLE_180 );
+        CRLog::info("LVGrayDrawBuf %dbpp %dx%d: Rotate 180 %d calls in %d ms", bpp, dx, dy, count, (int)timer.elapsed());
+        LVGrayDrawBuf dst( dx + 8, dy, bpp );
+        lvRect clip( 0, 0, dx + 8, dy );
+        dst.SetClipRect( &clip );
+        timer.restart();
+        for ( int i=0; i<count; i++ )
+            buf.DrawTo( &dst, 3, 0, 0, NULL );
+        CRLog::info("LVGrayDrawBuf %dbpp %dx%d: DrawTo with bit offset %d calls in %d ms", bpp, dx, dy, count, (int)timer.elapsed());
+        if ( bpp==2 ) {
+            timer.restart();
+            for ( int i=0; i<count; i++ )
+                buf.InvertRect( 1, 0, dx - 1, dy );
+            CRLog::info("LVGrayDrawBuf %dbpp %dx%d: InvertRect %d calls in %d ms", bpp, dx, dy, count, (int)timer.elapsed());
+            timer.restart();
+            for ( int i=0; i<count; i++ ) {
+                LVGrayDrawBuf tmp( dx, dy, 2 );
+                tmp.ConvertToBitmap( (i&1)!=0 );
+            }
+            CRLog::info("LVGrayDrawBuf %dbpp %dx%d: ConvertToBitmap %d calls in %d ms", bpp, dx, dy, count, (int)timer.elapsed());
+        }
+    }
+}
+
+void testDrawBuf()
+{
+    testDrawBufKernels();
+    runDrawBufBenchmark();
+}
+#endif
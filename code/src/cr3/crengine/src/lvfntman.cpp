@@ -23,6 +23,7 @@
 #include "../include/lvdrawbuf.h"
 #include "../include/lvstyles.h"
 #include "../include/lvthread.h"
+#include "../include/lvhashtable.h"
 
 // define to filter out all fonts except .ttf
 //#define LOAD_TTF_FONTS_ONLY
@@ -65,6 +66,16 @@
 
 #define MAX_LINE_CHARS 2048
 
+#ifndef FONT_WIDTH_CACHE_MAX_KERNING_PAIRS
+/// max number of kerning pairs kept for one font instance in width cache
+#define FONT_WIDTH_CACHE_MAX_KERNING_PAIRS 0x2000
+#endif
+
+#ifndef FONT_WIDTH_CACHE_MAX_FILE_SIZE
+/// width cache file size above which records not used in current session are dropped on save
+#define FONT_WIDTH_CACHE_MAX_FILE_SIZE 0x100000
+#endif
+
 
 //DEFINE_NULL_REF( LVFont )
 
@@ -334,6 +345,7 @@ class LVFontGlyphWidthCache
 {
 private:
     lUInt8 * ptrs[128];
+    bool _changed;
 public:
     lUInt8 get( lChar16 ch )
     {
@@ -353,6 +365,7 @@ public:
             memset( ptr, 0xFF, sizeof(lUInt8) * 512 );
         }
         ptr[ ch & 0x1FF ] = w;
+        _changed = true;
     }
     void clear()
     {
@@ -361,8 +374,51 @@ public:
                 delete [] ptrs[i];
             ptrs[i] = NULL;
         }
+        _changed = false;
     }
-    LVFontGlyphWidthCache()
+    /// returns true if widths were added after last serialize/deserialize
+    bool isChanged() { return _changed; }
+    /// writes pages of known widths
+    void serialize( SerialBuf & buf )
+    {
+        lUInt8 count = 0;
+        for ( int i=0; i<128; i++ )
+            if ( ptrs[i] )
+                count++;
+        buf << count;
+        for ( int i=0; i<128; i++ ) {
+            if ( !ptrs[i] )
+                continue;
+            buf << (lUInt8)i;
+            for ( int j=0; j<512; j++ )
+                buf << ptrs[i][j];
+        }
+        _changed = false;
+    }
+    /// reads pages of known widths
+    bool deserialize( SerialBuf & buf )
+    {
+        clear();
+        lUInt8 count = 0;
+        buf >> count;
+        for ( int k=0; k<count && !buf.error(); k++ ) {
+            lUInt8 inx = 0;
+            buf >> inx;
+            if ( inx>=128 || ptrs[inx] || buf.space()<512 ) {
+                buf.seterror();
+                break;
+            }
+            lUInt8 * ptr = new lUInt8[512];
+            ptrs[inx] = ptr;
+            for ( int j=0; j<512; j++ )
+                buf >> ptr[j];
+        }
+        if ( buf.error() )
+            clear();
+        _changed = false;
+        return !buf.error();
+    }
+    LVFontGlyphWidthCache() : _changed(false)
     {
         memset( ptrs, 0, 128*sizeof(lUInt8*) );
     }
@@ -372,7 +428,290 @@ public:
     }
 };
 
+/// kerning values of glyph pairs used by font instance
+class LVFontKerningCache
+{
+private:
+    LVHashTable<lUInt32, lInt32> _pairs;
+    bool _changed;
+    static lUInt32 pairKey( lUInt32 left, lUInt32 right ) { return (left << 16) | right; }
+public:
+    /// gets kerning of glyph pair, returns false if pair is not cached
+    bool get( lUInt32 left, lUInt32 right, int & kerning )
+    {
+        if ( (left | right) > 0xFFFF )
+            return false;
+        lInt32 v;
+        if ( !_pairs.get( pairKey( left, right ), v ) )
+            return false;
+        kerning = v;
+        return true;
+    }
+    void put( lUInt32 left, lUInt32 right, int kerning )
+    {
+        if ( (left | right) > 0xFFFF || _pairs.length()>=FONT_WIDTH_CACHE_MAX_KERNING_PAIRS )
+            return;
+        if ( _pairs.length() >= _pairs.size() )
+            _pairs.resize( _pairs.size() * 2 );
+        _pairs.set( pairKey( left, right ), kerning );
+        _changed = true;
+    }
+    void clear()
+    {
+        _pairs.clear();
+        _changed = false;
+    }
+    /// returns true if pairs were added after last serialize/deserialize
+    bool isChanged() { return _changed; }
+    void serialize( SerialBuf & buf )
+    {
+        buf << (lUInt32)_pairs.length();
+        LVHashTable<lUInt32, lInt32>::iterator it = _pairs.forwardIterator();
+        for ( LVHashTable<lUInt32, lInt32>::pair * p = it.next(); p; p = it.next() )
+            buf << p->key << p->value;
+        _changed = false;
+    }
+    bool deserialize( SerialBuf & buf )
+    {
+        clear();
+        lUInt32 count = 0;
+        buf >> count;
+        if ( count>FONT_WIDTH_CACHE_MAX_KERNING_PAIRS || (int)count*8>buf.space() ) {
+            buf.seterror();
+            return false;
+        }
+        if ( (int)count > _pairs.size() )
+            _pairs.resize( count );
+        for ( lUInt32 i=0; i<count && !buf.error(); i++ ) {
+            lUInt32 key = 0;
+            lInt32 value = 0;
+            buf >> key >> value;
+            _pairs.set( key, value );
+        }
+        if ( buf.error() )
+            clear();
+        _changed = false;
+        return !buf.error();
+    }
+    LVFontKerningCache() : _pairs(256), _changed(false) { }
+};
+
 class LVFreeTypeFace;
+
+/// glyph widths and kerning pairs of font instances, kept in file between sessions
+/**
+    File contents are mapped read-only; records of font instances are
+    read from the mapping when font is loaded, and written back on save.
+*/
+class LVFontWidthCacheFile
+{
+private:
+    struct Record {
+        const lUInt8 * data; // record data inside mapping or in own buffer
+        int size;
+        lUInt8 * own; // buffer updated in current session, NULL if data is mapped
+        bool used; // record was requested or updated in current session
+        Record( const lUInt8 * d, int sz ) : data(d), size(sz), own(NULL), used(false) { }
+        ~Record() { if ( own ) free( own ); }
+    };
+    lString16 _fileName;
+    LVStreamBufferRef _mapBuf;
+    LVHashTable<lUInt32, Record *> _records;
+    LVArray<LVFreeTypeFace *> _faces;
+    bool _changed;
+
+    void clearRecords()
+    {
+        LVHashTable<lUInt32, Record *>::iterator it = _records.forwardIterator();
+        for ( LVHashTable<lUInt32, Record *>::pair * p = it.next(); p; p = it.next() )
+            delete p->value;
+        _records.clear();
+    }
+
+    /// maps file and indexes its records
+    bool load()
+    {
+        LVStreamRef stream = LVMapFileStream( _fileName.c_str(), LVOM_READ, 0 );
+        if ( stream.isNull() )
+            return false;
+        int size = (int)stream->GetSize();
+        _mapBuf = stream->GetReadBuffer( 0, size );
+        if ( _mapBuf.isNull() || !_mapBuf->getReadOnly() ) {
+            _mapBuf.Clear();
+            return false;
+        }
+        SerialBuf buf( _mapBuf->getReadOnly(), size );
+        if ( !buf.checkMagic( width_cache_magic ) ) {
+            _mapBuf.Clear();
+            return false;
+        }
+        lUInt32 count = 0;
+        buf >> count;
+        for ( lUInt32 i=0; i<count && !buf.error(); i++ ) {
+            lUInt32 key = 0;
+            lUInt32 sz = 0;
+            buf >> key >> sz;
+            if ( buf.error() || (int)sz>buf.space() ) {
+                buf.seterror();
+                break;
+            }
+            Record * rec = new Record( buf.buf() + buf.pos(), sz );
+            buf.setPos( buf.pos() + sz );
+            Record * old = NULL;
+            if ( _records.get( key, old ) )
+                delete old;
+            _records.set( key, rec );
+        }
+        buf.checkCRC( buf.pos() );
+        if ( buf.error() ) {
+            CRLog::error("Font width cache file %s is corrupted", LCSTR(_fileName));
+            clearRecords();
+            _mapBuf.Clear();
+            return false;
+        }
+        CRLog::debug("Font width cache: %d font instances loaded", _records.length());
+        return true;
+    }
+public:
+    static const char * width_cache_magic;
+
+    /// sets file name and loads its contents
+    bool open( lString16 fileName )
+    {
+        close();
+        _fileName = fileName;
+        if ( _fileName.empty() )
+            return false;
+        if ( !LVFileExists( _fileName ) )
+            return true;
+        load();
+        return true;
+    }
+
+    /// saves changes if any, and forgets file
+    void close()
+    {
+        save();
+        clearRecords();
+        _mapBuf.Clear();
+        _fileName.clear();
+        _changed = false;
+    }
+
+    /// registers font instance which keeps its widths in this file
+    void attach( LVFreeTypeFace * face ) { _faces.add( face ); }
+    /// unregisters font instance
+    void detach( LVFreeTypeFace * face )
+    {
+        for ( int i=0; i<_faces.length(); i++ )
+            if ( _faces[i]==face ) {
+                _faces.erase( i, 1 );
+                break;
+            }
+    }
+    /// returns font instances attached to file
+    LVArray<LVFreeTypeFace *> & getFaces() { return _faces; }
+
+    /// finds record of font instance, returns false if not found
+    bool find( lUInt32 key, const lUInt8 * & data, int & size )
+    {
+        Record * rec = NULL;
+        if ( !_records.get( key, rec ) )
+            return false;
+        rec->used = true;
+        data = rec->data;
+        size = rec->size;
+        return true;
+    }
+
+    /// replaces record of font instance
+    void update( lUInt32 key, SerialBuf & buf )
+    {
+        if ( _fileName.empty() )
+            return;
+        Record * rec = NULL;
+        if ( !_records.get( key, rec ) ) {
+            rec = new Record( NULL, 0 );
+            if ( _records.length() >= _records.size() )
+                _records.resize( _records.size() * 2 );
+            _records.set( key, rec );
+        }
+        if ( rec->own )
+            free( rec->own );
+        rec->own = (lUInt8 *)malloc( buf.pos() );
+        memcpy( rec->own, buf.buf(), buf.pos() );
+        rec->data = rec->own;
+        rec->size = buf.pos();
+        rec->used = true;
+        _changed = true;
+    }
+
+    /// writes all records to file
+    bool save()
+    {
+        if ( !_changed || _fileName.empty() )
+            return true;
+        int total = 0;
+        LVHashTable<lUInt32, Record *>::iterator it = _records.forwardIterator();
+        for ( LVHashTable<lUInt32, Record *>::pair * p = it.next(); p; p = it.next() )
+            total += p->value->size + 8;
+        bool dropUnused = total > FONT_WIDTH_CACHE_MAX_FILE_SIZE;
+        SerialBuf buf( total + 64, true );
+        buf.putMagic( width_cache_magic );
+        int countPos = buf.pos();
+        lUInt32 count = 0;
+        buf << count;
+        LVHashTable<lUInt32, Record *>::iterator it1 = _records.forwardIterator();
+        for ( LVHashTable<lUInt32, Record *>::pair * p = it1.next(); p; p = it1.next() ) {
+            Record * rec = p->value;
+            if ( dropUnused && !rec->used )
+                continue;
+            SerialBuf data( rec->data, rec->size );
+            data.setPos( rec->size );
+            buf << p->key << (lUInt32)rec->size << data;
+            count++;
+        }
+        int endPos = buf.pos();
+        buf.setPos( countPos );
+        buf << count;
+        buf.setPos( endPos );
+        buf.putCRC( buf.pos() );
+        if ( buf.error() )
+            return false;
+        // file is going to be overwritten: keep records in memory, drop mapping
+        LVHashTable<lUInt32, Record *>::iterator it2 = _records.forwardIterator();
+        for ( LVHashTable<lUInt32, Record *>::pair * p = it2.next(); p; p = it2.next() ) {
+            Record * rec = p->value;
+            if ( !rec->own && rec->size ) {
+                rec->own = (lUInt8 *)malloc( rec->size );
+                memcpy( rec->own, rec->data, rec->size );
+                rec->data = rec->own;
+            }
+        }
+        _mapBuf.Clear();
+        LVCreateDirectory( LVExtractPath( _fileName ) );
+        LVStreamRef stream = LVOpenFileStream( _fileName.c_str(), LVOM_WRITE );
+        if ( stream.isNull() ) {
+            CRLog::error("Cannot create font width cache file %s", LCSTR(_fileName));
+            return false;
+        }
+        lvsize_t bytesWritten = 0;
+        stream->Write( buf.buf(), buf.pos(), &bytesWritten );
+        if ( (int)bytesWritten!=buf.pos() ) {
+            CRLog::error("Cannot write font width cache file %s", LCSTR(_fileName));
+            return false;
+        }
+        _changed = false;
+        CRLog::debug("Font width cache: %d font instances saved", (int)count);
+        return true;
+    }
+
+    LVFontWidthCacheFile() : _records(64), _changed(false) { }
+    ~LVFontWidthCacheFile() { close(); }
+};
+
+const char * LVFontWidthCacheFile::width_cache_magic = "CR3FW002";
+
 static LVFontGlyphCacheItem * newItem( LVFontLocalGlyphCache * local_cache, lChar16 ch, FT_GlyphSlot slot ) // , bool drawMonochrome
 {
     FT_Bitmap*  bitmap = &slot->bitmap;
@@ -427,114 +766,308 @@ static LVFontGlyphCacheItem * newItem( LVFontLocalGlyphCache * local_cache, lCha
     return item;
 }
 
-void LVFontLocalGlyphCache::clear()
+/// glyph item memory is carved from 64K pages, one free list per 16 byte size class
+#define GLYPH_SLAB_PAGE_SIZE  0x10000
+#define GLYPH_SLAB_GRANULARITY 16
+#define GLYPH_SLAB_MAX_ITEM   2048
+#define GLYPH_SLAB_CLASSES    (GLYPH_SLAB_MAX_ITEM / GLYPH_SLAB_GRANULARITY)
+
+class LVFontGlyphSlabAllocator
 {
-    while ( head ) {
-        LVFontGlyphCacheItem * ptr = head;
-        remove( ptr );
-        global_cache->remove( ptr );
-        LVFontGlyphCacheItem::freeItem( ptr );
+    struct FreeItem {
+        FreeItem * next;
+    };
+    LVMutex _mutex;
+    FreeItem * _free[GLYPH_SLAB_CLASSES];
+    LVArray<lUInt8*> _pages;
+    lUInt8 * _page;  ///< page being carved
+    int _pagePos;
+    int _live;       ///< number of allocated items
+public:
+    LVFontGlyphSlabAllocator() : _page(NULL), _pagePos(GLYPH_SLAB_PAGE_SIZE), _live(0)
+    {
+        memset( _free, 0, sizeof(_free) );
     }
+    ~LVFontGlyphSlabAllocator()
+    {
+        for ( int i=0; i<_pages.length(); i++ )
+            free( _pages[i] );
+    }
+    void * alloc( int size )
+    {
+        if ( size > GLYPH_SLAB_MAX_ITEM )
+            return malloc( size );
+        int cls = (size - 1) / GLYPH_SLAB_GRANULARITY;
+        LVLock lock( _mutex );
+        _live++;
+        if ( _free[cls] ) {
+            FreeItem * item = _free[cls];
+            _free[cls] = item->next;
+            return item;
+        }
+        int sz = (cls + 1) * GLYPH_SLAB_GRANULARITY;
+        if ( _pagePos + sz > GLYPH_SLAB_PAGE_SIZE ) {
+            _page = (lUInt8*)malloc( GLYPH_SLAB_PAGE_SIZE );
+            _pages.add( _page );
+            _pagePos = 0;
+        }
+        void * res = _page + _pagePos;
+        _pagePos += sz;
+        return res;
+    }
+    void release( void * p, int size )
+    {
+        if ( size > GLYPH_SLAB_MAX_ITEM ) {
+            free( p );
+            return;
+        }
+        int cls = (size - 1) / GLYPH_SLAB_GRANULARITY;
+        LVLock lock( _mutex );
+        FreeItem * item = (FreeItem*)p;
+        item->next = _free[cls];
+        _free[cls] = item;
+        if ( --_live==0 ) {
+            // no glyphs left: give pages back instead of keeping stale size classes
+            for ( int i=0; i<_pages.length(); i++ )
+                free( _pages[i] );
+            _pages.clear();
+            memset( _free, 0, sizeof(_free) );
+            _page = NULL;
+            _pagePos = GLYPH_SLAB_PAGE_SIZE;
+        }
+    }
+    int getReservedSize()
+    {
+        LVLock lock( _mutex );
+        return _pages.length() * GLYPH_SLAB_PAGE_SIZE;
+    }
+};
+
+static LVFontGlyphSlabAllocator & glyphSlabAllocator()
+{
+    static LVFontGlyphSlabAllocator allocator;
+    return allocator;
+}
+
+LVFontGlyphCacheItem * LVFontGlyphCacheItem::newItem( LVFontLocalGlyphCache * local_cache, lChar16 ch, int w, int h )
+{
+    int size = sizeof(LVFontGlyphCacheItem) + (w*h - 1)*sizeof(lUInt8);
+    LVFontGlyphCacheItem * item = (LVFontGlyphCacheItem *)glyphSlabAllocator().alloc( size );
+    item->size = size;
+    item->ch = ch;
+    item->bmp_width = w;
+    item->bmp_height = h;
+    item->origin_x =   0;
+    item->origin_y =   0;
+    item->advance =    0;
+    item->prev_global = NULL;
+    item->next_global = NULL;
+    item->next_local = NULL;
+    item->local_cache = local_cache;
+    return item;
+}
+
+void LVFontGlyphCacheItem::freeItem( LVFontGlyphCacheItem * item )
+{
+    glyphSlabAllocator().release( item, item->getSize() );
 }
 
-LVFontGlyphCacheItem * LVFontLocalGlyphCache::get( lUInt16 ch )
+LVFontGlyphCacheItem * LVFontLocalGlyphCache::find( lUInt16 ch )
 {
-    LVFontGlyphCacheItem * ptr = head;
-    for ( ; ptr; ptr = ptr->next_local ) {
-        if ( ptr->ch == ch ) {
-            global_cache->refresh( ptr );
+    if ( !_index )
+        return NULL;
+    for ( LVFontGlyphCacheItem * ptr = _index[ch & (_indexSize-1)]; ptr; ptr = ptr->next_local )
+        if ( ptr->ch == ch )
             return ptr;
-        }
-    }
     return NULL;
 }
 
-void LVFontLocalGlyphCache::put( LVFontGlyphCacheItem * item )
+void LVFontLocalGlyphCache::add( LVFontGlyphCacheItem * item )
 {
-    global_cache->put( item );
-    item->next_local = head;
-    if ( head )
-        head->prev_local = item;
-    if ( !tail )
-        tail = item;
-    head = item;
+    if ( _count >= _indexSize ) {
+        // grow hash index twice, rehash items
+        int newSize = _indexSize ? _indexSize * 2 : 64;
+        LVFontGlyphCacheItem ** newIndex = (LVFontGlyphCacheItem **)calloc( newSize, sizeof(LVFontGlyphCacheItem *) );
+        for ( int i=0; i<_indexSize; i++ ) {
+            LVFontGlyphCacheItem * ptr = _index[i];
+            while ( ptr ) {
+                LVFontGlyphCacheItem * next = ptr->next_local;
+                ptr->next_local = newIndex[ptr->ch & (newSize-1)];
+                newIndex[ptr->ch & (newSize-1)] = ptr;
+                ptr = next;
+            }
+        }
+        if ( _index )
+            free( _index );
+        _index = newIndex;
+        _indexSize = newSize;
+    }
+    LVFontGlyphCacheItem * * bucket = &_index[item->ch & (_indexSize-1)];
+    item->next_local = *bucket;
+    *bucket = item;
+    _count++;
 }
 
-/// remove from list, but don't delete
+/// remove from index, but don't delete
 void LVFontLocalGlyphCache::remove( LVFontGlyphCacheItem * item )
 {
-    if ( item==head )
-        head = item->next_local;
-    if ( item==tail )
-        tail = item->prev_local;
-    if ( !head || !tail )
+    if ( !_index )
         return;
-    if ( item->prev_local )
-        item->prev_local->next_local = item->next_local;
-    if ( item->next_local )
-        item->next_local->prev_local = item->prev_local;
-    item->next_local = NULL;
-    item->prev_local = NULL;
+    for ( LVFontGlyphCacheItem * * p = &_index[item->ch & (_indexSize-1)]; *p; p = &(*p)->next_local ) {
+        if ( *p == item ) {
+            *p = item->next_local;
+            item->next_local = NULL;
+            _count--;
+            return;
+        }
+    }
+}
+
+LVFontGlobalGlyphCache::LVFontGlobalGlyphCache( int maxSize )
+    : max_size( maxSize )
+{
+    for ( int i=0; i<GLYPH_CACHE_SHARDS; i++ )
+        _shards[i].max_size = maxSize / GLYPH_CACHE_SHARDS;
+}
+
+void LVFontGlobalGlyphCache::unlink( Shard & shard, LVFontGlyphCacheItem * item )
+{
+    if ( item->prev_global )
+        item->prev_global->next_global = item->next_global;
+    else
+        shard.head = item->next_global;
+    if ( item->next_global )
+        item->next_global->prev_global = item->prev_global;
+    else
+        shard.tail = item->prev_global;
+    item->next_global = NULL;
+    item->prev_global = NULL;
 }
 
-void LVFontGlobalGlyphCache::refresh( LVFontGlyphCacheItem * item )
+void LVFontGlobalGlyphCache::pushFront( Shard & shard, LVFontGlyphCacheItem * item )
 {
-    if ( tail!=item ) {
+    item->prev_global = NULL;
+    item->next_global = shard.head;
+    if ( shard.head )
+        shard.head->prev_global = item;
+    shard.head = item;
+    if ( !shard.tail )
+        shard.tail = item;
+}
+
+LVFontGlyphCacheItem * LVFontGlobalGlyphCache::get( LVFontLocalGlyphCache * local_cache, lUInt16 ch )
+{
+    Shard & shard = _shards[ getShardIndex( local_cache, ch ) ];
+    LVLock lock( shard.mutex );
+    LVFontGlyphCacheItem * item;
+    {
+        LVLock localLock( local_cache->_mutex );
+        item = local_cache->find( ch );
+    }
+    if ( !item ) {
+        shard.misses++;
+        return NULL;
+    }
+    shard.hits++;
+    if ( shard.head != item ) {
         //move to head
-        remove( item );
-        put( item );
+        unlink( shard, item );
+        pushFront( shard, item );
     }
+    return item;
 }
 
 void LVFontGlobalGlyphCache::put( LVFontGlyphCacheItem * item )
 {
+    Shard & shard = _shards[ getShardIndex( item->local_cache, item->ch ) ];
+    LVLock lock( shard.mutex );
     int sz = item->getSize();
     // remove extra items from tail
-    while ( sz + size > max_size ) {
-        LVFontGlyphCacheItem * removed_item = tail;
+    while ( sz + shard.size > shard.max_size ) {
+        LVFontGlyphCacheItem * removed_item = shard.tail;
         if ( !removed_item )
             break;
-        remove( removed_item );
-        removed_item->local_cache->remove( removed_item );
+        unlink( shard, removed_item );
+        shard.size -= removed_item->getSize();
+        shard.items--;
+        shard.evictions++;
+        {
+            LVLock localLock( removed_item->local_cache->_mutex );
+            removed_item->local_cache->remove( removed_item );
+        }
         LVFontGlyphCacheItem::freeItem( removed_item );
     }
     // add new item to head
-    item->next_global = head;
-    if ( head )
-        head->prev_global = item;
-    head = item;
-    if ( !tail )
-        tail = item;
-    size += sz;
+    pushFront( shard, item );
+    shard.size += sz;
+    shard.items++;
+    LVLock localLock( item->local_cache->_mutex );
+    item->local_cache->add( item );
 }
 
-void LVFontGlobalGlyphCache::remove( LVFontGlyphCacheItem * item )
+void LVFontGlobalGlyphCache::clear( LVFontLocalGlyphCache * local_cache )
 {
-    if ( item==head )
-        head = item->next_global;
-    if ( item==tail )
-        tail = item->prev_global;
-    if ( !head || !tail )
-        return;
-    if ( item->prev_global )
-        item->prev_global->next_global = item->next_global;
-    if ( item->next_global )
-        item->next_global->prev_global = item->prev_global;
-    item->next_global = NULL;
-    item->prev_global = NULL;
-    size -= item->getSize();
+    // walk glyphs of font only: take glyph from local index, then lock its shard
+    // and local cache in the same order as get() and put(), and find it again
+    for ( int i=0; ; ) {
+        lUInt16 ch = 0;
+        {
+            LVLock localLock( local_cache->_mutex );
+            while ( i < local_cache->_indexSize && !local_cache->_index[i] )
+                i++;
+            if ( i >= local_cache->_indexSize )
+                break;
+            ch = local_cache->_index[i]->ch;
+        }
+        Shard & shard = _shards[ getShardIndex( local_cache, ch ) ];
+        LVLock lock( shard.mutex );
+        LVLock localLock( local_cache->_mutex );
+        LVFontGlyphCacheItem * item = local_cache->find( ch );
+        if ( !item )
+            continue; // evicted by other thread
+        unlink( shard, item );
+        shard.size -= item->getSize();
+        shard.items--;
+        local_cache->remove( item );
+        LVFontGlyphCacheItem::freeItem( item );
+    }
 }
 
 void LVFontGlobalGlyphCache::clear()
 {
-    while ( head ) {
-        LVFontGlyphCacheItem * ptr = head;
-        remove( ptr );
-        ptr->local_cache->remove( ptr );
-        LVFontGlyphCacheItem::freeItem( ptr );
+    for ( int i=0; i<GLYPH_CACHE_SHARDS; i++ ) {
+        Shard & shard = _shards[i];
+        LVLock lock( shard.mutex );
+        while ( shard.head ) {
+            LVFontGlyphCacheItem * ptr = shard.head;
+            unlink( shard, ptr );
+            {
+                LVLock localLock( ptr->local_cache->_mutex );
+                ptr->local_cache->remove( ptr );
+            }
+            LVFontGlyphCacheItem::freeItem( ptr );
+        }
+        shard.size = 0;
+        shard.items = 0;
     }
 }
 
+void LVFontGlobalGlyphCache::getStats( LVFontGlyphCacheStats & stats )
+{
+    memset( &stats, 0, sizeof(stats) );
+    stats.maxBytes = max_size;
+    for ( int i=0; i<GLYPH_CACHE_SHARDS; i++ ) {
+        Shard & shard = _shards[i];
+        LVLock lock( shard.mutex );
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+        stats.evictions += shard.evictions;
+        stats.items += shard.items;
+        stats.bytes += shard.size;
+    }
+    stats.slabBytes = glyphSlabAllocator().getReservedSize();
+}
+
 lString8 familyName( FT_Face face )
 {
     lString8 faceName( face->family_name );
@@ -579,6 +1112,11 @@ protected:
     int            _weight;
     int            _italic;
     LVFontGlyphWidthCache _wcache;
+    LVFontKerningCache _kcache;
+    LVFontWidthCacheFile * _widthFile; // persistent storage for _wcache and _kcache
+    lUInt32       _widthFileKey;
+    lUInt32       _fontFileHash;
+    int           _index;
     LVFontLocalGlyphCache _glyph_cache;
     bool          _drawMonochrome;
     bool          _allowKerning;
@@ -615,7 +1153,7 @@ public:
 
     LVFreeTypeFace( LVMutex &mutex, FT_Library  library, LVFontGlobalGlyphCache * globalCache )
     : _mutex(mutex), _fontFamily(css_ff_sans_serif), _library(library), _face(NULL), _size(0), _hyphen_width(0), _baseline(0)
-    , _weight(400), _italic(0)
+    , _weight(400), _italic(0), _widthFile(NULL), _widthFileKey(0), _fontFileHash(0), _index(0)
     , _glyph_cache(globalCache), _drawMonochrome(false), _allowKerning(false), _fallbackFontIsSet(false)
     {
         _matrix.xx = 0x10000;
@@ -626,9 +1164,88 @@ public:
 
     virtual ~LVFreeTypeFace()
     {
+        saveWidthCache();
+        if ( _widthFile )
+            _widthFile->detach( this );
         Clear();
     }
 
+    /// writes font instance settings which glyph widths depend on
+    void serializeWidthFileId( SerialBuf & buf )
+    {
+        buf << _fontFileHash << (lUInt32)_index << (lUInt32)_size << _drawMonochrome;
+        buf << (lInt32)_matrix.xx << (lInt32)_matrix.xy << (lInt32)_matrix.yx << (lInt32)_matrix.yy;
+        buf << (lUInt32)((FREETYPE_MAJOR << 16) | (FREETYPE_MINOR << 8) | FREETYPE_PATCH);
+        // widths of chars absent in font are taken from fallback font
+        buf << fontMan->GetFallbackFontFace();
+    }
+
+    /// fills width and kerning caches from width cache file
+    void loadWidthCache()
+    {
+        if ( !_widthFile )
+            return;
+        SerialBuf id( 256, true );
+        serializeWidthFileId( id );
+        _widthFileKey = lStr_crc32( 0, id.buf(), id.pos() );
+        const lUInt8 * data = NULL;
+        int size = 0;
+        if ( !_widthFile->find( _widthFileKey, data, size ) )
+            return;
+        // record starts with settings of its font instance: key is only a hash of them
+        if ( size < id.pos() || memcmp( data, id.buf(), id.pos() ) )
+            return;
+        SerialBuf buf( data + id.pos(), size - id.pos() );
+        if ( !_wcache.deserialize( buf ) || !_kcache.deserialize( buf ) ) {
+            _wcache.clear();
+            _kcache.clear();
+        }
+    }
+
+    /// writes widths and kerning pairs measured in this session to width cache file
+    void saveWidthCache()
+    {
+        LVLock lock(_mutex);
+        if ( !_widthFile || !_face || (!_wcache.isChanged() && !_kcache.isChanged()) )
+            return;
+        SerialBuf buf( 4096, true );
+        serializeWidthFileId( buf );
+        _wcache.serialize( buf );
+        _kcache.serialize( buf );
+        _widthFile->update( _widthFileKey, buf );
+    }
+
+    /// attaches persistent storage for glyph widths and kerning pairs
+    void setWidthCacheFile( LVFontWidthCacheFile * file, lUInt32 fontFileHash )
+    {
+        LVLock lock(_mutex);
+        if ( _widthFile )
+            _widthFile->detach( this );
+        _widthFile = file;
+        _fontFileHash = fontFileHash;
+        if ( _widthFile )
+            _widthFile->attach( this );
+        loadWidthCache();
+    }
+
+    /// returns kerning of glyph pair, in 26.6 format
+    int getKerningDelta( FT_UInt previous, FT_UInt ch_glyph_index )
+    {
+        int kerning = 0;
+        if ( _kcache.get( previous, ch_glyph_index, kerning ) )
+            return kerning;
+        FT_Vector delta;
+        int error = FT_Get_Kerning( _face,          /* handle to face object */
+                      previous,          /* left glyph index      */
+                      ch_glyph_index,         /* right glyph index     */
+                      FT_KERNING_DEFAULT,  /* kerning mode          */
+                      &delta );    /* target vector         */
+        if ( !error )
+            kerning = delta.x;
+        _kcache.put( previous, ch_glyph_index, kerning );
+        return kerning;
+    }
+
     virtual int getHyphenWidth()
     {
         if ( !_hyphen_width ) {
@@ -649,9 +1266,13 @@ public:
     {
         if ( _drawMonochrome == drawBitmap )
             return;
+        saveWidthCache();
         _drawMonochrome = drawBitmap;
         _glyph_cache.clear();
         _wcache.clear();
+        _kcache.clear();
+        LVLock lock(_mutex);
+        loadWidthCache();
     }
 
     bool loadFromFile( const char * fname, int index, int size, css_font_family_t fontFamily, bool monochrome, bool italicize )
@@ -662,6 +1283,7 @@ public:
             _fileName = fname;
         if ( _fileName.empty() )
             return false;
+        _index = index;
         int error = FT_New_Face( _library, _fileName.c_str(), index, &_face ); /* create face object */
         if (error)
             return false;
@@ -806,7 +1428,6 @@ public:
         LVLock lock(_mutex);
         if ( len <= 0 || _face==NULL )
             return 0;
-        int error;
 
 #if (ALLOW_KERNING==1)
         int use_kerning = _allowKerning && FT_HAS_KERNING( _face );
@@ -831,16 +1452,8 @@ public:
             if ( use_kerning && previous>0  ) {
                 if ( ch_glyph_index==(FT_UInt)-1 )
                     ch_glyph_index = getCharIndex( ch, def_char );
-                if ( ch_glyph_index != 0 ) {
-                    FT_Vector delta;
-                    error = FT_Get_Kerning( _face,          /* handle to face object */
-                                  previous,          /* left glyph index      */
-                                  ch_glyph_index,         /* right glyph index     */
-                                  FT_KERNING_DEFAULT,  /* kerning mode          */
-                                  &delta );    /* target vector         */
-                    if ( !error )
-                        kerning = delta.x;
-                }
+                if ( ch_glyph_index != 0 )
+                    kerning = getKerningDelta( previous, ch_glyph_index );
             }
 #endif
 
@@ -1058,7 +1671,6 @@ public:
         if ( y + _height < clip.top || y >= clip.bottom )
             return;
 
-        int error;
 
 #if (ALLOW_KERNING==1)
         int use_kerning = _allowKerning && FT_HAS_KERNING( _face );
@@ -1086,16 +1698,8 @@ public:
             FT_UInt ch_glyph_index = getCharIndex( ch, def_char );
             int kerning = 0;
 #if (ALLOW_KERNING==1)
-            if ( use_kerning && previous>0 && ch_glyph_index>0 ) {
-                FT_Vector delta;
-                error = FT_Get_Kerning( _face,          /* handle to face object */
-                              previous,          /* left glyph index      */
-                              ch_glyph_index,         /* right glyph index     */
-                              FT_KERNING_DEFAULT,  /* kerning mode          */
-                              &delta );    /* target vector         */
-                if ( !error )
-                    kerning = delta.x;
-            }
+            if ( use_kerning && previous>0 && ch_glyph_index>0 )
+                kerning = getKerningDelta( previous, ch_glyph_index );
 #endif
 
 
@@ -1558,13 +2162,51 @@ private:
     LVFontCache _cache;
     FT_Library  _library;
     LVFontGlobalGlyphCache _globalCache;
+    LVFontWidthCacheFile _widthCacheFile;
+    LVHashTable<lString8, lUInt32> _fontFileHashes;
     lString16 _requiredChars;
     #if (DEBUG_FONT_MAN==1)
     FILE * _log;
     #endif
     LVMutex   _lock;
+
+    /// returns hash identifying font file contents: size and first 64K of data
+    lUInt32 getFontFileHash( const lString8 & pathname )
+    {
+        lUInt32 hash = 0;
+        if ( _fontFileHashes.get( pathname, hash ) )
+            return hash;
+        LVStreamRef stream = LVOpenFileStream( pathname.c_str(), LVOM_READ );
+        if ( !stream.isNull() ) {
+            int size = (int)stream->GetSize();
+            int sz = size < 0x10000 ? size : 0x10000;
+            LVArray<lUInt8> buf( sz, 0 );
+            lvsize_t bytesRead = 0;
+            if ( sz>0 && stream->Read( buf.get(), sz, &bytesRead )==LVERR_OK && (int)bytesRead==sz )
+                hash = lStr_crc32( (lUInt32)size, buf.get(), sz );
+        }
+        _fontFileHashes.set( pathname, hash );
+        return hash;
+    }
 public:
 
+    /// sets file to keep glyph widths and kerning pairs of fonts between sessions
+    virtual bool setWidthCacheFile( lString16 fileName )
+    {
+        LVLock lock(_lock);
+        return _widthCacheFile.open( fileName );
+    }
+
+    /// writes glyph widths and kerning pairs of fonts to width cache file
+    virtual bool saveWidthCache()
+    {
+        LVArray<LVFreeTypeFace *> & faces = _widthCacheFile.getFaces();
+        for ( int i=0; i<faces.length(); i++ )
+            faces[i]->saveWidthCache();
+        LVLock lock(_lock);
+        return _widthCacheFile.save();
+    }
+
     /// get hash of installed fonts and fallback font
     virtual lUInt32 GetFontListHash() { return _cache.GetFontListHash() * 75 + _fallbackFontFace.getHash(); }
 
@@ -1649,6 +2291,13 @@ public:
         _globalCache.clear();
     }
 
+    /// retrieves glyph cache usage statistics
+    virtual bool getGlyphCacheStats( LVFontGlyphCacheStats & stats )
+    {
+        _globalCache.getStats( stats );
+        return true;
+    }
+
     virtual int GetFontCount()
     {
         return _cache.length();
@@ -1883,6 +2532,12 @@ public:
     {
         _globalCache.clear();
         _cache.clear();
+        // fonts still referenced from outside must not write to closed file
+        saveWidthCache();
+        LVArray<LVFreeTypeFace *> & faces = _widthCacheFile.getFaces();
+        while ( faces.length() )
+            faces[0]->setWidthCacheFile( NULL, 0 );
+        _widthCacheFile.close();
         if ( _library )
             FT_Done_FreeType( _library );
     #if (DEBUG_FONT_MAN==1)
@@ -1893,7 +2548,7 @@ public:
     }
 
     LVFreeTypeFontManager()
-    : _library(NULL), _globalCache(GLYPH_CACHE_SIZE)
+    : _library(NULL), _globalCache(GLYPH_CACHE_SIZE), _fontFileHashes(32)
     {
         int error = FT_Init_FreeType( &_library );
         if ( error ) {
@@ -2013,6 +2668,7 @@ public:
             LVFontRef ref(font);
             font->setKerning( getKerning() );
             font->setFaceName( item->getDef()->getTypeFace() );
+            font->setWidthCacheFile( &_widthCacheFile, getFontFileHash( pathname ) );
             newDef.setSize( size );
             //item->setFont( ref );
             //_cache.update( def, ref );
@@ -20,6 +20,7 @@
 
 #include "../include/lvimg.h"
 #include "../include/lvtinydom.h"
+#include "../include/lvthread.h"
 
 #if (USE_LIBPNG==1)
 #include <png.h>
@@ -1843,6 +1844,248 @@ LVImageSourceRef LVCreateDrawBufImageSource( LVColorDrawBuf * buf, bool own )
 }
 
 
+#if SCALED_IMAGE_CACHE_SIZE>0
+/// decoded copy of image, scaled the same way LVImageScaledDrawCallback does it
+class LVScaledImgSource : public LVImageSource, public LVImageDecoderCallback
+{
+protected:
+    int _dx;
+    int _dy;
+    int _src_dx;
+    int _src_dy;
+    bool _gray;
+    bool _semiTransparent;
+    lUInt16 * _grayImage; // aaaaaaaayyyyyyyy
+    lUInt32 * _colorImage;
+    int * _xmap;
+public:
+    LVScaledImgSource( LVImageSourceRef src, int dx, int dy, bool gray )
+        : _dx(dx)
+        , _dy(dy)
+        , _src_dx( src->GetWidth() )
+        , _src_dy( src->GetHeight() )
+        , _gray(gray)
+        , _semiTransparent(false)
+        , _grayImage(NULL)
+        , _colorImage(NULL)
+        , _xmap(NULL)
+    {
+        // not decoded lines are left transparent
+        _colorImage = (lUInt32*)malloc( _dx * _dy * sizeof(lUInt32) );
+        for ( int i=_dx*_dy-1; i>=0; i-- )
+            _colorImage[i] = 0xFF000000;
+        if ( _src_dx != _dx ) {
+            _xmap = new int[ _dx ];
+            for ( int i=0; i<_dx; i++ )
+                _xmap[i] = i * _src_dx / _dx;
+        }
+    }
+    /// returns size of decoded image, bytes
+    int getSize() { return _dx * _dy * (_grayImage ? sizeof(lUInt16) : sizeof(lUInt32)); }
+    virtual void OnStartDecode( LVImageSource * )
+    {
+    }
+    virtual bool OnLineDecoded( LVImageSource *, int y, lUInt32 * data )
+    {
+        if ( y<0 || y>=_src_dy )
+            return false;
+        int yy = y;
+        int yy2 = y+1;
+        if ( _src_dy != _dy ) {
+            yy = y * _dy / _src_dy;
+            yy2 = (y+1) * _dy / _src_dy;
+            if ( yy2 > _dy )
+                yy2 = _dy;
+        }
+        for ( ; yy<yy2; yy++ ) {
+            lUInt32 * dst = _colorImage + _dx * yy;
+            if ( _xmap ) {
+                for ( int x=0; x<_dx; x++ )
+                    dst[x] = data[_xmap[x]];
+            } else {
+                memcpy( dst, data, sizeof(lUInt32) * _dx );
+            }
+            if ( _gray && !_semiTransparent ) {
+                for ( int x=0; x<_dx; x++ ) {
+                    lUInt32 alpha = dst[x] >> 24;
+                    if ( alpha!=0 && alpha!=0xFF ) {
+                        _semiTransparent = true;
+                        break;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+    virtual void OnEndDecode( LVImageSource *, bool )
+    {
+        // gray draw buffers blend semi-transparent pixels in RGB, so only opaque images are kept as gray
+        if ( !_gray || _semiTransparent )
+            return;
+        _grayImage = (lUInt16*)malloc( _dx * _dy * sizeof(lUInt16) );
+        for ( int i=_dx*_dy-1; i>=0; i-- ) {
+            lUInt32 cl = _colorImage[i];
+            lUInt32 gray = ( ((cl>>16) & 255) + ((cl>>7) & 510) + (cl & 255) ) >> 2;
+            _grayImage[i] = (lUInt16)(((cl >> 16) & 0xFF00) | gray);
+        }
+        free( _colorImage );
+        _colorImage = NULL;
+    }
+    virtual ldomNode * GetSourceNode() { return NULL; }
+    virtual LVStream * GetSourceStream() { return NULL; }
+    virtual void   Compact() { }
+    virtual int    GetWidth() { return _dx; }
+    virtual int    GetHeight() { return _dy; }
+    virtual bool   Decode( LVImageDecoderCallback * callback )
+    {
+        callback->OnStartDecode( this );
+        if ( _grayImage ) {
+            LVArray<lUInt32> line;
+            line.reserve( _dx );
+            for ( int y=0; y<_dy; y++ ) {
+                lUInt16 * src = _grayImage + _dx * y;
+                lUInt32 * dst = line.ptr();
+                for ( int x=0; x<_dx; x++ ) {
+                    lUInt32 gray = src[x] & 0xFF;
+                    dst[x] = ((lUInt32)(src[x] & 0xFF00) << 16) | (gray << 16) | (gray << 8) | gray;
+                }
+                callback->OnLineDecoded( this, y, dst );
+            }
+        } else {
+            for ( int y=0; y<_dy; y++ )
+                callback->OnLineDecoded( this, y, _colorImage + _dx * y );
+        }
+        callback->OnEndDecode( this, false );
+        return true;
+    }
+    virtual ~LVScaledImgSource()
+    {
+        if ( _grayImage )
+            free( _grayImage );
+        if ( _colorImage )
+            free( _colorImage );
+        if ( _xmap )
+            delete[] _xmap;
+    }
+};
+
+/// LRU cache of decoded document images, to avoid decoding of image on each page redraw
+class LVScaledImageCache
+{
+    class Item {
+    public:
+        ldomNode * _node;
+        ldomDocument * _doc;
+        int _dx;
+        int _dy;
+        bool _gray;
+        int _size;
+        lUInt32 _lastAccess;
+        LVImageSourceRef _image;
+    };
+    LVMutex _mutex;
+    LVPtrVector<Item> _items;
+    int _maxSize;
+    int _size;
+    lUInt32 _accessCounter;
+    /// removes least recently used images until memory limit is satisfied
+    void removeExtraItems( int maxSize )
+    {
+        while ( _size > maxSize && _items.length() > 0 ) {
+            int oldest = 0;
+            for ( int i=1; i<_items.length(); i++ )
+                if ( _items[i]->_lastAccess < _items[oldest]->_lastAccess )
+                    oldest = i;
+            _size -= _items[oldest]->_size;
+            delete _items.remove( oldest );
+        }
+    }
+public:
+    LVScaledImageCache() : _maxSize(SCALED_IMAGE_CACHE_SIZE), _size(0), _accessCounter(0) { }
+    LVImageSourceRef get( LVImageSourceRef srcImage, int dx, int dy, bool gray )
+    {
+        // only images of document nodes have identity which survives redraw
+        ldomNode * node = srcImage->GetSourceNode();
+        if ( !node )
+            return LVImageSourceRef();
+        LVLock lock( _mutex );
+        if ( dx * dy * (int)sizeof(lUInt32) > _maxSize / 2 )
+            return LVImageSourceRef();
+        for ( int i=0; i<_items.length(); i++ ) {
+            Item * item = _items[i];
+            if ( item->_node==node && item->_dx==dx && item->_dy==dy && item->_gray==gray ) {
+                item->_lastAccess = ++_accessCounter;
+                return item->_image;
+            }
+        }
+        LVScaledImgSource * img = new LVScaledImgSource( srcImage, dx, dy, gray );
+        LVImageSourceRef res( img );
+        if ( !srcImage->Decode( img ) )
+            return LVImageSourceRef();
+        int size = img->getSize();
+        removeExtraItems( _maxSize - size );
+        Item * item = new Item();
+        item->_node = node;
+        item->_doc = node->getDocument();
+        item->_dx = dx;
+        item->_dy = dy;
+        item->_gray = gray;
+        item->_size = size;
+        item->_lastAccess = ++_accessCounter;
+        item->_image = res;
+        _items.add( item );
+        _size += size;
+        return res;
+    }
+    void clear( ldomDocument * doc )
+    {
+        LVLock lock( _mutex );
+        for ( int i=_items.length()-1; i>=0; i-- ) {
+            if ( doc && _items[i]->_doc!=doc )
+                continue;
+            _size -= _items[i]->_size;
+            delete _items.remove( i );
+        }
+    }
+    void setMaxSize( int maxSize )
+    {
+        LVLock lock( _mutex );
+        _maxSize = maxSize;
+        removeExtraItems( _maxSize );
+    }
+};
+
+static LVScaledImageCache _scaledImageCache;
+#endif
+
+/// returns decoded copy of document image scaled to width x height (as gray+alpha if gray==true), from cache if already decoded; NULL if image cannot be cached
+LVImageSourceRef LVGetCachedScaledImage( LVImageSourceRef srcImage, int width, int height, bool gray )
+{
+#if SCALED_IMAGE_CACHE_SIZE>0
+    if ( srcImage.isNull() || width<=0 || height<=0 )
+        return LVImageSourceRef();
+    return _scaledImageCache.get( srcImage, width, height, gray );
+#else
+    return LVImageSourceRef();
+#endif
+}
+
+/// removes decoded images of specified document from cache, all images if doc==NULL
+void LVClearScaledImageCache( ldomDocument * doc )
+{
+#if SCALED_IMAGE_CACHE_SIZE>0
+    _scaledImageCache.clear( doc );
+#endif
+}
+
+/// sets memory limit for decoded images cache, bytes; 0 disables caching
+void LVSetScaledImageCacheSize( int maxSize )
+{
+#if SCALED_IMAGE_CACHE_SIZE>0
+    _scaledImageCache.setMaxSize( maxSize );
+#endif
+}
+
 /// draws battery icon in specified rectangle of draw buffer; if font is specified, draws charge %
 // first icon is for charging, the rest - indicate progress icon[1] is lowest level, icon[n-1] is full power
 // if no icons provided, battery will be drawn
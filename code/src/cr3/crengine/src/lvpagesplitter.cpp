@@ -15,33 +15,57 @@
 #include <time.h>
 
 
+void LVRendPageList::updateMaxPageEnds()
+{
+    int maxEnd = _maxPageEnds.length() ? _maxPageEnds[_maxPageEnds.length()-1] : 0;
+    for ( int i=_maxPageEnds.length(); i<length(); i++ ) {
+        const LVRendPageInfo * pi = ((*this)[i]);
+        int end = pi->height > 0 ? pi->start + pi->height : pi->start;
+        if ( i==0 || end > maxEnd )
+            maxEnd = end;
+        _maxPageEnds.add( maxEnd );
+    }
+}
+
 int LVRendPageList::FindNearestPage( int y, int direction )
 {
     if (!length())
         return 0;
-    for (int i=0; i<length(); i++)
-    {
-        const LVRendPageInfo * pi = ((*this)[i]);
-        if (y<pi->start) {
-            if (i==0 || direction>=0)
-                return i;
-            else
-                return i-1;
-        } else if (y<pi->start+pi->height) {
-            if (i<length()-1 && direction>0)
-                return i+1;
-            else if (i==0 || direction>=0)
-                return i;
-            else
-                return i-1;
-        }
+    updateMaxPageEnds();
+    // first page which starts or ends after y
+    int a = 0;
+    int b = length();
+    while ( a < b ) {
+        int c = (a + b) / 2;
+        if ( y < _maxPageEnds[c] )
+            b = c;
+        else
+            a = c + 1;
     }
-    return length()-1;
+    int i = a;
+    if ( i>=length() )
+        return length()-1;
+    const LVRendPageInfo * pi = ((*this)[i]);
+    if (y<pi->start) {
+        if (i==0 || direction>=0)
+            return i;
+        else
+            return i-1;
+    }
+    if (i<length()-1 && direction>0)
+        return i+1;
+    else if (i==0 || direction>=0)
+        return i;
+    else
+        return i-1;
 }
 
 LVRendPageContext::LVRendPageContext(LVRendPageList * pageList, int pageHeight)
     : callback(NULL), totalFinalBlocks(0)
     , renderedFinalBlocks(0), lastPercent(-1), page_list(pageList), page_h(pageHeight), footNotes(64), curr_note(NULL)
+    , progress_split(NULL), progress_line(0), page_list_base(0)
+    , progress_checkpoint(NULL), progress_checkpoint_line(-1), progress_checkpoint_pages(0), progress_pending(false)
+    , first_screen_node(NULL), first_screen_y(-1), first_screen_ready(false)
 {
     if ( callback ) {
         callback->OnFormatStart();
@@ -59,6 +83,8 @@ bool LVRendPageContext::updateRenderProgress( int numFinalBlocksRendered )
     if ( callback && percent>lastPercent+RENDER_PROGRESS_INTERVAL_PERCENT ) {
         if ( progressTimeout.expired() ) {
             callback->OnFormatProgress(percent);
+            if ( progress_split && !(progress_pending && first_screen_ready) )
+                callback->OnFormatPagesReady( page_list->length() );
             progressTimeout.restart(RENDER_PROGRESS_INTERVAL_MILLIS);
             lastPercent = percent;
             return true;
@@ -89,6 +115,11 @@ void LVRendPageContext::enterFootNote( lString16 id )
         return;
     }
     curr_note = getOrCreateFootNote( id );
+    // lines of note with duplicate id are appended to note which may be already split
+    if ( progress_split && !curr_note->empty() ) {
+        progress_pending = true;
+        progress_checkpoint_line = -1;
+    }
 }
 
 /// mark end of foot note
@@ -114,6 +145,8 @@ void LVRendPageContext::AddLine( int starty, int endy, int flags )
         //CRLog::trace("adding line to note (%d)", line->start);
         curr_note->addLine( line );
     }
+    if ( progress_split )
+        splitProgressive();
 }
 
 #define FOOTNOTE_MARGIN 12
@@ -358,48 +391,153 @@ public:
     }
 };
 
+/// add line and its footnotes to split state; nextLine is the following line or line itself if last
+static void splitLine( PageSplitState & s, LVRendLineInfo * line, LVRendLineInfo * nextLine, bool updateFlags )
+{
+    s.AddLine( line );
+    // add footnotes for line, if any...
+    if ( line->getLinks() ) {
+        s.last = line;
+        s.next = nextLine;
+        bool foundFootNote = false;
+        //if ( CRLog::isTraceEnabled() && line->getLinks()->length()>0 ) {
+        //    CRLog::trace("LVRendPageContext::split() line %d: found %d links", lindex, line->getLinks()->length() );
+       // }
+        for ( int j=0; j<line->getLinks()->length(); j++ ) {
+            LVFootNote* note = line->getLinks()->get(j);
+            if ( note->getLines().length() ) {
+                foundFootNote = true;
+                s.StartFootNote( note );
+                for ( int k=0; k<note->getLines().length(); k++ ) {
+                    s.AddFootnoteLine( note->getLines()[k] );
+                }
+                s.EndFootNote();
+            }
+        }
+        if ( !foundFootNote && updateFlags )
+            line->flags = line->flags & ~RN_SPLIT_FOOT_LINK;
+    }
+}
+
 void LVRendPageContext::split()
 {
     if ( !page_list )
         return;
     PageSplitState s(page_list, page_h);
+    splitLines( s, 0 );
+}
 
+/// split lines starting from startLine, continuing from splitter state s
+void LVRendPageContext::splitLines( PageSplitState & s, int startLine )
+{
     int lineCount = lines.length();
 
 
     LVRendLineInfo * line = NULL;
-    for ( int lindex=0; lindex<lineCount; lindex++ ) {
+    for ( int lindex=startLine; lindex<lineCount; lindex++ ) {
         line = lines[lindex];
-        s.AddLine( line );
-        // add footnotes for line, if any...
-        if ( line->getLinks() ) {
-            s.last = line;
-            s.next = lindex<lineCount-1?lines[lindex+1]:line;
-            bool foundFootNote = false;
-            //if ( CRLog::isTraceEnabled() && line->getLinks()->length()>0 ) {
-            //    CRLog::trace("LVRendPageContext::split() line %d: found %d links", lindex, line->getLinks()->length() );
-           // }
-            for ( int j=0; j<line->getLinks()->length(); j++ ) {
-                LVFootNote* note = line->getLinks()->get(j);
-                if ( note->getLines().length() ) {
-                    foundFootNote = true;
-                    s.StartFootNote( note );
-                    for ( int k=0; k<note->getLines().length(); k++ ) {
-                        s.AddFootnoteLine( note->getLines()[k] );
-                    }
-                    s.EndFootNote();
-                }
+        splitLine( s, line, lindex<lineCount-1?lines[lindex+1]:line, true );
+    }
+    s.Finalize();
+}
+
+/// returns true if line links to footnote which may get more lines later
+bool LVRendPageContext::hasPendingFootNotes( LVRendLineInfo * line )
+{
+    LVFootNoteList * links = line->getLinks();
+    if ( !links )
+        return false;
+    for ( int i=0; i<links->length(); i++ ) {
+        LVFootNote * note = links->get(i);
+        if ( note->empty() || note==curr_note )
+            return true;
+    }
+    return false;
+}
+
+/// enable progressive pagination: node is the one to show first (NULL for document start)
+void LVRendPageContext::setFirstScreenNode( ldomNode * node )
+{
+    if ( !page_list || !callback || progress_split )
+        return;
+    progress_split = new PageSplitState(page_list, page_h);
+    progress_line = lines.length();
+    page_list_base = page_list->length();
+    progress_checkpoint = new PageSplitState(page_list, page_h);
+    progress_checkpoint_line = progress_line;
+    progress_checkpoint_pages = page_list_base;
+    progress_pending = false;
+    first_screen_node = node;
+    first_screen_y = node ? -1 : 0;
+    first_screen_ready = false;
+}
+
+/// called from renderer when lines of first screen node are added
+void LVRendPageContext::setFirstScreenPosition( int y )
+{
+    first_screen_node = NULL;
+    first_screen_y = y;
+}
+
+/// pass newly added lines to progressive splitter, notify callback when first pages are ready
+void LVRendPageContext::splitProgressive()
+{
+    // pages after checkpoint are split again by Finalize(), no need to continue once shown
+    if ( progress_pending && first_screen_ready )
+        return;
+    // last line is held back: footnote links are appended to it after AddLine()
+    int lineCount = lines.length();
+    for ( ; progress_line<lineCount-1; progress_line++ ) {
+        if ( !progress_pending ) {
+            if ( page_list->length()>progress_checkpoint_pages ) {
+                *progress_checkpoint = *progress_split;
+                progress_checkpoint_line = progress_line;
+                progress_checkpoint_pages = page_list->length();
             }
-            if ( !foundFootNote )
-                line->flags = line->flags & ~RN_SPLIT_FOOT_LINK;
+            progress_pending = hasPendingFootNotes( lines[progress_line] );
         }
+        splitLine( *progress_split, lines[progress_line], lines[progress_line+1], false );
     }
-    s.Finalize();
+    if ( first_screen_ready || first_screen_y<0 || page_list->length()<=page_list_base )
+        return;
+    // wait until page after the one with current position is started
+    LVRendPageInfo * lastPage = page_list->last();
+    if ( lastPage->start + lastPage->height < first_screen_y + page_h )
+        return;
+    first_screen_ready = true;
+    callback->OnFormatPagesReady( page_list->length() );
+    callback->OnFormatFirstPagesReady( page_list->FindNearestPage( first_screen_y, 0 ) );
+}
+
+LVRendPageContext::~LVRendPageContext()
+{
+    if ( progress_split )
+        delete progress_split;
+    if ( progress_checkpoint )
+        delete progress_checkpoint;
 }
 
 void LVRendPageContext::Finalize()
 {
-    split();
+    if ( !progress_split ) {
+        split();
+    } else if ( !progress_pending ) {
+        // all footnotes were complete when lines were split: just split the rest
+        splitLines( *progress_split, progress_line );
+    } else if ( progress_checkpoint_line>=0 ) {
+        // pages after checkpoint may lack footnotes rendered later: split them again
+        page_list->erase( progress_checkpoint_pages, page_list->length() - progress_checkpoint_pages );
+        splitLines( *progress_checkpoint, progress_checkpoint_line );
+    } else {
+        page_list->erase( page_list_base, page_list->length() - page_list_base );
+        split();
+    }
+    if ( progress_split ) {
+        delete progress_split;
+        progress_split = NULL;
+        delete progress_checkpoint;
+        progress_checkpoint = NULL;
+    }
     lines.clear();
     footNotes.clear();
 }
@@ -1387,6 +1387,21 @@ void getPageBreakStyle( ldomNode * el, css_page_break_t &before, css_page_break_
     }
 }
 
+/// height of block which is being rendered, while its pages may be drawn
+#define RENDER_IN_PROGRESS_HEIGHT 0x3FFFFFFF
+
+/// returns true if one of nodes is ancestor of another one, or nodes are the same
+static bool isSameBranch( ldomNode * node1, ldomNode * node2 )
+{
+    for ( ldomNode * p = node2; p; p = p->getParentNode() )
+        if ( p==node1 )
+            return true;
+    for ( ldomNode * p = node1->getParentNode(); p; p = p->getParentNode() )
+        if ( p==node2 )
+            return true;
+    return false;
+}
+
 int renderBlockElement( LVRendPageContext & context, ldomNode * enode, int x, int y, int width )
 {
     if ( enode->isElement() )
@@ -1470,10 +1485,18 @@ int renderBlockElement( LVRendPageContext & context, ldomNode * enode, int x, in
                     if ( isFootNoteBody )
                         context.enterFootNote( enode->getAttributeValue(attr_id) );
 
+                    int cnt = enode->getChildCount();
+                    // first screen may be drawn while block is rendered: don't let it be clipped
+                    // by height, and hide children left from previous rendering
+                    if ( context.isFirstScreenPending() ) {
+                        fmt.setHeight( RENDER_IN_PROGRESS_HEIGHT );
+                        fmt.push();
+                        for ( int i=0; i<cnt; i++ )
+                            enode->getChildNode( i )->clearRenderData();
+                    }
 
                     // recurse all sub-blocks for blocks
                     int y = padding_top;
-                    int cnt = enode->getChildCount();
                     for (int i=0; i<cnt; i++)
                     {
                         ldomNode * child = enode->getChildNode( i );
@@ -1530,6 +1553,9 @@ int renderBlockElement( LVRendPageContext & context, ldomNode * enode, int x, in
         if ( flgSplit ) {
             lvRect rect;
             enode->getAbsRect(rect);
+            // block with current position is reached: pages around it can be shown
+            if ( context.getFirstScreenNode() && isSameBranch( enode, context.getFirstScreenNode() ) )
+                context.setFirstScreenPosition( rect.top );
             // split pages
             if ( context.getPageList() != NULL ) {
 
@@ -1615,7 +1641,9 @@ void DrawDocument( LVDrawBuf & drawbuf, ldomNode * enode, int x0, int y0, int dx
         int padding_right = !draw_padding_bg ? 0 : lengthToPx( enode->getStyle()->padding[1], width, em ) + DEBUG_TREE_DRAW;
         int padding_top = !draw_padding_bg ? 0 : lengthToPx( enode->getStyle()->padding[2], width, em ) + DEBUG_TREE_DRAW;
         //int padding_bottom = !draw_padding_bg ? 0 : lengthToPx( enode->getStyle()->padding[3], width, em ) + DEBUG_TREE_DRAW;
-        if ( (doc_y + height <= 0 || doc_y > 0 + dy)
+        // when first screen is drawn during render, blocks which are not rendered yet have zero height
+        bool notRendered = height == 0 && !enode->getDocument()->isRendered();
+        if ( (doc_y + height <= 0 || doc_y > 0 + dy || notRendered)
             && (
                enode->getRendMethod()!=erm_table_row
                && enode->getRendMethod()!=erm_table_row_group
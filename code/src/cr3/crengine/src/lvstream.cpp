@@ -1308,6 +1308,9 @@ public:
         }
         m_mode = (lvopen_mode_t)mode;
         m_size = (lvsize_t) stat.st_size;
+
+        // set filename
+        SetName( fname.c_str() );
 #endif
 
         return LVERR_OK;
@@ -2086,6 +2089,75 @@ struct ZipHd2
 
 #if (USE_ZLIB==1)
 
+/// deflate dictionary size
+#define ZIP_WINDOW_SIZE 0x8000
+
+/// inflate state snapshot which allows to restart decoding from the middle of ZIP member
+struct LVZipSeekPoint
+{
+    lvpos_t  outpos;     // position in unpacked data
+    lvpos_t  inpos;      // position of first byte in packed data which is not fully consumed
+    int      bits;       // number of unused bits in byte at inpos-1
+    int      windowsize; // number of bytes in window
+    lUInt8 * window;     // unpacked data preceeding outpos
+    LVZipSeekPoint( lvpos_t out, lvpos_t in, int b, const lUInt8 * ring, int ringpos, int ringfill )
+        : outpos(out), inpos(in), bits(b), windowsize(ringfill)
+    {
+        window = new lUInt8[windowsize > 0 ? windowsize : 1];
+        if ( ringfill < ZIP_WINDOW_SIZE ) {
+            // buffer is not wrapped yet
+            memcpy( window, ring, ringfill );
+        } else {
+            // unroll circular buffer: oldest byte first
+            memcpy( window, ring + ringpos, ZIP_WINDOW_SIZE - ringpos );
+            memcpy( window + ZIP_WINDOW_SIZE - ringpos, ring, ringpos );
+        }
+    }
+    ~LVZipSeekPoint()
+    {
+        delete[] window;
+    }
+};
+
+/// seek checkpoints of single ZIP member, shared by all streams opened for this member
+/**
+    Built lazily while member is being decoded: each time decoder passes deflate block boundary
+    farther than ZIP_SEEK_INDEX_SPAN from last checkpoint, its state is added to index.
+    Backward seeks then restart decoding from nearest checkpoint instead of beginning of member.
+*/
+class LVZipSeekIndex : public LVRefCounter
+{
+    LVPtrVector<LVZipSeekPoint> m_points;
+    bool m_complete;
+public:
+    LVZipSeekIndex() : m_complete(false) { }
+    /// returns true if whole member is already indexed
+    bool isComplete() { return m_complete; }
+    /// mark member as fully indexed
+    void setComplete() { m_complete = true; }
+    /// returns unpacked position of last checkpoint, 0 if no checkpoints
+    lvpos_t getLastPos() { return m_points.length() ? m_points[m_points.length()-1]->outpos : 0; }
+    /// returns number of checkpoints
+    int length() { return m_points.length(); }
+    /// add new checkpoint (must be after last one)
+    void add( LVZipSeekPoint * point ) { m_points.add( point ); }
+    /// returns last checkpoint with position <= pos, NULL if not found
+    LVZipSeekPoint * find( lvpos_t pos )
+    {
+        int a = 0;
+        int b = m_points.length();
+        while ( a < b ) {
+            int c = (a + b) / 2;
+            if ( m_points[c]->outpos <= pos )
+                a = c + 1;
+            else
+                b = c;
+        }
+        return a > 0 ? m_points[a - 1] : NULL;
+    }
+};
+typedef LVFastRef<LVZipSeekIndex> LVZipSeekIndexRef;
+
 class LVZipDecodeStream : public LVNamedStream
 {
 private:
@@ -2102,15 +2174,22 @@ private:
     lUInt8 *    m_outbuf;
     lUInt32     m_CRC;
     lUInt32     m_originalCRC;
+    LVZipSeekIndexRef m_index;
+    lUInt8 *    m_window;     // circular buffer with last decoded bytes, used for index building
+    int         m_windowpos;
+    int         m_windowfill;
 
 
-    LVZipDecodeStream( LVStreamRef stream, lvsize_t start, lvsize_t packsize, lvsize_t unpacksize, lUInt32 crc )
+    LVZipDecodeStream( LVStreamRef stream, lvsize_t start, lvsize_t packsize, lvsize_t unpacksize, lUInt32 crc, LVZipSeekIndexRef index )
         : m_stream(stream), m_start(start), m_packsize(packsize), m_unpacksize(unpacksize),
         m_inbytesleft(0), m_outbytesleft(0), m_zInitialized(false), m_decodedpos(0),
-        m_inbuf(NULL), m_outbuf(NULL), m_CRC(0), m_originalCRC(crc)
+        m_inbuf(NULL), m_outbuf(NULL), m_CRC(0), m_originalCRC(crc), m_index(index),
+        m_window(NULL), m_windowpos(0), m_windowfill(0)
     {
         m_inbuf = new lUInt8[ARC_INBUF_SIZE];
         m_outbuf = new lUInt8[ARC_OUTBUF_SIZE];
+        if ( !m_index.isNull() )
+            m_window = new lUInt8[ZIP_WINDOW_SIZE];
         rewind();
     }
 
@@ -2121,6 +2200,8 @@ private:
             delete[] m_inbuf;
         if (m_outbuf)
             delete[] m_outbuf;
+        if (m_window)
+            delete[] m_window;
     }
 
     /// Get stream open mode
@@ -2205,8 +2286,80 @@ private:
             return false;
         }
         m_zInitialized = true;
+        m_windowpos = 0;
+        m_windowfill = 0;
         return true;
     }
+
+    /// restart decoding from seek index checkpoint
+    bool restore( LVZipSeekPoint * point )
+    {
+        zUninit();
+        lvpos_t inpos = point->inpos - (point->bits ? 1 : 0);
+        m_stream->SetPos( inpos );
+
+        m_CRC = 0;
+        memset( &m_zstream, 0, sizeof(m_zstream) );
+        // inbuf
+        m_inbytesleft = m_packsize - inpos;
+        m_zstream.next_in = m_inbuf;
+        m_zstream.avail_in = 0;
+        fillInBuf();
+        // outbuf
+        m_zstream.next_out = m_outbuf;
+        m_zstream.avail_out = ARC_OUTBUF_SIZE;
+        m_decodedpos = 0;
+        m_outbytesleft = m_unpacksize - point->outpos;
+        // Z
+        if ( inflateInit2( &m_zstream, -15 ) != Z_OK )
+            return false;
+        m_zInitialized = true;
+        if ( point->bits ) {
+            if ( m_zstream.avail_in == 0 )
+                return false;
+            int value = *m_zstream.next_in++;
+            m_zstream.avail_in--;
+            inflatePrime( &m_zstream, point->bits, value >> (8 - point->bits) );
+        }
+        if ( inflateSetDictionary( &m_zstream, point->window, point->windowsize ) != Z_OK )
+            return false;
+        m_zstream.total_in = point->inpos;
+        m_zstream.total_out = point->outpos;
+        if ( m_window ) {
+            memcpy( m_window, point->window, point->windowsize );
+            m_windowfill = point->windowsize;
+            m_windowpos = point->windowsize % ZIP_WINDOW_SIZE;
+        }
+        return true;
+    }
+
+    /// put decoded data to circular window buffer
+    void updateWindow( const lUInt8 * data, int len )
+    {
+        if ( len > ZIP_WINDOW_SIZE ) {
+            data += len - ZIP_WINDOW_SIZE;
+            len = ZIP_WINDOW_SIZE;
+        }
+        while ( len > 0 ) {
+            int sz = ZIP_WINDOW_SIZE - m_windowpos;
+            if ( sz > len )
+                sz = len;
+            memcpy( m_window + m_windowpos, data, sz );
+            m_windowpos = (m_windowpos + sz) % ZIP_WINDOW_SIZE;
+            m_windowfill += sz;
+            if ( m_windowfill > ZIP_WINDOW_SIZE )
+                m_windowfill = ZIP_WINDOW_SIZE;
+            data += sz;
+            len -= sz;
+        }
+    }
+
+    /// returns true if seek index needs to be updated while decoding
+    inline bool isIndexing()
+    {
+        return m_window && !m_index->isComplete();
+    }
+
     // returns count of available decoded bytes in buffer
     inline int getAvailBytes()
     {
@@ -2239,19 +2392,41 @@ private:
                 m_zstream.avail_out = ARC_OUTBUF_SIZE - outpos;
             }
         }
-        int decoded = m_zstream.avail_out;
-        int res = inflate( &m_zstream, m_inbytesleft > 0 ? Z_NO_FLUSH : Z_FINISH ); //m_inbytesleft | m_zstream.avail_in
-        decoded -= m_zstream.avail_out;
-        if (res == Z_STREAM_ERROR)
-        {
-            return -1;
-        }
-        if (res == Z_BUF_ERROR)
-        {
-            //return -1;
-            res = 0; // DEBUG
+        for (;;) {
+            bool indexing = isIndexing();
+            int flush = indexing ? Z_BLOCK : (m_inbytesleft > 0 ? Z_NO_FLUSH : Z_FINISH);
+            int decoded = m_zstream.avail_out;
+            int consumed = m_zstream.avail_in;
+            int res = inflate( &m_zstream, flush ); //m_inbytesleft | m_zstream.avail_in
+            decoded -= m_zstream.avail_out;
+            consumed -= m_zstream.avail_in;
+            if (res == Z_STREAM_ERROR)
+            {
+                return -1;
+            }
+            if (res == Z_BUF_ERROR)
+            {
+                //return -1;
+                res = 0; // DEBUG
+            }
+            if ( indexing ) {
+                updateWindow( m_zstream.next_out - decoded, decoded );
+                if ( res == Z_STREAM_END ) {
+                    m_index->setComplete();
+                } else if ( (m_zstream.data_type & 128) && !(m_zstream.data_type & 64)
+                        && (lvpos_t)m_zstream.total_out >= m_index->getLastPos() + ZIP_SEEK_INDEX_SPAN ) {
+                    // deflate block boundary: save checkpoint
+                    m_index->add( new LVZipSeekPoint( m_zstream.total_out, m_zstream.total_in,
+                            m_zstream.data_type & 7, m_window, m_windowpos, m_windowfill ) );
+                }
+            }
+            avail = getAvailBytes();
+            // Z_BLOCK may stop at block boundary before any output is produced
+            if ( avail > 0 || !indexing || res == Z_STREAM_END || (decoded == 0 && consumed == 0) )
+                break;
+            if ( m_zstream.avail_out == 0 || fillInBuf() < 0 )
+                break;
         }
-        avail = getAvailBytes();
         return avail;
     }
     /// skip bytes from out stream
@@ -2363,7 +2538,14 @@ public:
             return LVERR_FAIL;
         if ( npos != currpos )
         {
-            if (npos < currpos)
+            // nearest checkpoint which allows to avoid decoding from beginning or from current position
+            LVZipSeekPoint * point = m_index.isNull() ? NULL : m_index->find( npos );
+            if ( point && (npos < currpos || point->outpos > currpos) )
+            {
+                if ( !restore(point) || !skip((int)(npos - point->outpos)) )
+                    return LVERR_FAIL;
+            }
+            else if (npos < currpos)
             {
                 if ( !rewind() || !skip((int)npos) )
                     return LVERR_FAIL;
@@ -2398,7 +2580,7 @@ public:
     {
         return LVERR_NOTIMPL;
     }
-    static LVStream * Create( LVStreamRef stream, lvpos_t pos, lString16 name, lUInt32 srcPackSize, lUInt32 srcUnpSize )
+    static LVStream * Create( LVStreamRef stream, lvpos_t pos, lString16 name, lUInt32 srcPackSize, lUInt32 srcUnpSize, LVZipSeekIndexRef index = LVZipSeekIndexRef() )
     {
         ZipLocalFileHdr hdr;
         unsigned hdr_size = 0x1E; //sizeof(hdr);
@@ -2433,7 +2615,7 @@ public:
             // deflate
             LVStreamRef srcStream( new LVStreamFragment( stream, pos, hdr.getPackSize()) );
             LVZipDecodeStream * res = new LVZipDecodeStream( srcStream, pos,
-                packSize, unpSize, hdr.getCRC() );
+                packSize, unpSize, hdr.getCRC(), unpSize >= ZIP_SEEK_INDEX_MIN_SIZE ? index : LVZipSeekIndexRef() );
             res->SetName( name.c_str() );
             return res;
         }
@@ -2444,6 +2626,8 @@ public:
 
 class LVZipArc : public LVArcContainerBase
 {
+    /// seek indexes of items, built while items are being read
+    LVArray<LVZipSeekIndexRef> m_indexes;
 public:
     virtual LVStreamRef OpenStream( const wchar_t * fname, lvopen_mode_t mode )
     {
@@ -2464,6 +2648,14 @@ public:
             return LVStreamRef(); // not found
         // make filename
         lString16 fn = fname;
+        LVZipSeekIndexRef index;
+        if ( ZIP_SEEK_INDEX_SPAN > 0 ) {
+            while ( m_indexes.length() < m_list.length() )
+                m_indexes.add( LVZipSeekIndexRef() );
+            if ( m_indexes[found_index].isNull() )
+                m_indexes[found_index] = LVZipSeekIndexRef( new LVZipSeekIndex() );
+            index = m_indexes[found_index];
+        }
         LVStreamRef strm = m_stream; // fix strange arm-linux-g++ bug
         LVStreamRef stream(
 		LVZipDecodeStream::Create(
@@ -2471,7 +2663,8 @@ public:
 			m_list[found_index]->GetSrcPos(),
             fn,
             m_list[found_index]->GetSrcSize(),
-            m_list[found_index]->GetSize() )
+            m_list[found_index]->GetSize(),
+            index )
         );
         if (!stream.isNull()) {
             stream->SetName(m_list[found_index]->GetName());
@@ -2495,6 +2688,7 @@ public:
         bool truncated = false;
 
         m_list.clear();
+        m_indexes.clear();
         if (!m_stream || m_stream->Seek(0, LVSEEK_SET, NULL)!=LVERR_OK)
             return 0;
 
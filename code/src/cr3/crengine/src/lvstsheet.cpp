@@ -17,6 +17,7 @@
 #include "../include/lvtinydom.h"
 #include "../include/fb2def.h"
 #include "../include/lvstream.h"
+#include "../include/lvhashtable.h"
 
 // define to dump all tokens
 //#define DUMP_CSS_PARSING
@@ -1266,6 +1267,7 @@ LVCssSelector::LVCssSelector( LVCssSelector & v )
 
 void LVStyleSheet::set(LVPtrVector<LVCssSelector> & v  )
 {
+    invalidateIndex();
     _selectors.clear();
     if ( !v.size() )
         return;
@@ -1280,43 +1282,260 @@ void LVStyleSheet::set(LVPtrVector<LVCssSelector> & v  )
 }
 
 LVStyleSheet::LVStyleSheet( LVStyleSheet & sheet )
-:   _doc( sheet._doc )
+:   _doc( sheet._doc ), _index( NULL )
 {
     set( sheet._selectors );
 }
 
+/// selector chain item, keeps position in chain to merge buckets in original order
+struct LVCssSelectorIndexItem
+{
+    int pos;
+    LVCssSelector * selector;
+    /// element ids required among ancestors (bit per id & 31) by > and space rules
+    lUInt32 ancestors;
+    /// selector has no rules except its bucket key, so bucket hit means match
+    bool keyOnly;
+};
+
+typedef LVArray<LVCssSelectorIndexItem> LVCssSelectorIndexList;
+typedef LVHashTable<lString16, LVCssSelectorIndexList *> LVCssSelectorBuckets;
+
+/// selectors of single element chain, split by class and id of matched element
+class LVCssSelectorChainIndex
+{
+    LVCssSelectorIndexList _generic;
+    LVCssSelectorBuckets _byClass;
+    LVCssSelectorBuckets _byId;
+
+    static void clearBuckets( LVCssSelectorBuckets & buckets )
+    {
+        LVCssSelectorBuckets::iterator it = buckets.forwardIterator();
+        LVCssSelectorBuckets::pair * p;
+        while ( (p = it.next()) != NULL )
+            delete p->value;
+        buckets.clear();
+    }
+    void add( LVCssSelectorBuckets & buckets, const lString16 & key, const LVCssSelectorIndexItem & item )
+    {
+        LVCssSelectorIndexList * list = buckets.get( key );
+        if ( !list ) {
+            list = new LVCssSelectorIndexList();
+            buckets.set( key, list );
+        }
+        list->add( item );
+    }
+public:
+    LVCssSelectorChainIndex( LVCssSelector * first )
+    : _byClass( 64 ), _byId( 16 )
+    {
+        int pos = 0;
+        for ( LVCssSelector * p = first; p; p = p->getNext(), pos++ ) {
+            LVCssSelectorIndexItem item;
+            item.pos = pos;
+            item.selector = p;
+            item.ancestors = 0;
+            item.keyOnly = false;
+            // rules before first combinator are conditions on element itself
+            LVCssSelectorRule * key = NULL;
+            bool subject = true;
+            int count = 0;
+            for ( LVCssSelectorRule * rule = p->getRules(); rule; rule = rule->getNext() ) {
+                count++;
+                switch ( rule->getType() ) {
+                case cssrt_parent:
+                case cssrt_ancessor:
+                    item.ancestors |= (lUInt32)1 << (rule->getId() & 31);
+                    subject = false;
+                    break;
+                case cssrt_predecessor:
+                    subject = false;
+                    break;
+                case cssrt_id:
+                    if ( subject && (!key || key->getType()!=cssrt_id) )
+                        key = rule;
+                    break;
+                case cssrt_class:
+                    if ( subject && !key )
+                        key = rule;
+                    break;
+                default:
+                    break;
+                }
+            }
+            item.keyOnly = key && count==1;
+            if ( !key )
+                _generic.add( item );
+            else if ( key->getType()==cssrt_id )
+                add( _byId, key->getValue(), item );
+            else
+                add( _byClass, key->getValue(), item );
+        }
+    }
+    ~LVCssSelectorChainIndex()
+    {
+        clearBuckets( _byClass );
+        clearBuckets( _byId );
+    }
+    bool hasClassBuckets() { return _byClass.length() > 0; }
+    bool hasIdBuckets() { return _byId.length() > 0; }
+    LVCssSelectorIndexList * getGeneric() { return &_generic; }
+    LVCssSelectorIndexList * getByClass( const lString16 & value ) { return value.empty() ? NULL : _byClass.get( value ); }
+    LVCssSelectorIndexList * getById( const lString16 & value ) { return value.empty() ? NULL : _byId.get( value ); }
+};
+
+/// per element id chain indexes, parallel to LVStyleSheet::_selectors
+class LVCssSelectorIndex
+{
+    LVPtrVector<LVCssSelectorChainIndex> _chains;
+public:
+    LVCssSelectorIndex( LVPtrVector<LVCssSelector> & selectors )
+    {
+        _chains.reserve( selectors.length() );
+        for ( int i=0; i<selectors.length(); i++ )
+            _chains.add( selectors[i] ? new LVCssSelectorChainIndex( selectors[i] ) : NULL );
+    }
+    LVCssSelectorChainIndex * getChain( int id )
+    {
+        return id>=0 && id<_chains.length() ? _chains[id] : NULL;
+    }
+};
+
+/// walks chain candidates for element (generic + class bucket + id bucket) in chain order
+class LVCssSelectorCursor
+{
+    LVCssSelectorIndexList * _lists[3];
+    int _pos[3];
+    const LVCssSelectorIndexItem * _item;
+    int _list;
+    void find()
+    {
+        _item = NULL;
+        _list = -1;
+        for ( int i=0; i<3; i++ ) {
+            if ( _lists[i] && _pos[i] < _lists[i]->length() ) {
+                const LVCssSelectorIndexItem * item = &(*_lists[i])[_pos[i]];
+                if ( !_item || item->pos < _item->pos ) {
+                    _item = item;
+                    _list = i;
+                }
+            }
+        }
+    }
+public:
+    LVCssSelectorCursor( LVCssSelectorChainIndex * chain, const lString16 & nodeClass, const lString16 & nodeId )
+    {
+        _lists[0] = chain ? chain->getGeneric() : NULL;
+        _lists[1] = chain ? chain->getByClass( nodeClass ) : NULL;
+        _lists[2] = chain ? chain->getById( nodeId ) : NULL;
+        _pos[0] = _pos[1] = _pos[2] = 0;
+        find();
+    }
+    const LVCssSelectorIndexItem * get() { return _item; }
+    void next()
+    {
+        if ( _list >= 0 ) {
+            _pos[_list]++;
+            find();
+        }
+    }
+};
+
+LVStyleSheet::~LVStyleSheet()
+{
+    invalidateIndex();
+}
+
+void LVStyleSheet::invalidateIndex()
+{
+    if ( _index ) {
+        delete _index;
+        _index = NULL;
+    }
+}
+
+/// returns bitmask of (element id & 31) for all ancestors of node
+static lUInt32 getAncestorsMask( const ldomNode * node )
+{
+    lUInt32 mask = 0;
+    for ( const ldomNode * p = node->getParentNode(); p && !p->isNull(); p = p->getParentNode() )
+        mask |= (lUInt32)1 << (p->getNodeId() & 31);
+    return mask;
+}
+
+static void applyIndexItem( const LVCssSelectorIndexItem * item, const ldomNode * node, css_style_rec_t * style, lUInt32 & ancestors, bool & ancestorsReady )
+{
+    if ( item->keyOnly ) {
+        // bucket lookup already compared the only rule
+        if ( !node->isRoot() )
+            item->selector->applyDeclaration( style );
+        return;
+    }
+    if ( item->ancestors ) {
+        if ( !ancestorsReady ) {
+            ancestors = getAncestorsMask( node );
+            ancestorsReady = true;
+        }
+        if ( (ancestors & item->ancestors) != item->ancestors )
+            return; // some of > or space rules cannot match
+    }
+    item->selector->apply( node, style );
+}
+
 void LVStyleSheet::apply( const ldomNode * node, css_style_rec_t * style )
 {
     if (!_selectors.length())
         return; // no rules!
-        
+
+    if ( !_index )
+        _index = new LVCssSelectorIndex( _selectors );
+
     lUInt16 id = node->getNodeId();
-    
-    LVCssSelector * selector_0 = _selectors[0];
-    LVCssSelector * selector_id = id>0 && id<_selectors.length() ? _selectors[id] : NULL;
+
+    LVCssSelectorChainIndex * chain_0 = _index->getChain(0);
+    LVCssSelectorChainIndex * chain_id = id>0 ? _index->getChain(id) : NULL;
+    if ( !chain_0 && !chain_id )
+        return;
+
+    // class and id values are compared once per element, not once per selector
+    lString16 nodeClass;
+    lString16 nodeId;
+    if ( (chain_0 && chain_0->hasClassBuckets()) || (chain_id && chain_id->hasClassBuckets()) ) {
+        nodeClass = node->getAttributeValue(attr_class);
+        nodeClass.lowercase();
+    }
+    if ( (chain_0 && chain_0->hasIdBuckets()) || (chain_id && chain_id->hasIdBuckets()) )
+        nodeId = node->getAttributeValue(attr_id);
+
+    LVCssSelectorCursor selector_0( chain_0, nodeClass, nodeId );
+    LVCssSelectorCursor selector_id( chain_id, nodeClass, nodeId );
+    lUInt32 ancestors = 0;
+    bool ancestorsReady = false;
 
     for (;;)
     {
-        if (selector_0!=NULL)
+        const LVCssSelectorIndexItem * item_0 = selector_0.get();
+        const LVCssSelectorIndexItem * item_id = selector_id.get();
+        if (item_0!=NULL)
         {
-            if (selector_id==NULL || selector_0->getSpecificity() < selector_id->getSpecificity() )
+            if (item_id==NULL || item_0->selector->getSpecificity() < item_id->selector->getSpecificity() )
             {
                 // step by sel_0
-                selector_0->apply( node, style );
-                selector_0 = selector_0->getNext();
+                applyIndexItem( item_0, node, style, ancestors, ancestorsReady );
+                selector_0.next();
             }
             else
             {
                 // step by sel_id
-                selector_id->apply( node, style );
-                selector_id = selector_id->getNext();
+                applyIndexItem( item_id, node, style, ancestors, ancestorsReady );
+                selector_id.next();
             }
         }
-        else if (selector_id!=NULL)
+        else if (item_id!=NULL)
         {
             // step by sel_id
-            selector_id->apply( node, style );
-            selector_id = selector_id->getNext();
+            applyIndexItem( item_id, node, style, ancestors, ancestorsReady );
+            selector_id.next();
         }
         else
         {
@@ -1362,6 +1581,7 @@ lUInt32 LVStyleSheet::getHash()
 
 bool LVStyleSheet::parse( const char * str )
 {
+    invalidateIndex();
     LVCssSelector * selector = NULL;
     LVCssSelector * prev_selector;
     int err_count = 0;
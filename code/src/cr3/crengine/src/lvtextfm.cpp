@@ -22,6 +22,7 @@
 #ifdef __cplusplus
 #include "../include/lvimg.h"
 #include "../include/lvtinydom.h"
+#include "../include/lvthread.h"
 #endif
 
 #define MIN_SPACE_CONDENSING_PERCENT 50
@@ -252,14 +253,113 @@ void LFormattedText::AddSourceObject(
         flags, interval, margin, object, letter_spacing );
 }
 
+#define STATIC_BUFS_SIZE 8192
+#define ITEMS_RESERVED 16
+#define MAX_TEXT_CHUNK_SIZE 4096
+#define MAX_WORD_SIZE 64
+/// max number of idle buffer sets kept for reuse
+#define FORMATTER_BUFFERS_POOL_SIZE 4
+
+/// paragraph buffers of LVFormatter, one set per formatter in use
+struct LVFormatterBuffers {
+    int       size;
+    lChar16 * text;
+    lUInt8 *  flags;
+    src_text_fragment_t * * srcs;
+    lUInt16 * charindex;
+    int *     widths;
+    /// measureText() chunk results
+    lUInt16   chunkWidths[MAX_TEXT_CHUNK_SIZE+1];
+    lUInt8    chunkFlags[MAX_TEXT_CHUNK_SIZE+1];
+    /// hyphenation word widths
+    lUInt16   wordWidths[MAX_WORD_SIZE];
+    LVFormatterBuffers * next;
+
+    LVFormatterBuffers()
+    : size(0), text(NULL), flags(NULL), srcs(NULL), charindex(NULL), widths(NULL), next(NULL)
+    {
+        reserve( STATIC_BUFS_SIZE );
+    }
+    ~LVFormatterBuffers()
+    {
+        free( text );
+        free( flags );
+        free( srcs );
+        free( charindex );
+        free( widths );
+    }
+    /// ensure buffers can hold at least len items
+    void reserve( int len )
+    {
+        if ( len<=size )
+            return;
+        size = len;
+        text = (lChar16*)realloc(text, sizeof(lChar16)*size);
+        flags = (lUInt8*)realloc(flags, sizeof(lUInt8)*size);
+        charindex = (lUInt16*)realloc(charindex, sizeof(lUInt16)*size);
+        srcs = (src_text_fragment_t **)realloc(srcs, sizeof(src_text_fragment_t *)*size);
+        widths = (int*)realloc(widths, sizeof(int)*size);
+    }
+};
+
+/// pool of idle formatter buffers: keeps LVFormatter reentrant without reallocating per paragraph
+class LVFormatterBuffersPool {
+    LVMutex _mutex;
+    LVFormatterBuffers * _free;
+    int _count;
+public:
+    LVFormatterBuffersPool() : _free(NULL), _count(0) { }
+    ~LVFormatterBuffersPool()
+    {
+        while ( _free ) {
+            LVFormatterBuffers * p = _free;
+            _free = p->next;
+            delete p;
+        }
+    }
+    LVFormatterBuffers * acquire()
+    {
+        {
+            LVLock lock( _mutex );
+            if ( _free ) {
+                LVFormatterBuffers * p = _free;
+                _free = p->next;
+                p->next = NULL;
+                _count--;
+                return p;
+            }
+        }
+        return new LVFormatterBuffers();
+    }
+    void release( LVFormatterBuffers * p )
+    {
+        if ( !p )
+            return;
+        {
+            LVLock lock( _mutex );
+            // don't keep huge paragraph buffers around
+            if ( _count<FORMATTER_BUFFERS_POOL_SIZE && p->size<=STATIC_BUFS_SIZE ) {
+                p->next = _free;
+                _free = p;
+                _count++;
+                return;
+            }
+        }
+        delete p;
+    }
+};
+
+static LVFormatterBuffersPool & formatterBuffersPool()
+{
+    static LVFormatterBuffersPool pool;
+    return pool;
+}
+
 class LVFormatter {
 public:
-    //LVArray<lUInt16>  widths_buf;
-    //LVArray<lUInt8>   flags_buf;
     formatted_text_fragment_t * m_pbuffer;
     int       m_length;
-    int       m_size;
-    bool      m_staticBufs;
+    LVFormatterBuffers * m_bufs;
     lChar16 * m_text;
     lUInt8 *  m_flags;
     src_text_fragment_t * * m_srcs;
@@ -270,7 +370,7 @@ public:
 #define OBJECT_CHAR_INDEX ((lUInt16)0xFFFF)
 
     LVFormatter(formatted_text_fragment_t * pbuffer)
-    : m_pbuffer(pbuffer), m_length(0), m_size(0), m_staticBufs(true), m_y(0)
+    : m_pbuffer(pbuffer), m_length(0), m_bufs(NULL), m_y(0)
     {
         m_text = NULL;
         m_flags = NULL;
@@ -281,6 +381,7 @@ public:
 
     ~LVFormatter()
     {
+        dealloc();
     }
 
     /// allocate buffers for paragraph
@@ -303,33 +404,15 @@ public:
 
         TR("allocate(%d)", m_length);
 
-#define STATIC_BUFS_SIZE 8192
-#define ITEMS_RESERVED 16
-        if ( !m_staticBufs || m_length>STATIC_BUFS_SIZE-1 ) {
-            if ( m_length+ITEMS_RESERVED>m_size ) {
-                // realloc
-                m_size = m_length+ITEMS_RESERVED;
-                m_text = (lChar16*)realloc(m_text, sizeof(lChar16)*m_size);
-                m_flags = (lUInt8*)realloc(m_flags, sizeof(lUInt8)*m_size);
-                m_charindex = (lUInt16*)realloc(m_charindex, sizeof(lUInt16)*m_size);
-                m_srcs = (src_text_fragment_t **)realloc(m_srcs, sizeof(src_text_fragment_t *)*m_size);
-                m_widths = (int*)realloc(m_widths, sizeof(int)*m_size);
-            }
-            m_staticBufs = false;
-        } else {
-            // static buffer space
-            static lChar16 m_static_text[STATIC_BUFS_SIZE];
-            static lUInt8 m_static_flags[STATIC_BUFS_SIZE];
-            static src_text_fragment_t * m_static_srcs[STATIC_BUFS_SIZE];
-            static lUInt16 m_static_charindex[STATIC_BUFS_SIZE];
-            static int m_static_widths[STATIC_BUFS_SIZE];
-            m_text = m_static_text;
-            m_flags = m_static_flags;
-            m_charindex = m_static_charindex;
-            m_srcs = m_static_srcs;
-            m_widths = m_static_widths;
-            m_staticBufs = true;
-        }
+        if ( !m_bufs )
+            m_bufs = formatterBuffersPool().acquire();
+        if ( m_length+ITEMS_RESERVED>m_bufs->size )
+            m_bufs->reserve( m_length+ITEMS_RESERVED );
+        m_text = m_bufs->text;
+        m_flags = m_bufs->flags;
+        m_charindex = m_bufs->charindex;
+        m_srcs = m_bufs->srcs;
+        m_widths = m_bufs->widths;
         memset( m_flags, 0, sizeof(lUInt8)*m_length );
         pos = 0;
     }
@@ -473,9 +556,8 @@ public:
         src_text_fragment_t * lastSrc = NULL;
         int start = 0;
         int lastWidth = 0;
-#define MAX_TEXT_CHUNK_SIZE 4096
-        static lUInt16 widths[MAX_TEXT_CHUNK_SIZE+1];
-        static lUInt8 flags[MAX_TEXT_CHUNK_SIZE+1];
+        lUInt16 * widths = m_bufs->chunkWidths;
+        lUInt8 * flags = m_bufs->chunkFlags;
         int tabIndex = -1;
         for ( i=0; i<=m_length; i++ ) {
             LVFont * newFont = NULL;
@@ -565,7 +647,6 @@ public:
     }
 
 #define MIN_WORD_LEN_TO_HYPHENATE 4
-#define MAX_WORD_SIZE 64
 
     /// align line
     void alignLine( formatted_line_t * frmline, int width, int alignment ) {
@@ -898,8 +979,8 @@ public:
         if ( visualAlignmentEnabled ) {
             LVFont * font = NULL;
             for ( int i=start; i<end; i++ ) {
-                if ( !(m_srcs[i]->flags & LTEXT_SRC_IS_OBJECT) ) {
-                    font = (LVFont*)m_srcs[i]->t.font;
+                if ( !(m_pbuffer->srctext[i].flags & LTEXT_SRC_IS_OBJECT) ) {
+                    font = (LVFont*)m_pbuffer->srctext[i].t.font;
                     int dx = font->getVisualAligmentWidth();
                     if ( dx>visialAlignmentWidth )
                         visialAlignmentWidth = dx;
@@ -974,7 +1055,7 @@ public:
                     if ( len > MAX_WORD_SIZE )
                         len = MAX_WORD_SIZE;
                     lUInt8 * flags = m_flags + start;
-                    static lUInt16 widths[MAX_WORD_SIZE];
+                    lUInt16 * widths = m_bufs->wordWidths;
                     int wordStart_w = start>0 ? m_widths[start-1] : 0;
                     for ( int i=0; i<len; i++ ) {
                         widths[i] = m_widths[start+i] - wordStart_w;
@@ -1049,18 +1130,14 @@ public:
 
     void dealloc()
     {
-        if ( !m_staticBufs ) {
-            free( m_text );
-            free( m_flags );
-            free( m_srcs );
-            free( m_charindex );
-            free( m_widths );
+        if ( m_bufs ) {
+            formatterBuffersPool().release( m_bufs );
+            m_bufs = NULL;
             m_text = NULL;
             m_flags = NULL;
             m_srcs = NULL;
             m_charindex = NULL;
             m_widths = NULL;
-            m_staticBufs = true;
         }
     }
 
@@ -1124,6 +1201,21 @@ void LFormattedText::setMinSpaceCondensingPercent(int minSpaceWidthPercent)
         m_pbuffer->min_space_condensing_percent = minSpaceWidthPercent;
 }
 
+int LFormattedText::GetMemorySize()
+{
+    int size = sizeof(LFormattedText) + sizeof(formatted_text_fragment_t)
+        + m_pbuffer->srctextlen * sizeof(src_text_fragment_t)
+        + m_pbuffer->frmlinecount * (sizeof(formatted_line_t) + sizeof(formatted_line_t*));
+    for ( lUInt32 i=0; i<m_pbuffer->srctextlen; i++ ) {
+        const src_text_fragment_t & src = m_pbuffer->srctext[i];
+        if ( (src.flags & LTEXT_FLAG_OWNTEXT) && !(src.flags & LTEXT_SRC_IS_OBJECT) )
+            size += src.t.len * sizeof(lChar16);
+    }
+    for ( lUInt32 i=0; i<m_pbuffer->frmlinecount; i++ )
+        size += m_pbuffer->frmlines[i]->word_count * sizeof(formatted_word_t);
+    return size;
+}
+
 void LFormattedText::Draw( LVDrawBuf * buf, int x, int y, ldomMarkedRangeList * marks, ldomMarkedRangeList *bookmarks )
 {
     lUInt32 i, j;
@@ -12,7 +12,7 @@
 *******************************************************/
 
 /// change in case of incompatible changes in swap/cache file format to avoid using incompatible swap file
-#define CACHE_FILE_FORMAT_VERSION "3.04.06"
+#define CACHE_FILE_FORMAT_VERSION "3.04.07"
 
 #ifndef DOC_DATA_COMPRESSION_LEVEL
 /// data compression level (0=no compression, 1=fast compressions, 3=normal compression)
@@ -56,6 +56,39 @@
 #define COMPRESS_PAGES_DATA         true
 #define COMPRESS_TOC_DATA           true
 #define COMPRESS_STYLE_DATA         true
+#define COMPRESS_SEARCH_INDEX_DATA  true
+
+/// full text search index: amount of text characters per index block, and size of block n-gram bitmap in bits (power of 2)
+#ifndef SEARCH_INDEX_BLOCK_CHARS
+#define SEARCH_INDEX_BLOCK_CHARS 2048
+#endif
+#ifndef SEARCH_INDEX_BLOCK_BITS
+#define SEARCH_INDEX_BLOCK_BITS  4096
+#endif
+#define SEARCH_INDEX_BLOCK_WORDS (SEARCH_INDEX_BLOCK_BITS/32)
+
+/// cache file block compression codecs, stored in CacheFileItem::_codec
+#define CACHE_CODEC_NONE 0
+#define CACHE_CODEC_ZLIB 1  /// deflate, DOC_DATA_COMPRESSION_LEVEL
+#define CACHE_CODEC_LZ   2  /// fast LZ4-style block codec
+
+/// codecs for node storage chunks, which are swapped in and out during page navigation
+#ifndef TEXT_DATA_CODEC
+#define TEXT_DATA_CODEC  CACHE_CODEC_LZ
+#endif
+#ifndef ELEM_DATA_CODEC
+#define ELEM_DATA_CODEC  CACHE_CODEC_LZ
+#endif
+#ifndef RECT_DATA_CODEC
+#define RECT_DATA_CODEC  CACHE_CODEC_LZ
+#endif
+#ifndef STYLE_DATA_CODEC
+#define STYLE_DATA_CODEC CACHE_CODEC_LZ
+#endif
+/// codec for the rest of blocks (node tables, pages, TOC, properties), read once per document open
+#ifndef MISC_DATA_CODEC
+#define MISC_DATA_CODEC  CACHE_CODEC_ZLIB
+#endif
 
 //#define CACHE_FILE_SECTOR_SIZE 4096
 #define CACHE_FILE_SECTOR_SIZE 1024
@@ -68,6 +101,14 @@
 #ifndef ENABLE_CACHE_FILE_CONTENTS_VALIDATION
 #define ENABLE_CACHE_FILE_CONTENTS_VALIDATION 0
 #endif
+/// set to 1 to read blocks of existing cache file through read-only memory mapping
+#ifndef CACHE_FILE_MMAP
+#if defined(_WIN32) || defined(_LINUX)
+#define CACHE_FILE_MMAP 1
+#else
+#define CACHE_FILE_MMAP 0
+#endif
+#endif
 
 #define RECT_DATA_CHUNK_ITEMS_SHIFT 11
 #define STYLE_DATA_CHUNK_ITEMS_SHIFT 12
@@ -123,6 +164,7 @@ enum CacheFileBlockType {
     CBT_STYLE_DATA,
     CBT_BLOB_INDEX, //15
     CBT_BLOB_DATA,
+    CBT_SEARCH_INDEX, //17
 };
 
 
@@ -140,6 +182,21 @@ enum CacheFileBlockType {
 #include <stddef.h>
 #include <math.h>
 #include <zlib.h>
+#include "../include/lvthread.h"
+
+/// set to 1 to write cache file blocks in background thread, so that saving of cache doesn't delay reading
+#ifndef CACHE_FILE_ASYNC_WRITE
+#if (CR_USE_THREADS==1)
+#define CACHE_FILE_ASYNC_WRITE 1
+#else
+#define CACHE_FILE_ASYNC_WRITE 0
+#endif
+#endif
+
+/// max size of block data waiting for background cache writer, bytes; writing of new block waits when exceeded
+#ifndef CACHE_FILE_WRITE_QUEUE_SIZE
+#define CACHE_FILE_WRITE_QUEUE_SIZE 0x200000 // 2Mb
+#endif
 
 // define to store new text nodes as persistent text, instead of mutable
 #define USE_PERSISTENT_TEXT 1
@@ -231,6 +288,10 @@ public:
 bool ldomPack( const lUInt8 * buf, int bufsize, lUInt8 * &dstbuf, lUInt32 & dstsize );
 /// unpack data from _compbuf to _buf
 bool ldomUnpack( const lUInt8 * compbuf, int compsize, lUInt8 * &dstbuf, lUInt32 & dstsize  );
+/// pack data with fast LZ codec, fails if data is not compressible
+bool ldomPackLZ( const lUInt8 * buf, int bufsize, lUInt8 * &dstbuf, lUInt32 & dstsize );
+/// unpack data packed with fast LZ codec, dstsize is expected size of unpacked data
+bool ldomUnpackLZ( const lUInt8 * compbuf, int compsize, lUInt8 * &dstbuf, lUInt32 dstsize );
 
 
 #if BUILD_LITE!=1
@@ -311,6 +372,7 @@ struct CacheFileItem
     lUInt64 _dataHash; // additional hash of data
     lUInt64 _packedHash; // additional hash of packed data
     lUInt32 _uncompressedSize;   // size of uncompressed block, if compression is applied, 0 if no compression
+    lUInt32 _codec;    // compression codec, CACHE_CODEC_*
     bool validate( int fsize )
     {
         if ( _magic!=CACHE_FILE_ITEM_MAGIC ) {
@@ -337,6 +399,7 @@ struct CacheFileItem
     , _dataHash(0)          // hash of data
     , _packedHash(0) // additional hash of packed data
     , _uncompressedSize(0)  // size of uncompressed block, if compression is applied, 0 if no compression
+    , _codec(CACHE_CODEC_NONE) // compression codec
     {
     }
 };
@@ -381,11 +444,78 @@ struct CacheFileHeader : public SimpleCacheFileHeader
     }
 };
 
+#if CACHE_FILE_ASYNC_WRITE==1
+class CacheFile;
+
+/// background writer of cache file blocks: keeps copies of posted blocks until they are written
+class CacheFileWriter : public LVThread {
+    struct Item {
+        lUInt16 type;
+        lUInt16 index;
+        lUInt8 * data;
+        int size;
+        bool compress;
+        bool busy; // being written, data may not be replaced
+        Item( lUInt16 t, lUInt16 i, const lUInt8 * buf, int sz, bool c )
+        : type(t), index(i), data(NULL), size(0), compress(c), busy(false)
+        {
+            setData( buf, sz );
+        }
+        ~Item()
+        {
+            if ( data )
+                free( data );
+        }
+        void setData( const lUInt8 * buf, int sz )
+        {
+            if ( data )
+                free( data );
+            data = (lUInt8 *)malloc( sz>0 ? sz : 1 );
+            if ( sz>0 )
+                memcpy( data, buf, sz );
+            size = sz;
+        }
+    };
+    CacheFile * _file;
+    LVMutex _queueMutex;
+    LVEvent _postEvent; // new block is posted, or stop is requested
+    LVEvent _doneEvent; // block is written
+    LVPtrVector<Item> _queue;
+    int _queuedBytes;
+    bool _stopRequested;
+    // returns last posted item for block, NULL if not found
+    Item * findItem( lUInt16 type, lUInt16 index );
+protected:
+    virtual void run();
+public:
+    CacheFileWriter( CacheFile * file )
+    : _file(file), _queuedBytes(0), _stopRequested(false)
+    {
+    }
+    /// queues copy of block data for writing, replaces not yet written data of the same block
+    void post( lUInt16 type, lUInt16 index, const lUInt8 * buf, int size, bool compress );
+    /// returns copy of block data which is not written yet, false if there is no such block in queue
+    bool get( lUInt16 type, lUInt16 index, lUInt8 * &buf, int &size );
+    /// returns true if block is waiting for writing
+    bool hasBlock( lUInt16 type, lUInt16 index );
+    /// waits until all posted blocks are written; returns false if timer is expired first
+    bool waitForWrites( CRTimerUtil & maxTime );
+    /// waits for block being written, discards the rest of queue and finishes thread
+    void stop();
+};
+#endif
+
 /**
  * Cache file implementation.
  */
 class CacheFile
 {
+#if CACHE_FILE_ASYNC_WRITE==1
+    friend class CacheFileWriter;
+    CacheFileWriter * _writer; // background writer, NULL to write blocks immediately
+    bool _writeError; // writing of some posted block is failed
+#endif
+    LVMutex _mutex; // protects file stream and index, when blocks are written in background
     int _sectorSize; // block position and size granularity
     int _size;
     bool _indexChanged;
@@ -394,6 +524,15 @@ class CacheFile
     LVPtrVector<CacheFileItem, true> _index; // full file block index
     LVPtrVector<CacheFileItem, false> _freeIndex; // free file block index
     LVHashTable<lUInt32, CacheFileItem*> _map; // hash map for fast search
+    LVStreamBufferRef _mapBuf; // read-only mapping of file contents existing on open
+    const lUInt8 * _mapData; // mapped data, NULL if mapping is not available
+    int _mapSize; // size of mapped data
+    // maps existing file contents to memory, for reading w/o copying
+    void mapFile();
+    // stops reading through mapping, e.g. when mapped area is overwritten
+    void unmapFile();
+    // returns pointer to block data inside mapping, NULL if block is not mapped
+    const lUInt8 * getMappedData( CacheFileItem * block );
     // searches for existing block
     CacheFileItem * findBlock( lUInt16 type, lUInt16 index );
     // alocates block at index, reuses existing one, if possible
@@ -408,9 +547,13 @@ class CacheFile
     bool readIndex();
     // reads all blocks of index and checks CRCs
     bool validateContents();
+    // packs and writes block to file
+    bool writeBlock( lUInt16 type, lUInt16 dataIndex, const lUInt8 * buf, int size, bool compress );
+    // starts background writer, if enabled
+    void startWriter();
 public:
     // return current file size
-    int getSize() { return _size; }
+    int getSize() { LVLock lock( _mutex ); return _size; }
     // create uninitialized cache file, call open or create to initialize
     CacheFile();
     // free resources
@@ -445,6 +588,25 @@ public:
     }
     /// reads block as a stream
     LVStreamRef readStream(lUInt16 type, lUInt16 index);
+    /// returns true if file contains block of specified type, for optional blocks
+    bool hasBlock( lUInt16 type, lUInt16 index = 0 )
+    {
+#if CACHE_FILE_ASYNC_WRITE==1
+        if ( _writer && _writer->hasBlock( type, index ) )
+            return true;
+#endif
+        LVLock lock( _mutex );
+        return findBlock( type, index ) != NULL;
+    }
+    /// waits until blocks posted by write() are written to file; returns false if timer is expired first
+    bool waitForWrites( CRTimerUtil & maxTime )
+    {
+#if CACHE_FILE_ASYNC_WRITE==1
+        if ( _writer )
+            return _writer->waitForWrites( maxTime );
+#endif
+        return true;
+    }
 
     /// sets dirty flag value, returns true if value is changed
     bool setDirtyFlag( bool dirty );
@@ -455,6 +617,7 @@ public:
         return (n + (_sectorSize-1)) & ~(_sectorSize-1);
     }
     void setAutoSyncSize(int sz) {
+        LVLock lock( _mutex );
         _stream->setAutoSyncSize(sz);
     }
 };
@@ -462,13 +625,67 @@ public:
 
 // create uninitialized cache file, call open or create to initialize
 CacheFile::CacheFile()
-: _sectorSize( CACHE_FILE_SECTOR_SIZE ), _size(0), _indexChanged(false), _dirty(true), _map(1024)
+:
+#if CACHE_FILE_ASYNC_WRITE==1
+  _writer(NULL), _writeError(false),
+#endif
+  _sectorSize( CACHE_FILE_SECTOR_SIZE ), _size(0), _indexChanged(false), _dirty(true), _map(1024)
+, _mapData(NULL), _mapSize(0)
+{
+}
+
+// maps existing file contents to memory, for reading w/o copying
+void CacheFile::mapFile()
 {
+#if CACHE_FILE_MMAP==1
+    unmapFile();
+    const lChar16 * name = _stream->GetName();
+    if ( !name || !name[0] || _size<=0 )
+        return;
+    LVStreamRef mapStream = LVMapFileStream( name, LVOM_READ, 0 );
+    if ( mapStream.isNull() )
+        return;
+    int size = (int)mapStream->GetSize();
+    if ( size>_size )
+        size = _size;
+    _mapBuf = mapStream->GetReadBuffer( 0, size );
+    if ( _mapBuf.isNull() || !_mapBuf->getReadOnly() ) {
+        _mapBuf.Clear();
+        return;
+    }
+    _mapData = _mapBuf->getReadOnly();
+    _mapSize = size;
+    CRLog::debug("CacheFile: %d bytes of file are mapped for reading", _mapSize);
+#endif
+}
+
+// stops reading through mapping, e.g. when mapped area is overwritten
+void CacheFile::unmapFile()
+{
+    _mapBuf.Clear();
+    _mapData = NULL;
+    _mapSize = 0;
+}
+
+// returns pointer to block data inside mapping, NULL if block is not mapped
+const lUInt8 * CacheFile::getMappedData( CacheFileItem * block )
+{
+    if ( !_mapData || block->_blockFilePos<0 || block->_dataSize<0 || block->_blockFilePos + block->_dataSize > _mapSize )
+        return NULL;
+    return _mapData + block->_blockFilePos;
 }
 
 // free resources
 CacheFile::~CacheFile()
 {
+#if CACHE_FILE_ASYNC_WRITE==1
+    if ( _writer ) {
+        // blocks not written yet are dropped: index in file doesn't refer them
+        _writer->stop();
+        delete _writer;
+        _writer = NULL;
+    }
+#endif
     if ( !_stream.isNull() ) {
         // don't flush -- leave file dirty
         //CRTimerUtil infinite;
@@ -503,11 +720,25 @@ bool CacheFile::setDirtyFlag( bool dirty )
 bool CacheFile::flush( bool clearDirtyFlag, CRTimerUtil & maxTime )
 {
     if ( clearDirtyFlag ) {
+        // index is written once, after all blocks it refers
+        CRTimerUtil infinite;
+        waitForWrites( infinite );
+        LVLock lock( _mutex );
+#if CACHE_FILE_ASYNC_WRITE==1
+        if ( _writeError ) {
+            CRLog::error("CacheFile::flush: some blocks were not written, leaving file dirty");
+            _writeError = false;
+            return false;
+        }
+#endif
+        if ( !_mapData )
+            unmapFile();
         //setDirtyFlag(true);
         if ( !writeIndex() )
             return false;
         setDirtyFlag(false);
     } else {
+        LVLock lock( _mutex );
         _stream->Flush(false, maxTime);
         //CRLog::trace("CacheFile->flush() took %d ms ", (int)timer.elapsed());
     }
@@ -630,7 +861,7 @@ bool CacheFile::writeIndex()
             index[i]._dataSize = 0;
         }
     }
-    bool res = write(CBT_INDEX, 0, (const lUInt8*)index, sz, false);
+    bool res = writeBlock(CBT_INDEX, 0, (const lUInt8*)index, sz, false);
     delete[] index;
 
     indexItem = findBlock(CBT_INDEX, 0);
@@ -673,6 +904,19 @@ void CacheFile::freeBlock( CacheFileItem * block )
 /// reads block as a stream
 LVStreamRef CacheFile::readStream(lUInt16 type, lUInt16 index)
 {
+#if CACHE_FILE_ASYNC_WRITE==1
+    if ( _writer ) {
+        // file stream position is changed by background writer: return copy of block data
+        lUInt8 * buf = NULL;
+        int size = 0;
+        if ( !hasBlock(type, index) || !read(type, index, buf, size) )
+            return LVStreamRef();
+        LVStreamRef res = LVCreateMemoryStream(buf, size, true);
+        free(buf);
+        return res;
+    }
+#endif
+    LVLock lock( _mutex );
     CacheFileItem * block = findBlock(type, index);
     if (block && block->_dataSize) {
 #if 0
@@ -783,25 +1027,36 @@ bool CacheFile::read( lUInt16 type, lUInt16 dataIndex, lUInt8 * &buf, int &size
 {
     buf = NULL;
     size = 0;
+#if CACHE_FILE_ASYNC_WRITE==1
+    if ( _writer && _writer->get( type, dataIndex, buf, size ) )
+        return true;
+#endif
+    LVLock lock( _mutex );
     CacheFileItem * block = findBlock( type, dataIndex );
     if ( !block ) {
         CRLog::error("CacheFile::read: Block %d:%d not found in file", type, dataIndex);
         return false;
     }
-    if ( (int)_stream->SetPos( block->_blockFilePos )!=block->_blockFilePos )
-        return false;
 
-    // read block from file
     size = block->_dataSize;
-    buf = (lUInt8 *)malloc(size);
-    lvsize_t bytesRead = 0;
-    _stream->Read(buf, size, &bytesRead );
-    if ( (int)bytesRead!=size ) {
-        CRLog::error("CacheFile::read: Cannot read block %d:%d of size %d", type, dataIndex, (int)size);
-        free(buf);
-        buf = NULL;
-        size = 0;
-        return false;
+    // block data: mapped file area if available, or block read from file
+    const lUInt8 * data = getMappedData( block );
+    lUInt8 * filebuf = NULL;
+    if ( !data ) {
+        if ( (int)_stream->SetPos( block->_blockFilePos )!=block->_blockFilePos )
+            return false;
+
+        // read block from file
+        filebuf = (lUInt8 *)malloc(size);
+        lvsize_t bytesRead = 0;
+        _stream->Read(filebuf, size, &bytesRead );
+        if ( (int)bytesRead!=size ) {
+            CRLog::error("CacheFile::read: Cannot read block %d:%d of size %d", type, dataIndex, (int)size);
+            free(filebuf);
+            size = 0;
+            return false;
+        }
+        data = filebuf;
     }
 
     bool compress = block->_uncompressedSize!=0;
@@ -810,11 +1065,11 @@ bool CacheFile::read( lUInt16 type, lUInt16 dataIndex, lUInt8 * &buf, int &size
         // block is compressed
 
         // check crc separately only for compressed data
-        lUInt64 packedhash = calcHash64( buf, size );
+        lUInt64 packedhash = calcHash64( data, size );
         if ( packedhash!=block->_packedHash ) {
             CRLog::error("CacheFile::read: packed data CRC doesn't match for block %d:%d of size %d", type, dataIndex, (int)size);
-            free(buf);
-            buf = NULL;
+            if ( filebuf )
+                free(filebuf);
             size = 0;
             return false;
         }
@@ -822,17 +1077,31 @@ bool CacheFile::read( lUInt16 type, lUInt16 dataIndex, lUInt8 * &buf, int &size
         // uncompress block data
         lUInt8 * uncomp_buf = NULL;
         lUInt32 uncomp_size = 0;
-        if ( ldomUnpack(buf, size, uncomp_buf, uncomp_size) && uncomp_size==block->_uncompressedSize ) {
-            free( buf );
+        bool unpacked = false;
+        if ( block->_codec==CACHE_CODEC_LZ ) {
+            uncomp_size = block->_uncompressedSize;
+            unpacked = ldomUnpackLZ(data, size, uncomp_buf, uncomp_size);
+        } else {
+            unpacked = ldomUnpack(data, size, uncomp_buf, uncomp_size);
+        }
+        if ( filebuf )
+            free( filebuf );
+        if ( unpacked && uncomp_size==block->_uncompressedSize ) {
             buf = uncomp_buf;
             size = uncomp_size;
         } else {
             CRLog::error("CacheFile::read: error while uncompressing data for block %d:%d of size %d", type, dataIndex, (int)size);
-            free(buf);
-            buf = NULL;
+            if ( uncomp_buf )
+                free( uncomp_buf );
             size = 0;
             return false;
         }
+    } else if ( filebuf ) {
+        buf = filebuf;
+    } else {
+        // caller owns and may modify returned buffer: copy from mapping
+        buf = (lUInt8 *)malloc(size);
+        memcpy( buf, data, size );
     }
 
     // check CRC
@@ -848,37 +1117,77 @@ bool CacheFile::read( lUInt16 type, lUInt16 dataIndex, lUInt8 * &buf, int &size
     return true;
 }
 
+/// returns compression codec to use for blocks of specified type
+static int getBlockCodec( lUInt16 type )
+{
+    switch ( type ) {
+    case CBT_TEXT_DATA:
+        return TEXT_DATA_CODEC;
+    case CBT_ELEM_DATA:
+        return ELEM_DATA_CODEC;
+    case CBT_RECT_DATA:
+        return RECT_DATA_CODEC;
+    case CBT_ELEM_STYLE_DATA:
+        return STYLE_DATA_CODEC;
+    default:
+        return MISC_DATA_CODEC;
+    }
+}
+
 // writes block to file
 bool CacheFile::write( lUInt16 type, lUInt16 dataIndex, const lUInt8 * buf, int size, bool compress )
+{
+#if CACHE_FILE_ASYNC_WRITE==1
+    if ( _writer ) {
+        // errors are reported by flush()
+        _writer->post( type, dataIndex, buf, size, compress );
+        return true;
+    }
+#endif
+    return writeBlock( type, dataIndex, buf, size, compress );
+}
+
+// packs and writes block to file; data is packed w/o holding lock, to let reading go on meanwhile
+bool CacheFile::writeBlock( lUInt16 type, lUInt16 dataIndex, const lUInt8 * buf, int size, bool compress )
 {
     // check whether data is changed
     lUInt64 newhash = calcHash64( buf, size );
-    CacheFileItem * existingblock = findBlock( type, dataIndex );
+    {
+        LVLock lock( _mutex );
+        CacheFileItem * existingblock = findBlock( type, dataIndex );
 
-    if (existingblock) {
-        bool sameSize = ((int)existingblock->_uncompressedSize==size) || (existingblock->_uncompressedSize==0 && (int)existingblock->_dataSize==size);
-        if (sameSize && existingblock->_dataHash == newhash ) {
-            return true;
+        if (existingblock) {
+            bool sameSize = ((int)existingblock->_uncompressedSize==size) || (existingblock->_uncompressedSize==0 && (int)existingblock->_dataSize==size);
+            if (sameSize && existingblock->_dataHash == newhash ) {
+                return true;
+            }
         }
-    }
 
 #if 1
-    if (existingblock)
-        CRLog::trace("*    oldsz=%d oldhash=%08x", (int)existingblock->_uncompressedSize, (int)existingblock->_dataHash);
-    CRLog::trace("* wr block t=%d[%d] sz=%d hash=%08x", type, dataIndex, size, newhash);
+        if (existingblock)
+            CRLog::trace("*    oldsz=%d oldhash=%08x", (int)existingblock->_uncompressedSize, (int)existingblock->_dataHash);
+        CRLog::trace("* wr block t=%d[%d] sz=%d hash=%08x", type, dataIndex, size, newhash);
 #endif
-    setDirtyFlag(true);
+    }
 
     lUInt32 uncompressedSize = 0;
     lUInt64 newpackedhash = newhash;
+    int codec = CACHE_CODEC_NONE;
 #if DOC_DATA_COMPRESSION_LEVEL==0
     compress = false;
 #else
     if ( compress ) {
         lUInt8 * dstbuf = NULL;
         lUInt32 dstsize = 0;
-        if ( !ldomPack( buf, size, dstbuf, dstsize ) ) {
+        codec = getBlockCodec( type );
+        bool packed = false;
+        if ( codec==CACHE_CODEC_LZ )
+            packed = ldomPackLZ( buf, size, dstbuf, dstsize );
+        else if ( codec==CACHE_CODEC_ZLIB )
+            packed = ldomPack( buf, size, dstbuf, dstsize );
+        if ( !packed ) {
             compress = false;
+            codec = CACHE_CODEC_NONE;
         } else {
             uncompressedSize = size;
             size = dstsize;
@@ -891,6 +1200,9 @@ bool CacheFile::write( lUInt16 type, lUInt16 dataIndex, const lUInt8 * buf, int
     }
 #endif
 
+    LVLock lock( _mutex );
+    setDirtyFlag(true);
+    CacheFileItem * existingblock = findBlock( type, dataIndex );
     CacheFileItem * block = NULL;
     if ( existingblock && existingblock->_dataSize>=size ) {
         // reuse existing block
@@ -903,6 +1215,12 @@ bool CacheFile::write( lUInt16 type, lUInt16 dataIndex, const lUInt8 * buf, int
     }
     if ( !block )
         return false;
+    // mapping may not reflect data written through stream: stop reading from it;
+    // mapping object is released by unmapFile() later, not in background writer thread
+    if ( _mapData && block->_blockFilePos < _mapSize ) {
+        _mapData = NULL;
+        _mapSize = 0;
+    }
     if ( (int)_stream->SetPos( block->_blockFilePos )!=block->_blockFilePos )
         return false;
     // assert: size == block->_dataSize
@@ -936,6 +1254,7 @@ bool CacheFile::write( lUInt16 type, lUInt16 dataIndex, const lUInt8 * buf, int
     block->_dataHash = newhash;
     block->_packedHash = newpackedhash;
     block->_uncompressedSize = uncompressedSize;
+    block->_codec = codec;
 
 #if DOC_DATA_COMPRESSION_LEVEL!=0
     if ( compress ) {
@@ -997,6 +1316,8 @@ bool CacheFile::open( LVStreamRef stream )
         return false;
     }
 #endif
+    mapFile();
+    startWriter();
     return true;
 }
 
@@ -1033,9 +1354,148 @@ bool CacheFile::create( LVStreamRef stream )
         _stream.Clear();
         return false;
     }
+    startWriter();
     return true;
 }
 
+// starts background writer, if enabled
+void CacheFile::startWriter()
+{
+#if CACHE_FILE_ASYNC_WRITE==1
+    if ( _writer )
+        return;
+    _writer = new CacheFileWriter( this );
+    _writer->start();
+#endif
+}
+
+#if CACHE_FILE_ASYNC_WRITE==1
+// returns last posted item for block, NULL if not found
+CacheFileWriter::Item * CacheFileWriter::findItem( lUInt16 type, lUInt16 index )
+{
+    for ( int i=_queue.length()-1; i>=0; i-- ) {
+        Item * item = _queue[i];
+        if ( item->type==type && item->index==index )
+            return item;
+    }
+    return NULL;
+}
+
+/// queues copy of block data for writing, replaces not yet written data of the same block
+void CacheFileWriter::post( lUInt16 type, lUInt16 index, const lUInt8 * buf, int size, bool compress )
+{
+    // limit memory used by queue: wait until writer catches up
+    for (;;) {
+        {
+            LVLock lock( _queueMutex );
+            if ( _queuedBytes==0 || _queuedBytes + size <= CACHE_FILE_WRITE_QUEUE_SIZE )
+                break;
+        }
+        _doneEvent.wait();
+    }
+    bool wasEmpty;
+    {
+        LVLock lock( _queueMutex );
+        wasEmpty = _queue.length()==0;
+        Item * item = findItem( type, index );
+        if ( item && !item->busy ) {
+            // only last version of block is written
+            _queuedBytes += size - item->size;
+            item->setData( buf, size );
+            item->compress = compress;
+        } else {
+            _queue.add( new Item( type, index, buf, size, compress ) );
+            _queuedBytes += size;
+        }
+    }
+    // writer waits for event only when queue is empty
+    if ( wasEmpty )
+        _postEvent.set();
+}
+
+/// returns copy of block data which is not written yet, false if there is no such block in queue
+bool CacheFileWriter::get( lUInt16 type, lUInt16 index, lUInt8 * &buf, int &size )
+{
+    LVLock lock( _queueMutex );
+    Item * item = findItem( type, index );
+    if ( !item )
+        return false;
+    // caller owns and may modify returned buffer
+    buf = (lUInt8 *)malloc( item->size>0 ? item->size : 1 );
+    memcpy( buf, item->data, item->size );
+    size = item->size;
+    return true;
+}
+
+/// returns true if block is waiting for writing
+bool CacheFileWriter::hasBlock( lUInt16 type, lUInt16 index )
+{
+    LVLock lock( _queueMutex );
+    return findItem( type, index )!=NULL;
+}
+
+/// waits until all posted blocks are written; returns false if timer is expired first
+bool CacheFileWriter::waitForWrites( CRTimerUtil & maxTime )
+{
+    for (;;) {
+        {
+            LVLock lock( _queueMutex );
+            if ( _queue.length()==0 )
+                return true;
+        }
+        if ( maxTime.expired() )
+            return false;
+        _doneEvent.wait();
+    }
+}
+
+/// waits for block being written, discards the rest of queue and finishes thread
+void CacheFileWriter::stop()
+{
+    {
+        LVLock lock( _queueMutex );
+        _stopRequested = true;
+    }
+    _postEvent.set();
+    join();
+    LVLock lock( _queueMutex );
+    _queue.clear();
+    _queuedBytes = 0;
+}
+
+void CacheFileWriter::run()
+{
+    for (;;) {
+        Item * item = NULL;
+        {
+            LVLock lock( _queueMutex );
+            if ( _stopRequested )
+                break;
+            if ( _queue.length()>0 ) {
+                item = _queue[0];
+                item->busy = true;
+            }
+        }
+        if ( !item ) {
+            _postEvent.wait();
+            continue;
+        }
+        if ( !_file->writeBlock( item->type, item->index, item->data, item->size, item->compress ) ) {
+            CRLog::error("CacheFileWriter: cannot write block %d:%d", item->type, item->index);
+            LVLock lock( _file->_mutex );
+            _file->_writeError = true;
+        }
+        {
+            // block is in file now: readers will find it there
+            LVLock lock( _queueMutex );
+            _queuedBytes -= item->size;
+            delete _queue.remove( item );
+        }
+        _doneEvent.set();
+    }
+}
+#endif
+
 // BLOB storage
 
 class ldomBlobItem {
@@ -1448,7 +1908,7 @@ tinyNodeCollection::tinyNodeCollection()
 , _tinyElementCount(0)
 , _itemCount(0)
 #if BUILD_LITE!=1
-, _renderedBlockCache( 32 )
+, _renderedBlockCache( RENDER_BLOCK_CACHE_SIZE )
 , _cacheFile(NULL)
 , _mapped(false)
 , _maperror(false)
@@ -1478,7 +1938,7 @@ tinyNodeCollection::tinyNodeCollection( tinyNodeCollection & v )
 , _tinyElementCount(0)
 , _itemCount(0)
 #if BUILD_LITE!=1
-, _renderedBlockCache( 32 )
+, _renderedBlockCache( RENDER_BLOCK_CACHE_SIZE )
 , _cacheFile(NULL)
 , _mapped(false)
 , _maperror(false)
@@ -2135,7 +2595,7 @@ void ldomDataStorageManager::setRendRectData( lUInt32 elemDataIndex, const lvdom
     // assume storage has raw data chunks
     int index = elemDataIndex>>4; // element sequential index
     int chunkIndex = index >> RECT_DATA_CHUNK_ITEMS_SHIFT;
-    while ( _chunks.length() < chunkIndex ) {
+    while ( _chunks.length() <= chunkIndex ) {
         //if ( _chunks.length()>0 )
         //    _chunks[_chunks.length()-1]->compact();
         _chunks.add( new ldomTextStorageChunk(RECT_DATA_CHUNK_SIZE, this, _chunks.length()) );
@@ -2613,6 +3073,198 @@ bool ldomUnpack( const lUInt8 * compbuf, int compsize, lUInt8 * &dstbuf, lUInt32
     return true;
 }
 
+// fast LZ codec: LZ4 block format (token, literals, 16-bit offset, match length)
+#define LZ_HASH_BITS      12
+#define LZ_MIN_MATCH      4
+#define LZ_MF_LIMIT       12 // no match may start within last 12 bytes
+#define LZ_LAST_LITERALS  5  // last 5 bytes are always literals
+#define LZ_MAX_OFFSET     0xFFFF
+
+static inline lUInt32 lzRead32( const lUInt8 * p )
+{
+    lUInt32 v;
+    memcpy( &v, p, 4 );
+    return v;
+}
+
+static inline int lzHash( lUInt32 v )
+{
+    return (int)((v * 2654435761U) >> (32 - LZ_HASH_BITS));
+}
+
+/// writes extra bytes of literal or match length
+static inline lUInt8 * lzWriteLength( lUInt8 * op, int len )
+{
+    while ( len>=255 ) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (lUInt8)len;
+    return op;
+}
+
+/// compresses buffer, returns compressed size, or 0 if doesn't fit into dst
+static int lzCompress( const lUInt8 * src, int srcSize, lUInt8 * dst, int dstCapacity )
+{
+    int table[1<<LZ_HASH_BITS];
+    memset( table, 0xFF, sizeof(table) );
+    const lUInt8 * ip = src;
+    const lUInt8 * anchor = src;
+    const lUInt8 * end = src + srcSize;
+    const lUInt8 * mflimit = end - LZ_MF_LIMIT;
+    const lUInt8 * mlimit = end - LZ_LAST_LITERALS;
+    lUInt8 * op = dst;
+    lUInt8 * oend = dst + dstCapacity;
+    while ( srcSize>LZ_MF_LIMIT && ip<mflimit ) {
+        lUInt32 seq = lzRead32( ip );
+        int h = lzHash( seq );
+        int ref = table[h];
+        table[h] = (int)(ip - src);
+        if ( ref<0 || (ip - src) - ref > LZ_MAX_OFFSET || lzRead32( src + ref )!=seq ) {
+            ip++;
+            continue;
+        }
+        const lUInt8 * match = src + ref;
+        // extend match backwards, then forward
+        while ( ip>anchor && match>src && ip[-1]==match[-1] ) {
+            ip--;
+            match--;
+        }
+        const lUInt8 * p = ip + LZ_MIN_MATCH;
+        const lUInt8 * m = match + LZ_MIN_MATCH;
+        while ( p<mlimit && *p==*m ) {
+            p++;
+            m++;
+        }
+        int litLen = (int)(ip - anchor);
+        int matchLen = (int)(p - ip) - LZ_MIN_MATCH;
+        if ( op + 1 + litLen + litLen/255 + 1 + 2 + matchLen/255 + 1 > oend )
+            return 0;
+        lUInt8 * token = op++;
+        if ( litLen>=15 ) {
+            *token = 15<<4;
+            op = lzWriteLength( op, litLen - 15 );
+        } else {
+            *token = (lUInt8)(litLen<<4);
+        }
+        memcpy( op, anchor, litLen );
+        op += litLen;
+        int offset = (int)(ip - match);
+        *op++ = (lUInt8)(offset & 0xFF);
+        *op++ = (lUInt8)(offset >> 8);
+        if ( matchLen>=15 ) {
+            *token |= 15;
+            op = lzWriteLength( op, matchLen - 15 );
+        } else {
+            *token |= (lUInt8)matchLen;
+        }
+        ip = anchor = p;
+    }
+    // last literals
+    int litLen = (int)(end - anchor);
+    if ( op + 1 + litLen + litLen/255 + 1 > oend )
+        return 0;
+    lUInt8 * token = op++;
+    if ( litLen>=15 ) {
+        *token = 15<<4;
+        op = lzWriteLength( op, litLen - 15 );
+    } else {
+        *token = (lUInt8)(litLen<<4);
+    }
+    memcpy( op, anchor, litLen );
+    op += litLen;
+    return (int)(op - dst);
+}
+
+/// decompresses buffer, returns false if data is corrupted or size doesn't match
+static bool lzDecompress( const lUInt8 * src, int srcSize, lUInt8 * dst, int dstSize )
+{
+    const lUInt8 * ip = src;
+    const lUInt8 * iend = src + srcSize;
+    lUInt8 * op = dst;
+    lUInt8 * oend = dst + dstSize;
+    while ( ip<iend ) {
+        int token = *ip++;
+        int litLen = token >> 4;
+        if ( litLen==15 ) {
+            int b;
+            do {
+                if ( ip>=iend )
+                    return false;
+                b = *ip++;
+                litLen += b;
+            } while ( b==255 );
+        }
+        if ( litLen > iend - ip || litLen > oend - op )
+            return false;
+        memcpy( op, ip, litLen );
+        op += litLen;
+        ip += litLen;
+        if ( ip>=iend )
+            break; // last sequence has no match
+        if ( iend - ip < 2 )
+            return false;
+        int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if ( offset==0 || offset > op - dst )
+            return false;
+        int matchLen = token & 15;
+        if ( matchLen==15 ) {
+            int b;
+            do {
+                if ( ip>=iend )
+                    return false;
+                b = *ip++;
+                matchLen += b;
+            } while ( b==255 );
+        }
+        matchLen += LZ_MIN_MATCH;
+        if ( matchLen > oend - op )
+            return false;
+        const lUInt8 * m = op - offset;
+        if ( offset>=matchLen ) {
+            memcpy( op, m, matchLen );
+            op += matchLen;
+        } else {
+            // overlapping match
+            for ( int i=0; i<matchLen; i++ )
+                *op++ = *m++;
+        }
+    }
+    return op==oend;
+}
+
+/// pack data with fast LZ codec, fails if data is not compressible
+bool ldomPackLZ( const lUInt8 * buf, int bufsize, lUInt8 * &dstbuf, lUInt32 & dstsize )
+{
+    if ( bufsize<=0 )
+        return false;
+    // no need to keep packed data which is not smaller than source
+    lUInt8 * tmp = (lUInt8 *)malloc( bufsize );
+    int have = lzCompress( buf, bufsize, tmp, bufsize - 1 );
+    if ( have<=0 ) {
+        free( tmp );
+        return false;
+    }
+    dstsize = have;
+    dstbuf = (lUInt8 *)realloc( tmp, have );
+    return true;
+}
+
+/// unpack data packed with fast LZ codec, dstsize is expected size of unpacked data
+bool ldomUnpackLZ( const lUInt8 * compbuf, int compsize, lUInt8 * &dstbuf, lUInt32 dstsize )
+{
+    if ( dstsize==0 )
+        return false;
+    dstbuf = (lUInt8 *)malloc( dstsize );
+    if ( !lzDecompress( compbuf, compsize, dstbuf, dstsize ) ) {
+        free( dstbuf );
+        dstbuf = NULL;
+        return false;
+    }
+    return true;
+}
+
 void ldomTextStorageChunk::setunpacked( const lUInt8 * buf, int bufsize )
 {
     if ( _buf ) {
@@ -3012,6 +3664,7 @@ ldomDocument::~ldomDocument()
 {
 #if BUILD_LITE!=1
     updateMap();
+    LVClearScaledImageCache( this );
 #endif
 }
 
@@ -3176,7 +3829,7 @@ void ldomDocument::applyDocumentStyleSheet()
 }
 
 
-int ldomDocument::render( LVRendPageList * pages, LVDocViewCallback * callback, int width, int dy, bool showCover, int y0, font_ref_t def_font, int def_interline_space, CRPropRef props )
+int ldomDocument::render( LVRendPageList * pages, LVDocViewCallback * callback, int width, int dy, bool showCover, int y0, font_ref_t def_font, int def_interline_space, CRPropRef props, ldomNode * firstScreenNode )
 {
     CRLog::info("Render is called for width %d, pageHeight=%d, fontFace=%s", width, dy, def_font->getTypeFace().c_str() );
     CRLog::trace("initializing default style...");
@@ -3244,10 +3897,16 @@ int ldomDocument::render( LVRendPageList * pages, LVDocViewCallback * callback,
         int numFinalBlocks = calcFinalBlocks();
         CRLog::info("Final block count: %d", numFinalBlocks);
         context.setCallback(callback, numFinalBlocks);
+        // publish pages around current position before whole document is paginated
+        context.setFirstScreenNode( firstScreenNode );
         //updateStyles();
         CRLog::trace("rendering...");
+        // formatted blocks are not reused during layout, so don't keep them
+        int blockCacheSize = _renderedBlockCache.getMaxMemSize();
+        _renderedBlockCache.setMaxMemSize( 0 );
         int height = renderBlockElement( context, getRootNode(),
             0, y0, width ) + y0;
+        _renderedBlockCache.setMaxMemSize( blockCacheSize );
         _rendered = true;
     #if 0 //def _DEBUG
         LVStreamRef ostream = LVOpenFileStream( "test_save_after_init_rend_method.xml", LVOM_WRITE );
@@ -5522,6 +6181,252 @@ void ldomXRangeList::split( ldomXRange * r )
 
 #if BUILD_LITE!=1
 
+static const char * search_index_magic = "CRSRCHIX";
+
+/// returns bitmap bit number for n-gram; bigrams are hashed with a==0
+static inline lUInt32 searchIndexBit( lChar16 a, lChar16 b, lChar16 c )
+{
+    lUInt32 h = ((lUInt32)a * 0x9E3779B1U) ^ ((lUInt32)b * 0x85EBCA77U) ^ ((lUInt32)c * 0xC2B2AE3DU);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6DU;
+    h ^= h >> 12;
+    return h & (SEARCH_INDEX_BLOCK_BITS - 1);
+}
+
+/// sets bits of all bigrams and trigrams of lowercase text
+static void addSearchIndexBits( lUInt32 * bits, const lChar16 * s, int len )
+{
+    for ( int i=0; i+1<len; i++ ) {
+        lUInt32 n = searchIndexBit( 0, s[i], s[i+1] );
+        bits[n >> 5] |= 1U << (n & 31);
+        if ( i+2<len ) {
+            n = searchIndexBit( s[i], s[i+1], s[i+2] );
+            bits[n >> 5] |= 1U << (n & 31);
+        }
+    }
+}
+
+ldomTextSearchIndex::ldomTextSearchIndex()
+: _textCount(0), _changed(false)
+{
+}
+
+/// removes all data
+void ldomTextSearchIndex::clear()
+{
+    _textCount = 0;
+    _nodes.clear();
+    _order.clear();
+    _blocks.clear();
+    _bits.clear();
+    _changed = false;
+}
+
+void ldomTextSearchIndex::updateOrder()
+{
+    _order.clear();
+    lInt32 * order = _order.addSpace( _textCount + 1 );
+    for ( int i=0; i<=_textCount; i++ )
+        order[i] = -1;
+    for ( int pos=0; pos<_nodes.length(); pos++ ) {
+        lUInt32 n = _nodes[pos] >> 4;
+        if ( n <= (lUInt32)_textCount )
+            order[n] = pos;
+    }
+}
+
+/// walks through all text nodes of document and fills index
+void ldomTextSearchIndex::build( ldomDocument * doc, int textCount )
+{
+    clear();
+    _textCount = textCount;
+    _nodes.reserve( textCount );
+    lUInt32 blockBits[SEARCH_INDEX_BLOCK_WORDS];
+    int blockChars = 0;
+    ldomXPointerEx p( doc->getRootNode(), 0 );
+    while ( p.nextText() ) {
+        ldomNode * node = p.getNode();
+        if ( !blockChars ) {
+            _blocks.add( _nodes.length() );
+            memset( blockBits, 0, sizeof(blockBits) );
+        }
+        lString16 txt = node->getText();
+        txt.lowercase();
+        addSearchIndexBits( blockBits, txt.c_str(), txt.length() );
+        _nodes.add( node->getDataIndex() );
+        blockChars += txt.length() + 1;
+        if ( blockChars >= SEARCH_INDEX_BLOCK_CHARS ) {
+            if ( _bits.size() < _bits.length() + SEARCH_INDEX_BLOCK_WORDS )
+                _bits.reserve( _bits.size() * 2 + SEARCH_INDEX_BLOCK_WORDS );
+            _bits.add( blockBits, SEARCH_INDEX_BLOCK_WORDS );
+            blockChars = 0;
+        }
+    }
+    if ( blockChars )
+        _bits.add( blockBits, SEARCH_INDEX_BLOCK_WORDS );
+    updateOrder();
+    _changed = true;
+}
+
+/// returns position of text node in index, -1 if node is not indexed
+int ldomTextSearchIndex::find( ldomNode * node ) const
+{
+    if ( !node || !node->isText() )
+        return -1;
+    lUInt32 n = node->getDataIndex() >> 4;
+    if ( n >= (lUInt32)_order.length() )
+        return -1;
+    return _order[n];
+}
+
+/// returns n-gram bit numbers of lowercase pattern, false if pattern is too short to use index
+bool ldomTextSearchIndex::getPatternBits( const lString16 & pattern, LVArray<lUInt32> & bits )
+{
+    bits.clear();
+    int len = pattern.length();
+    if ( len < 2 )
+        return false;
+    const lChar16 * s = pattern.c_str();
+    for ( int i=0; i+1<len; i++ ) {
+        bits.add( searchIndexBit( 0, s[i], s[i+1] ) );
+        if ( i+2<len )
+            bits.add( searchIndexBit( s[i], s[i+1], s[i+2] ) );
+    }
+    return true;
+}
+
+int ldomTextSearchIndex::findBlock( int pos ) const
+{
+    int a = 0;
+    int b = _blocks.length() - 1;
+    while ( a < b ) {
+        int c = (a + b + 1) / 2;
+        if ( _blocks[c] <= pos )
+            a = c;
+        else
+            b = c - 1;
+    }
+    return a;
+}
+
+bool ldomTextSearchIndex::isCandidate( int block, const LVArray<lUInt32> & bits ) const
+{
+    const lUInt32 * blockBits = _bits.ptr() + block * SEARCH_INDEX_BLOCK_WORDS;
+    for ( int i=0; i<bits.length(); i++ ) {
+        lUInt32 n = bits[i];
+        if ( !(blockBits[n >> 5] & (1U << (n & 31))) )
+            return false;
+    }
+    return true;
+}
+
+/// returns first position >= pos of node which may contain pattern, -1 if not found
+int ldomTextSearchIndex::nextCandidate( int pos, const LVArray<lUInt32> & bits ) const
+{
+    if ( pos < 0 )
+        pos = 0;
+    if ( pos >= _nodes.length() )
+        return -1;
+    int block = findBlock( pos );
+    if ( isCandidate( block, bits ) )
+        return pos;
+    for ( block++; block < _blocks.length(); block++ )
+        if ( isCandidate( block, bits ) )
+            return _blocks[block];
+    return -1;
+}
+
+/// returns last position <= pos of node which may contain pattern, -1 if not found
+int ldomTextSearchIndex::prevCandidate( int pos, const LVArray<lUInt32> & bits ) const
+{
+    if ( pos >= _nodes.length() )
+        pos = _nodes.length() - 1;
+    if ( pos < 0 )
+        return -1;
+    int block = findBlock( pos );
+    if ( isCandidate( block, bits ) )
+        return pos;
+    for ( block--; block >= 0; block-- )
+        if ( isCandidate( block, bits ) )
+            return _blocks[block + 1] - 1;
+    return -1;
+}
+
+/// serialize to buffer
+bool ldomTextSearchIndex::serialize( SerialBuf & buf )
+{
+    buf.putMagic( search_index_magic );
+    buf << (lUInt32)SEARCH_INDEX_BLOCK_BITS << (lInt32)_textCount;
+    buf << (lUInt32)_nodes.length();
+    for ( int i=0; i<_nodes.length(); i++ )
+        buf << _nodes[i];
+    buf << (lUInt32)_blocks.length();
+    for ( int i=0; i<_blocks.length(); i++ )
+        buf << _blocks[i];
+    for ( int i=0; i<_bits.length(); i++ )
+        buf << _bits[i];
+    buf.putMagic( search_index_magic );
+    return !buf.error();
+}
+
+/// deserialize from buffer, fails if document has different text node count
+bool ldomTextSearchIndex::deserialize( SerialBuf & buf, int textCount )
+{
+    clear();
+    lUInt32 blockBits = 0;
+    lInt32 count = 0;
+    lUInt32 nodeCount = 0;
+    lUInt32 blockCount = 0;
+    buf.checkMagic( search_index_magic );
+    buf >> blockBits >> count >> nodeCount;
+    if ( buf.error() || blockBits != SEARCH_INDEX_BLOCK_BITS || count != textCount || nodeCount > (lUInt32)textCount ) {
+        clear();
+        return false;
+    }
+    if ( buf.space() < (int)(nodeCount * sizeof(lUInt32)) ) {
+        clear();
+        return false;
+    }
+    lUInt32 * nodes = _nodes.addSpace( nodeCount );
+    for ( lUInt32 i=0; i<nodeCount; i++ ) {
+        buf >> nodes[i];
+        if ( (nodes[i] & 0x0F) || !(nodes[i] >> 4) || (nodes[i] >> 4) > (lUInt32)textCount )
+            buf.seterror(); // not a text node
+    }
+    buf >> blockCount;
+    if ( buf.error() || blockCount > nodeCount || buf.space() < (int)(blockCount * (SEARCH_INDEX_BLOCK_WORDS + 1) * sizeof(lUInt32)) ) {
+        clear();
+        return false;
+    }
+    lInt32 * blocks = _blocks.addSpace( blockCount );
+    for ( lUInt32 i=0; i<blockCount; i++ ) {
+        buf >> blocks[i];
+        if ( i==0 ? blocks[i] != 0 : (blocks[i] <= blocks[i-1] || blocks[i] >= (lInt32)nodeCount) )
+            buf.seterror(); // blocks should start from 0 and go in ascending order
+    }
+    lUInt32 * bits = _bits.addSpace( blockCount * SEARCH_INDEX_BLOCK_WORDS );
+    for ( lUInt32 i=0; i<blockCount * SEARCH_INDEX_BLOCK_WORDS; i++ )
+        buf >> bits[i];
+    buf.checkMagic( search_index_magic );
+    if ( buf.error() ) {
+        clear();
+        return false;
+    }
+    _textCount = textCount;
+    updateOrder();
+    return true;
+}
+
+/// returns full text search index, builds it if necessary
+ldomTextSearchIndex * ldomDocument::getTextSearchIndex()
+{
+    if ( _searchIndex.isEmpty() || _searchIndex.getTextCount() != _textCount ) {
+        _searchIndex.build( this, _textCount );
+        CRLog::debug("ldomDocument::getTextSearchIndex() - %d text nodes indexed", _searchIndex.length());
+    }
+    return &_searchIndex;
+}
+
 bool ldomDocument::findText( lString16 pattern, bool caseInsensitive, bool reverse, int minY, int maxY, LVArray<ldomWord> & words, int maxCount, int maxHeight )
 {
     if ( minY<0 )
@@ -5558,7 +6463,7 @@ static bool findText( const lString16 & str, int & pos, const lString16 & patter
     const lChar16 * s1 = str.c_str() + pos;
     const lChar16 * s2 = pattern.c_str();
     int nlen = str.length() - pos - len;
-    for ( int j=0; j<nlen; j++ ) {
+    for ( int j=0; j<=nlen; j++ ) {
         bool matched = true;
         for ( int i=0; i<len; i++ ) {
             if ( s1[i] != s2[i] ) {
@@ -5583,8 +6488,7 @@ static bool findTextRev( const lString16 & str, int & pos, const lString16 & pat
         return false;
     const lChar16 * s1 = str.c_str() + pos;
     const lChar16 * s2 = pattern.c_str();
-    int nlen = pos - len;
-    for ( int j=nlen-1; j>=0; j-- ) {
+    for ( int j=pos; j>=0; j-- ) {
         bool matched = true;
         for ( int i=0; i<len; i++ ) {
             if ( s1[i] != s2[i] ) {
@@ -5600,6 +6504,52 @@ static bool findTextRev( const lString16 & str, int & pos, const lString16 & pat
     return false;
 }
 
+/// returns search index position of text node, -1 if index cannot be used for pattern
+static int findSearchIndexPos( ldomXPointerEx & p, const lString16 & pattern, LVArray<lUInt32> & bits, ldomTextSearchIndex * & index )
+{
+    index = NULL;
+    if ( p.isNull() || !p.isText() )
+        return -1;
+    lString16 lpattern( pattern );
+    lpattern.lowercase();
+    if ( !ldomTextSearchIndex::getPatternBits( lpattern, bits ) )
+        return -1;
+    index = p.getDocument()->getTextSearchIndex();
+    return index->find( p.getNode() );
+}
+
+/// moves to next visible text node, skipping index blocks which cannot contain pattern
+static bool nextSearchText( ldomXPointerEx & p, ldomTextSearchIndex * index, int & pos, const LVArray<lUInt32> & bits )
+{
+    if ( pos < 0 )
+        return p.nextVisibleText();
+    ldomDocument * doc = p.getDocument();
+    for ( pos = index->nextCandidate( pos+1, bits ); pos >= 0; pos = index->nextCandidate( pos+1, bits ) ) {
+        ldomXPointerEx candidate( doc->getTinyNode( index->getNodeIndex( pos ) ), 0 );
+        if ( candidate.isVisible() ) {
+            p = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// moves to previous visible text node, skipping index blocks which cannot contain pattern
+static bool prevSearchText( ldomXPointerEx & p, ldomTextSearchIndex * index, int & pos, const LVArray<lUInt32> & bits )
+{
+    if ( pos < 0 )
+        return p.prevVisibleText();
+    ldomDocument * doc = p.getDocument();
+    for ( pos = index->prevCandidate( pos-1, bits ); pos >= 0; pos = index->prevCandidate( pos-1, bits ) ) {
+        ldomXPointerEx candidate( doc->getTinyNode( index->getNodeIndex( pos ) ), 0 );
+        if ( candidate.isVisible() ) {
+            p = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
 /// searches for specified text inside range
 bool ldomXRange::findText( lString16 pattern, bool caseInsensitive, bool reverse, LVArray<ldomWord> & words, int maxCount, int maxHeight, bool checkMaxFromStart )
 {
@@ -5615,6 +6565,9 @@ bool ldomXRange::findText( lString16 pattern, bool caseInsensitive, bool reverse
             lString16 txt = _end.getNode()->getText();
             _end.setOffset(txt.length());
         }
+        LVArray<lUInt32> bits;
+        ldomTextSearchIndex * index;
+        int pos = findSearchIndexPos( _end, pattern, bits, index );
         int firstFoundTextY = -1;
         while ( !isNull() ) {
 
@@ -5622,7 +6575,7 @@ bool ldomXRange::findText( lString16 pattern, bool caseInsensitive, bool reverse
             int offs = _end.getOffset();
 
             if ( firstFoundTextY!=-1 && maxHeight>0 ) {
-                ldomXPointer p( _start.getNode(), offs );
+                ldomXPointer p( _end.getNode(), offs );
                 int currentTextY = p.toPoint().y;
                 if ( currentTextY<firstFoundTextY-maxHeight )
                     return words.length()>0;
@@ -5639,7 +6592,7 @@ bool ldomXRange::findText( lString16 pattern, bool caseInsensitive, bool reverse
                 words.add( ldomWord(_end.getNode(), offs, offs + pattern.length() ) );
                 offs--;
             }
-            if ( !_end.prevVisibleText() )
+            if ( !prevSearchText( _end, index, pos, bits ) )
                 break;
             txt = _end.getNode()->getText();
             _end.setOffset(txt.length());
@@ -5650,6 +6603,9 @@ bool ldomXRange::findText( lString16 pattern, bool caseInsensitive, bool reverse
         // direct search
         if ( !_start.isText() )
             _start.nextVisibleText();
+        LVArray<lUInt32> bits;
+        ldomTextSearchIndex * index;
+        int pos = findSearchIndexPos( _start, pattern, bits, index );
         int firstFoundTextY = -1;
         if (checkMaxFromStart) {
 			ldomXPointer p( _start.getNode(), _start.getOffset() );
@@ -5683,7 +6639,7 @@ bool ldomXRange::findText( lString16 pattern, bool caseInsensitive, bool reverse
                 words.add( ldomWord(_start.getNode(), offs, offs + pattern.length() ) );
                 offs++;
             }
-            if ( !_start.nextVisibleText() )
+            if ( !nextSearchText( _start, index, pos, bits ) )
                 break;
             if ( words.length() >= maxCount )
                 break;
@@ -7840,6 +8796,15 @@ bool ldomDocument::loadCacheFileContent(CacheLoadingCallback * formatCallback)
         }
     }
 
+    // search index is optional: it's built on first search and saved with next update of cache file
+    _searchIndex.clear();
+    if ( _cacheFile->hasBlock( CBT_SEARCH_INDEX ) ) {
+        CRLog::trace("ldomDocument::loadCacheFileContent() - search index");
+        SerialBuf indexbuf(0,true);
+        if ( !_cacheFile->read( CBT_SEARCH_INDEX, indexbuf ) || !_searchIndex.deserialize( indexbuf, _textCount ) )
+            CRLog::warn("Cannot read search index, it will be rebuilt");
+    }
+
     if ( loadStylesData() ) {
         CRLog::trace("ldomDocument::loadCacheFileContent() - using loaded styles");
         updateLoadedStyles( true );
@@ -8030,6 +8995,19 @@ ContinuousOperationResult ldomDocument::saveChanges( CRTimerUtil & maxTime )
                 return CR_ERROR;
             }
         }
+
+        if ( _searchIndex.isChanged() ) {
+            CRLog::trace("ldomDocument::saveChanges() - search index");
+            SerialBuf indexbuf(0,true);
+            if ( !_searchIndex.serialize(indexbuf) ) {
+                CRLog::error("Search index serialization is failed");
+                return CR_ERROR;
+            } else if ( !_cacheFile->write( CBT_SEARCH_INDEX, indexbuf, COMPRESS_SEARCH_INDEX_DATA ) ) {
+                CRLog::error("Error while writing search index");
+                return CR_ERROR;
+            }
+            _searchIndex.setChanged( false );
+        }
         if (!maxTime.infinite())
             _cacheFile->flush(false, maxTime); // intermediate flush
         CHECK_EXPIRATION("saving TOC data")
@@ -8042,6 +9020,10 @@ ContinuousOperationResult ldomDocument::saveChanges( CRTimerUtil & maxTime )
             return CR_ERROR;
         }
         CRLog::trace("ldomDocument::saveChanges() - flush");
+        if ( !_cacheFile->waitForWrites(maxTime) ) {
+            CRLog::info("timer expired while waiting for cache file writer");
+            return CR_TIMEOUT;
+        }
         {
             CRTimerUtil infinite;
             if ( !_cacheFile->flush(true, infinite) ) {
@@ -10489,7 +11471,7 @@ public:
 
     virtual ldomNode * GetSourceNode()
     {
-        return NULL;
+        return _node;
     }
     virtual LVStream * GetSourceStream()
     {
@@ -10572,6 +11554,9 @@ LVImageSourceRef ldomNode::getObjectImageSource()
     LVImageSourceRef ref;
     if ( refName.empty() )
         return ref;
+    // image header is parsed once, proxy is reused on each redraw
+    if ( getDocument()->_urlImageMap.get( refName, ref ) )
+        return ref;
     ref = getDocument()->getObjectImageSource( refName );
     if ( !ref.isNull() ) {
         int dx = ref->GetWidth();
@@ -10651,6 +11636,154 @@ void ldomDocument::setNodeNumberingProps( lUInt32 nodeDataIndex, ListNumberingPr
     lists.set(nodeDataIndex, v);
 }
 
+CVRendBlockCache::CVRendBlockCache( int maxMemSize )
+: _table(NULL), _tableSize(0), _head(NULL), _tail(NULL), _count(0), _memSize(0)
+, _maxMemSize(maxMemSize), _hits(0), _misses(0)
+{
+    resizeTable( 64 );
+}
+
+CVRendBlockCache::~CVRendBlockCache()
+{
+    clear();
+    free( _table );
+}
+
+static inline lUInt32 rendBlockCacheHash( ldomNode * node )
+{
+    return getHash( (lUInt32)((size_t)node >> 4) );
+}
+
+/// returns pointer to hash chain link which points to item for node, or to NULL at chain end
+CVRendBlockCache::Item ** CVRendBlockCache::findSlot( ldomNode * node )
+{
+    Item ** slot = &_table[ rendBlockCacheHash( node ) % _tableSize ];
+    while ( *slot && (*slot)->node != node )
+        slot = &(*slot)->nextInBucket;
+    return slot;
+}
+
+void CVRendBlockCache::resizeTable( int newSize )
+{
+    Item ** table = (Item**)calloc( newSize, sizeof(Item*) );
+    for ( int i=0; i<_tableSize; i++ ) {
+        Item * item = _table[i];
+        while ( item ) {
+            Item * next = item->nextInBucket;
+            lUInt32 index = rendBlockCacheHash( item->node ) % newSize;
+            item->nextInBucket = table[index];
+            table[index] = item;
+            item = next;
+        }
+    }
+    free( _table );
+    _table = table;
+    _tableSize = newSize;
+}
+
+/// remove item from LRU list
+void CVRendBlockCache::unlink( Item * item )
+{
+    if ( item->prev )
+        item->prev->next = item->next;
+    else
+        _head = item->next;
+    if ( item->next )
+        item->next->prev = item->prev;
+    else
+        _tail = item->prev;
+    item->prev = item->next = NULL;
+}
+
+void CVRendBlockCache::removeItem( Item * item )
+{
+    Item ** slot = findSlot( item->node );
+    *slot = item->nextInBucket;
+    unlink( item );
+    _memSize -= item->size;
+    _count--;
+    delete item;
+}
+
+bool CVRendBlockCache::get( ldomNode * node, LFormattedTextRef & text )
+{
+    Item * item = *findSlot( node );
+    if ( !item ) {
+        _misses++;
+        return false;
+    }
+    _hits++;
+    if ( item != _head ) {
+        unlink( item );
+        item->next = _head;
+        _head->prev = item;
+        _head = item;
+    }
+    text = item->text;
+    return true;
+}
+
+void CVRendBlockCache::set( ldomNode * node, LFormattedTextRef text )
+{
+    Item ** slot = findSlot( node );
+    Item * item = *slot;
+    if ( item ) {
+        unlink( item );
+        _memSize -= item->size;
+    } else {
+        item = new Item();
+        item->node = node;
+        item->nextInBucket = NULL;
+        *slot = item;
+        _count++;
+        if ( _count > _tableSize )
+            resizeTable( _tableSize * 2 );
+    }
+    item->text = text;
+    item->size = text.isNull() ? 0 : text->GetMemorySize();
+    _memSize += item->size;
+    item->prev = NULL;
+    item->next = _head;
+    if ( _head )
+        _head->prev = item;
+    else
+        _tail = item;
+    _head = item;
+    // most recently added item is kept even if it alone exceeds the limit
+    while ( _memSize > _maxMemSize && _tail != _head )
+        removeItem( _tail );
+}
+
+bool CVRendBlockCache::remove( ldomNode * node )
+{
+    Item * item = *findSlot( node );
+    if ( !item )
+        return false;
+    removeItem( item );
+    return true;
+}
+
+void CVRendBlockCache::clear()
+{
+    while ( _head ) {
+        Item * item = _head;
+        _head = item->next;
+        delete item;
+    }
+    _tail = NULL;
+    if ( _table )
+        memset( _table, 0, sizeof(Item*) * _tableSize );
+    _count = 0;
+    _memSize = 0;
+}
+
+void CVRendBlockCache::setMaxMemSize( int maxMemSize )
+{
+    _maxMemSize = maxMemSize;
+    while ( _memSize > _maxMemSize && _tail != _head )
+        removeItem( _tail );
+}
+
 /// formats final block
 int ldomNode::renderFinalBlock(  LFormattedTextRef & frmtext, RenderRectAccessor * fmt, int width )
 {
@@ -10677,8 +11810,9 @@ int ldomNode::renderFinalBlock(  LFormattedTextRef & frmtext, RenderRectAccessor
     int flags = styleToTextFmtFlags( getStyle(), 0 );
     ::renderFinalBlock( this, f.get(), fmt, flags, 0, 16 );
     int page_h = getDocument()->getPageHeight();
-    cache.set( this, f );
     int h = f->Format( width, page_h );
+    // added after formatting to account size of formatted lines
+    cache.set( this, f );
     frmtext = f;
     //CRLog::trace("Created new formatted object for node #%08X", (lUInt32)this);
     return h;
@@ -10807,12 +11941,17 @@ void tinyNodeCollection::dumpStatistics()
                 _styleStorage.getUncompressedSize(),
                 _styles.length(), _fonts.length(),
 #if BUILD_LITE!=1
-                ((ldomDocument*)this)->_renderedBlockCache.length(),
+                _renderedBlockCache.length(),
 #else
                 0,
 #endif
                 _itemCount, _itemCount*16/1024,
                 _tinyElementCount, _tinyElementCount*(sizeof(tinyElement)+8*4)/1024 );
+#if BUILD_LITE!=1
+    CRLog::info("*** Rendered block cache: %d items (%dKb), hits:%d, misses:%d",
+                _renderedBlockCache.length(), _renderedBlockCache.getMemSize()/1024,
+                _renderedBlockCache.getHits(), _renderedBlockCache.getMisses() );
+#endif
 }
 
 
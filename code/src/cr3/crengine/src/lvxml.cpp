@@ -265,135 +265,126 @@ int LVTextFileBase::ReadChars( lChar16 * buf, int maxsize )
 {
     if ( m_buf_pos>=m_buf_len )
         return 0;
+    // decode whole buffer in one pass, using local pointers: buf cannot alias parser members
+    const lUInt8 * src = m_buf + m_buf_pos;
+    const lUInt8 * end = m_buf + m_buf_len;
     int count = 0;
     switch ( m_enc_type ) {
     case ce_8bit_cp:
     case ce_utf8:
         if ( m_conv_table!=NULL ) {
-            for ( ; count<maxsize && m_buf_pos<m_buf_len; count++ ) {
-                lUInt16 ch = m_buf[m_buf_pos++];
-                buf[count] = ( (ch & 0x80) == 0 ) ? ch : m_conv_table[ch&0x7F];
+            const lChar16 * table = m_conv_table;
+            if ( maxsize > end - src )
+                maxsize = end - src;
+            for ( ; count<maxsize; count++ ) {
+                lUInt8 ch = src[count];
+                buf[count] = ( (ch & 0x80) == 0 ) ? ch : table[ch&0x7F];
             }
+            m_buf_pos += count;
             return count;
         } else  {
-            for ( ; count<maxsize && m_buf_pos<m_buf_len; count++ ) {
-                lUInt16 ch = m_buf[m_buf_pos];
+            while ( count<maxsize && src<end ) {
+                lUInt16 ch = *src;
                 // support only 11 and 16 bit UTF8 chars
                 if ( (ch & 0x80) == 0 ) {
-                    buf[count] = ch;
-                    m_buf_pos++;
+                    buf[count++] = ch;
+                    src++;
+                    // ASCII run: check 4 bytes at once
+                    while ( count+4<=maxsize && src+4<=end && ((src[0] | src[1] | src[2] | src[3]) & 0x80) == 0 ) {
+                        buf[count] = src[0];
+                        buf[count+1] = src[1];
+                        buf[count+2] = src[2];
+                        buf[count+3] = src[3];
+                        count += 4;
+                        src += 4;
+                    }
                 } else if ( (ch & 0xE0) == 0xC0 ) {
                     // 11 bits
-                    if ( m_buf_pos+1>=m_buf_len ) {
-                        checkEof();
-                        return count;
-                    }
+                    if ( src+1>=end )
+                        break;
                     ch = (ch&0x1F);
 #ifdef _DEBUG
 //#define CHECK_UTF8_CODE 1
 #endif
 #if CHECK_UTF8_CODE==1
-                    if ( (m_buf[m_buf_pos+1] & 0xC0) != 0x80 ) {
-                        CRLog::error("Wrong utf8 character at position %08x", (int)(m_buf_fpos+m_buf_pos));
+                    if ( (src[1] & 0xC0) != 0x80 ) {
+                        CRLog::error("Wrong utf8 character at position %08x", (int)(m_buf_fpos+(src-m_buf)));
                     }
 #endif
-                    m_buf_pos++;
-                    lUInt16 ch2 = m_buf[m_buf_pos++]&0x3F;
-                    buf[count] = (ch<<6) | ch2;
-                    //buf[count] = ((lUInt16)(ch&0x1F)<<6) | ((lUInt16)m_buf[m_buf_pos++]&0x3F);
+                    lUInt16 ch2 = src[1]&0x3F;
+                    src += 2;
+                    buf[count++] = (ch<<6) | ch2;
                 } else if ( (ch & 0xF0) == 0xE0 ) {
                     // 16 bits
-                    if ( m_buf_pos+2>=m_buf_len ) {
-                        checkEof();
-                        return count;
-                    }
+                    if ( src+2>=end )
+                        break;
                     ch = (ch&0x0F);
 #if CHECK_UTF8_CODE==1
-                    if ( (m_buf[m_buf_pos+1] & 0xC0) != 0x80 || (m_buf[m_buf_pos+2] & 0xC0) != 0x80 ) {
-                        CRLog::error("Wrong utf8 character at position %08x", (int)(m_buf_fpos+m_buf_pos));
+                    if ( (src[1] & 0xC0) != 0x80 || (src[2] & 0xC0) != 0x80 ) {
+                        CRLog::error("Wrong utf8 character at position %08x", (int)(m_buf_fpos+(src-m_buf)));
                     }
 #endif
-                    m_buf_pos++;
-                    lUInt16 ch2 = m_buf[m_buf_pos++]&0x3F;
-                    lUInt16 ch3 = m_buf[m_buf_pos++]&0x3F;
-                    buf[count] = (ch<<12) | (ch2<<6) | ch3;
+                    lUInt16 ch2 = src[1]&0x3F;
+                    lUInt16 ch3 = src[2]&0x3F;
+                    src += 3;
+                    buf[count++] = (ch<<12) | (ch2<<6) | ch3;
                 } else {
                     // 20 bits
-                    if ( m_buf_pos+3>=m_buf_len ) {
-                        checkEof();
-                        return count;
-                    }
+                    if ( src+3>=end )
+                        break;
                     ch = (ch&0x07);
 #if CHECK_UTF8_CODE==1
-                    if ( (m_buf[m_buf_pos+1] & 0xC0) != 0x80 || (m_buf[m_buf_pos+2] & 0xC0) != 0x80  || (m_buf[m_buf_pos+3] & 0xC0) != 0x80 ) {
-                        CRLog::error("Wrong utf8 character at position %08x", (int)(m_buf_fpos+m_buf_pos));
+                    if ( (src[1] & 0xC0) != 0x80 || (src[2] & 0xC0) != 0x80  || (src[3] & 0xC0) != 0x80 ) {
+                        CRLog::error("Wrong utf8 character at position %08x", (int)(m_buf_fpos+(src-m_buf)));
                     }
 #endif
-                    m_buf_pos++;
-                    lUInt16 ch2 = m_buf[m_buf_pos++]&0x3F;
-                    lUInt16 ch3 = m_buf[m_buf_pos++]&0x3F;
-                    lUInt16 ch4 = m_buf[m_buf_pos++]&0x3F;
-                    buf[count] = ((lChar16)ch<<18) | (ch2<12) | (ch3<<6) | ch4;
+                    lUInt16 ch2 = src[1]&0x3F;
+                    lUInt16 ch3 = src[2]&0x3F;
+                    lUInt16 ch4 = src[3]&0x3F;
+                    src += 4;
+                    buf[count++] = ((lChar16)ch<<18) | ((lChar16)ch2<<12) | (ch3<<6) | ch4;
                 }
             }
+            m_buf_pos = src - m_buf;
+            if ( count<maxsize && src<end )
+                checkEof(); // incomplete character at end of buffer
             return count;
         }
     case ce_utf16_be:
-        {
-            for ( ; count<maxsize; count++ ) {
-                if ( m_buf_pos+1>=m_buf_len ) {
-                    checkEof();
-                    return count;
-                }
-                lUInt16 ch = m_buf[m_buf_pos++];
-                lUInt16 ch2 = m_buf[m_buf_pos++];
-                buf[count] = (ch << 8) | ch2;
-            }
-            return count;
-        }
     case ce_utf16_le:
         {
-            for ( ; count<maxsize; count++ ) {
-                if ( m_buf_pos+1>=m_buf_len ) {
-                    checkEof();
-                    return count;
-                }
-                lUInt16 ch = m_buf[m_buf_pos++];
-                lUInt16 ch2 = m_buf[m_buf_pos++];
-                buf[count] = (ch2 << 8) | ch;
+            int n = (end - src) >> 1;
+            if ( n > maxsize )
+                n = maxsize;
+            if ( m_enc_type==ce_utf16_be ) {
+                for ( ; count<n; count++, src+=2 )
+                    buf[count] = ((lUInt16)src[0] << 8) | src[1];
+            } else {
+                for ( ; count<n; count++, src+=2 )
+                    buf[count] = ((lUInt16)src[1] << 8) | src[0];
             }
+            m_buf_pos = src - m_buf;
+            if ( count<maxsize )
+                checkEof();
             return count;
         }
     case ce_utf32_be:
-        // support 24 bits only
-        {
-            for ( ; count<maxsize; count++ ) {
-                if ( m_buf_pos+3>=m_buf_len ) {
-                    checkEof();
-                    return count;
-                }
-                m_buf_pos++; //lUInt16 ch = m_buf[m_buf_pos++];
-                lUInt16 ch2 = m_buf[m_buf_pos++];
-                lUInt16 ch3 = m_buf[m_buf_pos++];
-                lUInt16 ch4 = m_buf[m_buf_pos++];
-                buf[count] = (ch2 << 16) | (ch3 << 8) | ch4;
-            }
-            return count;
-        }
     case ce_utf32_le:
         // support 24 bits only
         {
-            for ( ; count<maxsize; count++ ) {
-                if ( m_buf_pos+3>=m_buf_len ) {
-                    checkEof();
-                    return count;
-                }
-                lUInt16 ch = m_buf[m_buf_pos++];
-                lUInt16 ch2 = m_buf[m_buf_pos++];
-                lUInt16 ch3 = m_buf[m_buf_pos++];
-                m_buf_pos++; //lUInt16 ch4 = m_buf[m_buf_pos++];
-                buf[count] = (ch3 << 16) | (ch2 << 8) | ch;
+            int n = (end - src) >> 2;
+            if ( n > maxsize )
+                n = maxsize;
+            if ( m_enc_type==ce_utf32_be ) {
+                for ( ; count<n; count++, src+=4 )
+                    buf[count] = ((lChar16)src[1] << 16) | ((lChar16)src[2] << 8) | src[3];
+            } else {
+                for ( ; count<n; count++, src+=4 )
+                    buf[count] = ((lChar16)src[2] << 16) | ((lChar16)src[1] << 8) | src[0];
             }
+            m_buf_pos = src - m_buf;
+            if ( count<maxsize )
+                checkEof();
             return count;
         }
     default:
@@ -1960,6 +1951,17 @@ lString16 LVTextFileBase::ReadLine( int maxLineSize, lUInt32 & flags )
             flags |= LINE_HAS_EOLN; // EOLN flag
             break;
         }
+        // copy run of characters which cannot end line directly from buffer
+        int runEnd = m_read_buffer_pos;
+        for ( ; runEnd<m_read_buffer_len; runEnd++ ) {
+            lChar16 c = m_read_buffer[runEnd];
+            if ( c=='\r' || c=='\n' || c==' ' || c=='\t' || c==0 )
+                break;
+        }
+        if ( runEnd > m_read_buffer_pos ) {
+            res.append( m_read_buffer + m_read_buffer_pos, runEnd - m_read_buffer_pos );
+            m_read_buffer_pos = runEnd;
+        }
         ch = ReadCharFromBuffer();
         //if ( ch==0xFEFF && fpos==0 && res.empty() ) {
         //} else 
@@ -2979,6 +2981,13 @@ void PreProcessXmlString( lString16 & s, lUInt32 flags, const lChar16 * enc_tabl
     for (int i=0; i<len; ++i )
     {
         lChar16 ch = str[i];
+        if ( state==0 && ch>' ' && ch!='&' ) {
+            // regular character
+            str[j++] = ch;
+            nsp = 0;
+            lch = ch;
+            continue;
+        }
         if ( pre && ch=='\t' )
             tabCount++;
         if ( !pre && (ch=='\r' || ch=='\n' || ch=='\t') )
@@ -3029,10 +3038,9 @@ void PreProcessXmlString( lString16 & s, lUInt32 flags, const lChar16 * enc_tabl
                 entname[k-i] = 0;
                 int n;
                 lChar16 code = 0;
-                // TODO: optimize search
                 if ( str[k]==';' || str[k]==' ' ) {
                     for ( n=0; def_entity_table[n].name; n++ ) {
-                        if ( !lStr_cmp( def_entity_table[n].name, entname ) ) {
+                        if ( def_entity_table[n].name[0]==entname[0] && !lStr_cmp( def_entity_table[n].name, entname ) ) {
                             code = def_entity_table[n].code;
                             break;
                         }
@@ -3097,6 +3105,18 @@ void PreProcessXmlString( lString16 & s, lUInt32 flags, const lChar16 * enc_tabl
     //CRLog::trace(" after: '%s'", LCSTR(s));
 }
 
+/// processing of text which XML parser does before OnText() call: PreProcessXmlString() and trimming, according to flags
+void PreProcessXmlText( lString16 & s, lUInt32 flags, const lChar16 * enc_table )
+{
+    PreProcessXmlString( s, flags, enc_table );
+    if ( (flags & TXTFLG_TRIM) && (!(flags & TXTFLG_PRE) || (flags & TXTFLG_PRE_PARA_SPLITTING)) ) {
+        s.trimDoubleSpaces(
+            (flags & (TXTFLG_TRIM_ALLOW_START_SPACE | TXTFLG_PRE_PARA_SPLITTING))?true:false,
+            (flags & TXTFLG_TRIM_ALLOW_END_SPACE)?true:false,
+            (flags & TXTFLG_TRIM_REMOVE_EOL_HYPHENS)?true:false );
+    }
+}
+
 void LVTextFileBase::clearCharBuffer()
 {
     m_read_buffer_len = m_read_buffer_pos = 0;
@@ -3149,6 +3169,11 @@ bool LVXMLParser::ReadText()
         }
         for ( ; m_read_buffer_pos+i<m_read_buffer_len; i++ ) {
             lChar16 ch = m_read_buffer[m_read_buffer_pos + i];
+            if ( !last_eol && tlen < TEXT_SPLIT_SIZE && ch!='<' && ch!=' ' && ch!='\r' && ch!='\n' ) {
+                // regular character: can neither end nor split text
+                tlen++;
+                continue;
+            }
             lChar16 nextch = m_read_buffer_pos + i + 1 < m_read_buffer_len ? m_read_buffer[m_read_buffer_pos + i + 1] : 0;
             flgBreak = ch=='<' || m_eof;
             if ( flgBreak && !tlen ) {
@@ -3185,15 +3210,11 @@ bool LVXMLParser::ReadText()
             //=====================================================
             lString16 nextText = m_txt_buf.substr( last_split_txtlen );
             m_txt_buf.limit( last_split_txtlen );
-            const lChar16 * enc_table = NULL;
-            if ( flags & TXTFLG_CONVERT_8BIT_ENTITY_ENCODING )
-                enc_table = this->m_conv_table;
-            PreProcessXmlString( m_txt_buf, flags, enc_table );
-            if ( (flags & TXTFLG_TRIM) && (!(flags & TXTFLG_PRE) || (flags & TXTFLG_PRE_PARA_SPLITTING)) ) {
-                m_txt_buf.trimDoubleSpaces(
-                    ((flags & TXTFLG_TRIM_ALLOW_START_SPACE) || pre_para_splitting)?true:false,
-                    (flags & TXTFLG_TRIM_ALLOW_END_SPACE)?true:false,
-                    (flags & TXTFLG_TRIM_REMOVE_EOL_HYPHENS)?true:false );
+            if ( !(flags & TXTFLG_RAW_TEXT) ) {
+                const lChar16 * enc_table = NULL;
+                if ( flags & TXTFLG_CONVERT_8BIT_ENTITY_ENCODING )
+                    enc_table = this->m_conv_table;
+                PreProcessXmlText( m_txt_buf, flags, enc_table );
             }
             m_callback->OnText(m_txt_buf.c_str(), m_txt_buf.length(), flags );
             //=====================================================
@@ -3382,6 +3403,129 @@ bool LVHTMLParser::Parse()
 }
 
 
+enum {
+    XML_EVENT_START,
+    XML_EVENT_STOP,
+    XML_EVENT_ENCODING,
+    XML_EVENT_TAG_OPEN,
+    XML_EVENT_TAG_BODY,
+    XML_EVENT_TAG_CLOSE,
+    XML_EVENT_ATTRIBUTE,
+    XML_EVENT_TEXT
+};
+
+int LVXMLParserEventBuffer::addString( const lChar16 * s, int len )
+{
+    if ( !s )
+        return -1;
+    if ( len<0 )
+        len = lStr_len( s );
+    int pos = _chars.length();
+    if ( _chars.size() < pos + len + 1 )
+        _chars.reserve( (pos + len + 1) * 2 );
+    _chars.add( s, len );
+    _chars.add( 0 );
+    return pos;
+}
+
+void LVXMLParserEventBuffer::addEvent( int type, int s1, int s2, int s3, const lChar16 * table )
+{
+    Event e;
+    e.type = type;
+    e.s1 = s1;
+    e.s2 = s2;
+    e.s3 = s3;
+    e.table = table;
+    _events.add( e );
+}
+
+void LVXMLParserEventBuffer::OnStart( LVFileFormatParser * parser )
+{
+    _parser = parser;
+    addEvent( XML_EVENT_START );
+}
+
+void LVXMLParserEventBuffer::OnStop()
+{
+    addEvent( XML_EVENT_STOP );
+}
+
+void LVXMLParserEventBuffer::OnEncoding( const lChar16 * name, const lChar16 * table )
+{
+    addEvent( XML_EVENT_ENCODING, addString( name ), -1, -1, table );
+}
+
+ldomNode * LVXMLParserEventBuffer::OnTagOpen( const lChar16 * nsname, const lChar16 * tagname )
+{
+    addEvent( XML_EVENT_TAG_OPEN, addString( nsname ), addString( tagname ) );
+    return NULL;
+}
+
+void LVXMLParserEventBuffer::OnTagBody()
+{
+    addEvent( XML_EVENT_TAG_BODY );
+}
+
+void LVXMLParserEventBuffer::OnTagClose( const lChar16 * nsname, const lChar16 * tagname )
+{
+    addEvent( XML_EVENT_TAG_CLOSE, addString( nsname ), addString( tagname ) );
+}
+
+void LVXMLParserEventBuffer::OnAttribute( const lChar16 * nsname, const lChar16 * attrname, const lChar16 * attrvalue )
+{
+    addEvent( XML_EVENT_ATTRIBUTE, addString( nsname ), addString( attrname ), addString( attrvalue ) );
+}
+
+void LVXMLParserEventBuffer::OnText( const lChar16 * text, int len, lUInt32 )
+{
+    addEvent( XML_EVENT_TEXT, addString( text, len ), len );
+}
+
+/// passes recorded events to callback
+void LVXMLParserEventBuffer::replay( LVXMLParserCallback * callback )
+{
+    const lChar16 * chars = _chars.ptr();
+    const lChar16 * table = NULL;
+    for ( int i=0; i<_events.length(); i++ ) {
+        const Event & e = _events.ptr()[i];
+        const lChar16 * s1 = e.s1>=0 ? chars + e.s1 : NULL;
+        const lChar16 * s2 = e.s2>=0 ? chars + e.s2 : NULL;
+        switch ( e.type ) {
+        case XML_EVENT_START:
+            callback->OnStart( NULL );
+            break;
+        case XML_EVENT_STOP:
+            callback->OnStop();
+            break;
+        case XML_EVENT_ENCODING:
+            table = e.table;
+            callback->OnEncoding( s1, e.table );
+            break;
+        case XML_EVENT_TAG_OPEN:
+            callback->OnTagOpen( s1, s2 );
+            break;
+        case XML_EVENT_TAG_BODY:
+            callback->OnTagBody();
+            break;
+        case XML_EVENT_TAG_CLOSE:
+            callback->OnTagClose( s1, s2 );
+            break;
+        case XML_EVENT_ATTRIBUTE:
+            callback->OnAttribute( s1, s2, e.s3>=0 ? chars + e.s3 : NULL );
+            break;
+        case XML_EVENT_TEXT:
+            {
+                // same processing as in LVXMLParser::ReadText(), with flags of target callback
+                lUInt32 flags = callback->getFlags();
+                lString16 text( s1, e.s2 );
+                PreProcessXmlText( text, flags, (flags & TXTFLG_CONVERT_8BIT_ENTITY_ENCODING) ? table : NULL );
+                callback->OnText( text.c_str(), text.length(), flags );
+            }
+            break;
+        }
+    }
+}
+
 /// read file contents to string
 lString16 LVReadTextFile( lString16 filename )
 {
@@ -12,6 +12,14 @@
 
 #include <stdlib.h>
 #include "tinydict.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+/// number of recently used unpacked chunks of .dict.dz file kept in memory
+#ifndef TINYDICT_CHUNK_CACHE_SIZE
+#define TINYDICT_CHUNK_CACHE_SIZE 8
+#endif
 
 
 /// add word to list
@@ -77,11 +85,23 @@ public:
     }
 };
 
+/// index file, mapped to memory (or loaded, if mapping is not available) and searched in place
 class TinyDictIndexFile : public TinyDictFileBase
 {
-    int    factor;
+    const char * data;  // file contents
+    bool   mapped;      // data is mapped, not allocated
+    unsigned * entries; // file offsets of valid lines, ordered by word
     int    count;
-    TinyDictWordList list;
+
+    /// returns length of index line w/o line end
+    int lineLength( unsigned pos ) const
+    {
+        const char * p = data + pos;
+        const char * eol = (const char *)memchr( p, '\n', size - pos );
+        return eol ? (int)(eol - p) : (int)(size - pos);
+    }
+    /// returns first entry which word is not less than str
+    int lowerBound( const char * str ) const;
 public:
 
 	void compact()
@@ -90,15 +110,20 @@ public:
 	}
 
     bool find( const char * prefix, bool exactMatch, TinyDictWordList & words );
+    /// finds words matching any of prefixes, in index order
+    bool find( const char * const * prefixes, int prefixCount, bool exactMatch, TinyDictWordList & words );
 
-    TinyDictIndexFile() : factor( 16 ), count(0)
+    TinyDictIndexFile() : data(NULL), mapped(false), entries(NULL), count(0)
     {
     }
 
     virtual ~TinyDictIndexFile()
     {
+        close();
     }
 
+    virtual void close();
+
     bool open( const char * filename );
 
 };
@@ -162,10 +187,18 @@ class TinyDictZStream
     bool     zInitialized;
     z_stream zStream;
     unsigned packed_size;
-    unsigned char * unp_buffer;
-    unsigned unp_buffer_start;
-    unsigned unp_buffer_len;
-    unsigned unp_buffer_size;
+    unsigned char * pack_buffer; // packed data of chunk
+    unsigned pack_buffer_size;
+
+    /// unpacked chunk
+    struct Chunk {
+        unsigned index;
+        unsigned char * data; // chunkLength bytes
+        unsigned len;
+        unsigned lastUse;
+    };
+    Chunk    cache[TINYDICT_CHUNK_CACHE_SIZE]; // recently used chunks
+    unsigned useCounter;
 
     unsigned int readBytes( unsigned char * buf, unsigned size )
     {
@@ -209,11 +242,12 @@ class TinyDictZStream
         return 0;
     }
 
-    bool zinit(unsigned char * next_in, unsigned avail_in, unsigned char * next_out, unsigned avail_out);
+    bool zinit();
 
     bool zclose();
 
-    bool readChunk( unsigned n );
+    /// returns unpacked chunk, from cache if possible
+    Chunk * readChunk( unsigned n );
 
 public:
 	/// minimize memory consumption
@@ -284,7 +318,7 @@ public:
 static int base64table[128] = { 0 };
 static const char * base64chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-static unsigned parseBase64( const char * str )
+static unsigned parseBase64( const char * str, const char * end )
 {
     int i;
     if ( !*base64table ) {
@@ -294,8 +328,9 @@ static unsigned parseBase64( const char * str )
             base64table[(unsigned)base64chars[i]] = i;
     }
     unsigned n = 0;
-    for ( ; *str; str++ ) {
-        int code = base64table[ (unsigned)*str ];
+    for ( ; str<end; str++ ) {
+        unsigned char ch = (unsigned char)*str;
+        int code = ch<128 ? base64table[ ch ] : -1;
         if ( code<0 )
             return (unsigned)-1;
         n = ( n << 6 ) + code;
@@ -303,6 +338,73 @@ static unsigned parseBase64( const char * str )
     return n;
 }
 
+/// splits index line "word<TAB>start<TAB>size" into parts, returns false if line is invalid
+static bool parseIndexLine( const char * line, int len, int & wordLen, unsigned & start, unsigned & size )
+{
+    if ( len>0 && line[len-1]=='\r' )
+        len--;
+    const char * end = line + len;
+    const char * tab1 = (const char *)memchr( line, '\t', len );
+    if ( !tab1 )
+        return false;
+    const char * tab2 = (const char *)memchr( tab1 + 1, '\t', end - tab1 - 1 );
+    if ( !tab2 )
+        return false;
+    wordLen = (int)(tab1 - line);
+    start = parseBase64( tab1 + 1, tab2 );
+    size = parseBase64( tab2 + 1, end );
+    return start!=(unsigned)-1 && size!=(unsigned)-1;
+}
+
+/// compares words like strcmp; words are terminated either by 0 or by TAB of index line
+static int compareIndexWords( const char * word1, const char * word2 )
+{
+    const unsigned char * p1 = (const unsigned char *)word1;
+    const unsigned char * p2 = (const unsigned char *)word2;
+    for ( ;; p1++, p2++ ) {
+        unsigned c1 = *p1=='\t' ? 0 : *p1;
+        unsigned c2 = *p2=='\t' ? 0 : *p2;
+        if ( c1!=c2 )
+            return c1<c2 ? -1 : 1;
+        if ( !c1 )
+            return 0;
+    }
+}
+
+/// returns true if word of index line starts with str, or is equal to str for exact match
+static bool matchIndexWord( const char * word, const char * str, bool exact )
+{
+    for ( ; *str; word++, str++ ) {
+        if ( *word!=*str )
+            return false;
+    }
+    return !exact || *word=='\t';
+}
+
+/// sorts index entries by word (merge sort, keeps order of equal words)
+static void sortIndexEntries( const char * data, unsigned * entries, unsigned * tmp, int count )
+{
+    if ( count<2 )
+        return;
+    int half = count / 2;
+    sortIndexEntries( data, entries, tmp, half );
+    sortIndexEntries( data, entries + half, tmp, count - half );
+    int i = 0;
+    int j = half;
+    int k = 0;
+    while ( i<half && j<count ) {
+        if ( compareIndexWords( data + entries[j], data + entries[i] ) < 0 )
+            tmp[k++] = entries[j++];
+        else
+            tmp[k++] = entries[i++];
+    }
+    while ( i<half )
+        tmp[k++] = entries[i++];
+    while ( j<count )
+        tmp[k++] = entries[j++];
+    memcpy( entries, tmp, sizeof(unsigned) * count );
+}
+
 int TinyDictWord::compare( const char * str ) const
 {
     return strcmp( word, str );
@@ -334,24 +436,18 @@ TinyDictWord * TinyDictWord::read( FILE * f, unsigned index )
     int sz = my_fgets( buf, 1023, f );
 	if ( !sz )
         return NULL;
-    int tabc = 0;
-    int tabs[2];
-    for ( int i=0; buf[i]; i++ ) {
-        if ( buf[i] == '\t' && tabc<2 )
-            tabs[tabc++] = i;
-    }
-    if ( tabc!=2 )
-        return NULL;
-    const char * word = buf;
-    const char * pos_str = buf + tabs[0] + 1;
-    const char * len_str = buf + tabs[1] + 1;
-    buf[tabs[0]] = 0;
-    buf[tabs[1]] = 0;
-    unsigned start = parseBase64( pos_str );
-    unsigned len = parseBase64( len_str );
-    if ( start==(unsigned)-1 || len==(unsigned)-1 )
+    return parse( buf, sz, index, indexpos );
+}
+
+/// factory - parsing index file line of specified length (w/o line end)
+TinyDictWord * TinyDictWord::parse( const char * line, int len, unsigned index, unsigned indexpos )
+{
+    int wordLen;
+    unsigned start;
+    unsigned size;
+    if ( !parseIndexLine( line, len, wordLen, start, size ) )
         return NULL;
-    return new TinyDictWord( index, indexpos, start, len, word );
+    return new TinyDictWord( index, indexpos, start, size, line, wordLen );
 }
 
 int TinyDictWordList::find( const char * prefix )
@@ -388,32 +484,87 @@ bool TinyDictWord::match( const char * str, bool exact ) const
     return str[i]==0;
 }
 
+/// returns first entry which word is not less than str
+int TinyDictIndexFile::lowerBound( const char * str ) const
+{
+    int a = 0;
+    int b = count;
+    while ( a < b ) {
+        int c = (a + b) / 2;
+        if ( compareIndexWords( data + entries[c], str ) < 0 )
+            a = c + 1;
+        else
+            b = c;
+    }
+    return a;
+}
+
 bool TinyDictIndexFile::find( const char * prefix, bool exactMatch, TinyDictWordList & words )
+{
+    return find( &prefix, 1, exactMatch, words );
+}
+
+/// finds words matching any of prefixes, in index order
+bool TinyDictIndexFile::find( const char * const * prefixes, int prefixCount, bool exactMatch, TinyDictWordList & words )
 {
     words.clear();
-    int n = list.find( prefix );
-    if ( n<0 )
-        return false;
-    TinyDictWord * p = list.get( n );
-    if ( fseek( f, p->getIndexPos(), SEEK_SET ) )
+    if ( !data )
         return false;
-    int index = p->getIndex();
-    for ( ;; ) {
-        p = TinyDictWord::read( f, index++ );
-        if ( !p )
-            break;
-        int res = p->compare( prefix );
-        if ( p->match( prefix, exactMatch ) )
-            words.add( p );
-		else {
-            delete p;
-			if ( res > 0 )
-	            break;
+    // matching words of each prefix are adjacent in sorted index
+    int * ranges = (int *)malloc( sizeof(int) * 2 * prefixCount + 1 );
+    int rangeCount = 0;
+    for ( int i=0; i<prefixCount; i++ ) {
+        int start = lowerBound( prefixes[i] );
+        int end = start;
+        while ( end<count && matchIndexWord( data + entries[end], prefixes[i], exactMatch ) )
+            end++;
+        if ( end==start )
+            continue;
+        // keep ranges ordered by start
+        int k = rangeCount++;
+        for ( ; k>0 && ranges[(k-1)*2] > start; k-- ) {
+            ranges[k*2] = ranges[(k-1)*2];
+            ranges[k*2+1] = ranges[(k-1)*2+1];
+        }
+        ranges[k*2] = start;
+        ranges[k*2+1] = end;
+    }
+    // ranges may overlap, e.g. for prefixes "word" and "words"
+    int next = 0;
+    for ( int i=0; i<rangeCount; i++ ) {
+        int n = ranges[i*2] > next ? ranges[i*2] : next;
+        for ( ; n<ranges[i*2+1]; n++ ) {
+            TinyDictWord * p = TinyDictWord::parse( data + entries[n], lineLength( entries[n] ), n, entries[n] );
+            if ( p )
+                words.add( p );
         }
+        if ( n > next )
+            next = n;
     }
+    free( ranges );
     return true;
 }
 
+void TinyDictIndexFile::close()
+{
+    if ( data ) {
+#ifndef _WIN32
+        if ( mapped )
+            munmap( (void *)data, size );
+        else
+#endif
+            free( (void *)data );
+        data = NULL;
+        mapped = false;
+    }
+    if ( entries ) {
+        free( entries );
+        entries = NULL;
+    }
+    count = 0;
+    TinyDictFileBase::close();
+}
+
 bool TinyDictIndexFile::open( const char * filename )
 {
     close();
@@ -433,18 +584,51 @@ bool TinyDictIndexFile::open( const char * filename )
         close();
         return false;
     }
-    // test
-    TinyDictWord * p;
-    count = 0;
-    for ( ;; count++ ) {
-        p = TinyDictWord::read( f, count );
-        if ( !p )
-            break;
-        if ( (count % factor) == 0 ) {
-            list.add( p );
-        } else {
-            delete p;
+#ifndef _WIN32
+    if ( size ) {
+        void * p = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fileno( f ), 0 );
+        if ( p!=MAP_FAILED ) {
+            data = (const char *)p;
+            mapped = true;
+        }
+    }
+#endif
+    if ( !data ) {
+        char * buf = (char *)malloc( size + 1 );
+        if ( fread( buf, 1, size, f )!=size ) {
+            free( buf );
+            close();
+            return false;
+        }
+        data = buf;
+    }
+    // collect offsets of valid lines; index is expected to be sorted already
+    int entriesSize = 0;
+    bool sorted = true;
+    const char * end = data + size;
+    for ( const char * p = data; p < end; ) {
+        const char * eol = (const char *)memchr( p, '\n', end - p );
+        if ( !eol )
+            eol = end;
+        int wordLen;
+        unsigned start;
+        unsigned len;
+        if ( parseIndexLine( p, (int)(eol - p), wordLen, start, len ) ) {
+            if ( count>=entriesSize ) {
+                entriesSize = entriesSize ? entriesSize * 2 : 1024;
+                entries = (unsigned *)realloc( entries, sizeof(unsigned) * entriesSize );
+            }
+            if ( count && sorted && compareIndexWords( data + entries[count-1], p ) > 0 )
+                sorted = false;
+            entries[count++] = (unsigned)(p - data);
         }
+        p = eol + 1;
+    }
+    if ( !sorted ) {
+        printf("index is not sorted, sorting\n");
+        unsigned * tmp = (unsigned *)malloc( sizeof(unsigned) * count );
+        sortIndexEntries( data, entries, tmp, count );
+        free( tmp );
     }
     printf("%d words read from index\n", count);
     return true;
@@ -456,23 +640,21 @@ enum {
     DICT_DZIP,
 };
 
-bool TinyDictZStream::zinit( unsigned char * next_in, unsigned avail_in, unsigned char * next_out, unsigned avail_out )
-{
-    zclose();
-    if ( !zInitialized ) {
-        zStream.zalloc    = NULL;
-        zStream.zfree     = NULL;
-        zStream.opaque    = NULL;
-        zStream.next_in   = next_in;
-        zStream.avail_in  = avail_in;
-        zStream.next_out  = next_out;
-        zStream.avail_out = avail_out;
-        if (inflateInit2( &zStream, -15 ) != Z_OK ) {
-            // zlib initialization failed
-            return false;
-        }
-        zInitialized = true;
+/// prepares inflater for unpacking of next chunk
+bool TinyDictZStream::zinit()
+{
+    if ( zInitialized )
+        return inflateReset( &zStream ) == Z_OK;
+    zStream.zalloc    = NULL;
+    zStream.zfree     = NULL;
+    zStream.opaque    = NULL;
+    zStream.next_in   = NULL;
+    zStream.avail_in  = 0;
+    if (inflateInit2( &zStream, -15 ) != Z_OK ) {
+        // zlib initialization failed
+        return false;
     }
+    zInitialized = true;
 	return true;
 }
 
@@ -487,126 +669,123 @@ bool TinyDictZStream::zclose()
 
 void TinyDictZStream::compact()
 {
-	if ( unp_buffer ) {
-		free( unp_buffer );
-		unp_buffer_start = unp_buffer_len = unp_buffer_size = 0;
-		unp_buffer = NULL;
+	for ( int i=0; i<TINYDICT_CHUNK_CACHE_SIZE; i++ ) {
+		if ( cache[i].data )
+			free( cache[i].data );
+		cache[i].data = NULL;
+		cache[i].len = 0;
+		cache[i].lastUse = 0;
 	}
+	if ( pack_buffer ) {
+		free( pack_buffer );
+		pack_buffer = NULL;
+		pack_buffer_size = 0;
+	}
+	zclose();
 }
 
-bool TinyDictZStream::readChunk( unsigned n )
+/// returns unpacked chunk, from cache if possible
+TinyDictZStream::Chunk * TinyDictZStream::readChunk( unsigned n )
 {
     if ( n >= chunkCount )
-        return false;
-    if ( !unp_buffer ) {
-        unp_buffer = (unsigned char *)malloc( sizeof(unsigned char)*chunkLength );
-        unp_buffer_size = chunkLength;
+        return NULL;
+    // search cache, choosing empty or least recently used slot for the case of miss
+    Chunk * slot = NULL;
+    for ( int i=0; i<TINYDICT_CHUNK_CACHE_SIZE; i++ ) {
+        Chunk * c = &cache[i];
+        if ( c->data && c->index==n ) {
+            c->lastUse = ++useCounter;
+            return c;
+        }
+        if ( !slot || ( slot->data && ( !c->data || c->lastUse < slot->lastUse ) ) )
+            slot = c;
     }
-    unp_buffer_start = n * chunkLength;
+    if ( !slot->data )
+        slot->data = (unsigned char *)malloc( sizeof(unsigned char)*chunkLength );
+    slot->index = (unsigned)-1;
+    slot->len = 0;
 
     if ( fseek( f, offsets[ n ], SEEK_SET ) ) {
         printf( "cannot seek to %d position\n", offsets[n] );
-        return false;
+        return NULL;
     }
     unsigned packsz = chunks[n];
-    unsigned char * tmp = (unsigned char *)malloc( sizeof(unsigned char) * packsz );
-
-    crc.reset();
-    unsigned int bytesRead = readBytes( tmp, packsz );
-    unsigned crc1 = crc.get();
-    unsigned crc2 = readU32();
-    if ( bytesRead != packsz || error ) {
-        printf( "error reading packed data\n" );
-        free( tmp );
-        return false;
+    if ( pack_buffer_size < packsz ) {
+        pack_buffer = (unsigned char *)realloc( pack_buffer, sizeof(unsigned char) * packsz );
+        pack_buffer_size = packsz;
     }
-    if ( crc1!=crc2  ) {
-        printf( "CRC error: real: %08x expected: %08x\n", crc1, crc2 );
-        //free( tmp );
-        //return false;
+    if ( fread( pack_buffer, 1, packsz, f ) != packsz ) {
+        printf( "error reading packed data\n" );
+        return NULL;
     }
-    zclose();
-    if ( !zinit(tmp, packsz, unp_buffer, unp_buffer_size) ) {
+    // chunks are flushed separately: each one is unpacked w/o previous ones
+    if ( !zinit() ) {
         printf("cannot init deflater\n");
-        return false;
+        return NULL;
     }
-    printf("unpacking %d bytes\n", packsz);
+    zStream.next_in   = pack_buffer;
+    zStream.avail_in  = packsz;
+    zStream.next_out  = slot->data;
+    zStream.avail_out = chunkLength;
     int err = inflate( &zStream,  Z_PARTIAL_FLUSH );
-    printf("inflate result: %d\n", err);
-    if ( err != Z_OK ) {
+    if ( err != Z_OK && err != Z_STREAM_END ) {
         printf("Inflate error %s (%d). avail_in=%d, avail_out=%d \n", zStream.msg, err, (int)zStream.avail_in, (int)zStream.avail_out);
-        free( tmp );
-        return false;
+        return NULL;
     }
     if ( zStream.avail_in ) {
         printf("Inflate: not all data read, still %d bytes available\n", (int)zStream.avail_in );
-        free( tmp );
-        return false;
+        return NULL;
     }
-    unp_buffer_len = unp_buffer_size - zStream.avail_out;
-
-    printf("freeing tmp\n");
-    free( tmp );
-    printf("done\n");
-
-
-
-    if ( n < chunkCount-1 && unp_buffer_len!=chunkLength ) {
+    unsigned len = chunkLength - zStream.avail_out;
+    if ( n < chunkCount-1 && len!=chunkLength ) {
         printf("wrong chunk length\n");
-        return false; // too short chunk data
+        return NULL; // too short chunk data
     }
-
-
-    zclose();
-    return true;
+    slot->index = n;
+    slot->len = len;
+    slot->lastUse = ++useCounter;
+    return slot;
 }
 
 bool TinyDictZStream::read( unsigned char * buf, unsigned start, unsigned len )
 {
-    if ( start >= unp_buffer_start && start < unp_buffer_start + unp_buffer_len ) {
-        unsigned readyBytes = unp_buffer_len - (start-unp_buffer_start);
+    // article may span several chunks
+    while ( len ) {
+        unsigned n = start / chunkLength;
+        Chunk * chunk = readChunk( n );
+        if ( !chunk )
+            return false;
+        unsigned offset = start - n * chunkLength;
+        if ( offset >= chunk->len )
+            return false;
+        unsigned readyBytes = chunk->len - offset;
         if ( readyBytes > len )
             readyBytes = len;
-        memcpy( buf, unp_buffer + (start-unp_buffer_start), readyBytes );
+        memcpy( buf, chunk->data + offset, readyBytes );
         buf += readyBytes;
         start += readyBytes;
         len -= readyBytes;
-        if ( !len )
-            return true;
     }
-    unsigned n = start / chunkLength;
-    if ( !readChunk( n ) )
-        return false;
-    unsigned readyBytes = unp_buffer_len - (start-unp_buffer_start);
-    if ( readyBytes > len )
-        readyBytes = len;
-    memcpy( buf, unp_buffer + (start-unp_buffer_start), readyBytes );
-    buf += readyBytes;
-    start += readyBytes;
-    len -= readyBytes;
-    if ( !len )
-        return true;
-    return false;
+    return true;
 }
 
 TinyDictZStream::TinyDictZStream()
 : f ( NULL ), size( 0 ), txtpos(0)
 , headerLength(0), error( false )
 , chunks(NULL), offsets(NULL), chunkLength(0), chunkCount(0)
-, zInitialized(false), packed_size(0), unp_buffer(NULL), unp_buffer_start(0), unp_buffer_len(0), unp_buffer_size(0)
+, zInitialized(false), packed_size(0), pack_buffer(NULL), pack_buffer_size(0), useCounter(0)
 {
     memset( &zStream, 0, sizeof(zStream) );
+    memset( cache, 0, sizeof(cache) );
 }
 
 TinyDictZStream::~TinyDictZStream()
 {
-    zclose();
-    if ( unp_buffer )
-        free( unp_buffer );
+    compact();
     if ( chunks )
-        delete chunks;
+        delete[] chunks;
     if ( offsets )
-        delete offsets;
+        delete[] offsets;
 }
 
 bool TinyDictZStream::open( FILE * file )
@@ -707,11 +886,12 @@ bool TinyDictZStream::open( FILE * file )
         return false;
     }
 
-    if ( !readChunk( chunkCount-1 ) ) {
+    Chunk * last = readChunk( chunkCount-1 );
+    if ( !last ) {
         printf("Error reading chunk %d\n", chunkCount-1 );
         return false;
     }
-    size = unp_buffer_start + unp_buffer_len;
+    size = (chunkCount-1) * chunkLength + last->len;
 
 	compact();
     return true;
@@ -727,14 +907,12 @@ const char * TinyDictDataFile::read( const TinyDictWord * w )
     reserve( w->getSize() + 1 );
     if ( !compressed ) {
         // uncompressed
-        printf("reading uncompressed article\n");
         if ( fseek( f, w->getStart(), SEEK_SET ) )
             return NULL;
         if ( fread( buf, 1, w->getSize(), f ) != w->getSize() )
             return NULL;
     } else {
         // compressed
-        printf("reading compressed article\n");
         if ( !zstream.read( (unsigned char*)buf, w->getStart(), w->getSize() ) )
             return NULL;
     }
@@ -850,10 +1028,16 @@ const char * TinyDictWordList::getArticle( int index )
 
 /// searches dictionary for specified word, caller is responsible for deleting of returned object
 TinyDictWordList * TinyDictionary::find( const char * prefix, int options )
+{
+	return find( &prefix, 1, options );
+}
+
+/// searches dictionary for several words at once, matches are returned in index order w/o duplicates
+TinyDictWordList * TinyDictionary::find( const char * const * prefixes, int prefixCount, int options )
 {
 	TinyDictWordList * list = new TinyDictWordList();
 	list->setDict( this );
-	if ( index->find( prefix, (TINY_DICT_OPTION_STARTS_WITH & options) == 0, *list ) && list->length()>0 )
+	if ( index->find( prefixes, prefixCount, (TINY_DICT_OPTION_STARTS_WITH & options) == 0, *list ) && list->length()>0 )
 		return list;
 	delete list;
 	return NULL;
@@ -897,10 +1081,16 @@ TinyDictionaryList::~TinyDictionaryList()
 
 /// search all dictionaries in list for specified pattern
 bool TinyDictionaryList::find( TinyDictResultList & result, const char * prefix, int options )
+{
+	return find( result, &prefix, 1, options );
+}
+
+/// search all dictionaries in list for several patterns (e.g. word forms), one result item per dictionary
+bool TinyDictionaryList::find( TinyDictResultList & result, const char * const * prefixes, int prefixCount, int options )
 {
 	result.clear();
 	for ( int i=0; i<count; i++ ) {
-		TinyDictWordList * p = list[i]->find( prefix, options );
+		TinyDictWordList * p = list[i]->find( prefixes, prefixCount, options );
 		if ( p )
 			result.add( p );
 	}
@@ -25,6 +25,8 @@
 			// container for results
 			TinyDictResultList results;
 		    dicts.find(results, "word", 0 ); // find exact match
+		    const char * forms[] = { "word", "words" };
+		    dicts.find(results, forms, 2, 0 ); // find several words in one pass
 
 		process results:
 			// for each source dictionary that matches pattern
@@ -63,17 +65,21 @@ class TinyDictWord
     unsigned start;
     unsigned size;
     char * word;
-    TinyDictWord( unsigned _index, unsigned _indexpos, unsigned _start, unsigned _size, const char * _word )
+    TinyDictWord( unsigned _index, unsigned _indexpos, unsigned _start, unsigned _size, const char * _word, int _wordLen )
     : index(_index)
     , indexpos(_indexpos)
     , start(_start)
     , size(_size)
-    , word( strdup(_word) )
+    , word( (char *)malloc( _wordLen + 1 ) )
     {
+        memcpy( word, _word, _wordLen );
+        word[_wordLen] = 0;
     }
 public:
     /// factory - reading from index file
     static TinyDictWord * read( FILE * f, unsigned index );
+    /// factory - parsing index file line of specified length (w/o line end)
+    static TinyDictWord * parse( const char * line, int len, unsigned index, unsigned indexpos );
 
     // getters
     unsigned getIndexPos() const { return indexpos; }
@@ -138,6 +144,8 @@ class TinyDictionary
 public:
 	/// searches dictionary for specified word, caller is responsible for deleting of returned object
     TinyDictWordList * find( const char * prefix, int options = 0 );
+	/// searches dictionary for several words at once, matches are returned in index order w/o duplicates
+    TinyDictWordList * find( const char * const * prefixes, int prefixCount, int options = 0 );
 	/// returns short dictionary name
 	const char * getDictionaryName();
 	/// get dictionary data pointer
@@ -187,6 +195,8 @@ class TinyDictionaryList
 public:
 	/// search all dictionaries in list for specified pattern
 	bool find( TinyDictResultList & result, const char * prefix, int options = 0 );
+	/// search all dictionaries in list for several patterns (e.g. word forms), one result item per dictionary
+	bool find( TinyDictResultList & result, const char * const * prefixes, int prefixCount, int options = 0 );
 
 	// word list functions
 	/// returns number of words in list
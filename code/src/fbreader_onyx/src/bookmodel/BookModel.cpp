@@ -22,6 +22,7 @@
 
 #include "BookModel.h"
 #include "BookReader.h"
+#include "BookModelCache.h"
 
 #include "../formats/FormatPlugin.h"
 
@@ -32,10 +33,13 @@ BookModel::BookModel(const BookDescriptionPtr description)
 {
   myBookTextModel.reset(new ZLTextPlainModel(102400));
   myContentsModel.reset(new ContentsModel());
+	if (BookModelCache::load(*this)) {
+		return;
+	}
 	ZLFile file(description->fileName());
 	FormatPlugin *plugin = PluginCollection::instance().plugin(file, false);
-	if (plugin != 0) {
-		plugin->readModel(*description, *this);
+	if ((plugin != 0) && plugin->readModel(*description, *this)) {
+		BookModelCache::save(*this);
 	}
 }
 
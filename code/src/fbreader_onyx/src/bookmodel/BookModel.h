@@ -88,6 +88,7 @@ private:
 	OpenStatus myOpenStatus;
 
 friend class BookReader;
+friend class BookModelCache;
 };
 
 inline shared_ptr<ZLTextModel> BookModel::bookTextModel() const { return myBookTextModel; }
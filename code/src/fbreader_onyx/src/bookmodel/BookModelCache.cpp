@@ -0,0 +1,485 @@
+/*
+ * Copyright (C) 2004-2009 Geometer Plus <contact@geometerplus.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <vector>
+
+#ifndef _WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <ZLibrary.h>
+#include <ZLFile.h>
+#include <ZLDir.h>
+#include <ZLInputStream.h>
+#include <ZLOutputStream.h>
+#include <ZLImage.h>
+#include <ZLFileImage.h>
+#include <ZLStringUtil.h>
+
+#include "BookModelCache.h"
+#include "BookModel.h"
+
+#include "../formats/fb2/Base64EncodedImage.h"
+#include "../formats/rtf/RtfImage.h"
+#include "../formats/pdb/PluckerImages.h"
+
+#ifndef BOOK_MODEL_CACHE_SIZE
+#define BOOK_MODEL_CACHE_SIZE 10
+#endif
+
+// total size of cache files, the oldest ones are removed above it
+#ifndef BOOK_MODEL_CACHE_MAX_SIZE
+#define BOOK_MODEL_CACHE_MAX_SIZE 0x2000000 // 32Mb
+#endif
+
+// File layout (numbers are in native byte order):
+//   magic, version, layout, text model snapshot format,
+//   book path, size, modification time, encoding,
+//   book text model, contents model, contents references,
+//   footnote models, hyperlink labels,
+//   data of images that can't be read from a file on demand,
+//   image table (id, mime type, reference kind, path, offset, size;
+//   empty path stands for this file), image table offset, magic
+//
+// CACHE_VERSION is bumped whenever this layout changes; text model entries
+// are checked by ZLTextModel::snapshotFormat().
+static const char CACHE_MAGIC[4] = { 'F', 'B', 'M', 'C' };
+static const unsigned int CACHE_VERSION = 1;
+static const unsigned int CACHE_LAYOUT = sizeof(size_t) | (sizeof(char*) << 8);
+static const std::string CACHE_EXTENSION = "cache";
+
+class BookModelCacheData : public ZLUserData {
+
+public:
+	BookModelCacheData(char *data, size_t size, bool isMapped);
+	~BookModelCacheData();
+
+	char *data() const;
+	size_t size() const;
+
+private:
+	char *myData;
+	size_t mySize;
+	bool myIsMapped;
+};
+
+BookModelCacheData::BookModelCacheData(char *data, size_t size, bool isMapped) : myData(data), mySize(size), myIsMapped(isMapped) {
+}
+
+BookModelCacheData::~BookModelCacheData() {
+#ifndef _WINDOWS
+	if (myIsMapped) {
+		munmap(myData, mySize);
+		return;
+	}
+#endif
+	delete[] myData;
+}
+
+inline char *BookModelCacheData::data() const { return myData; }
+inline size_t BookModelCacheData::size() const { return mySize; }
+
+static shared_ptr<BookModelCacheData> openCacheFile(const std::string &fileName) {
+#ifndef _WINDOWS
+	// text models use the data in place and image entries are patched on
+	// load, so the mapping is private and writable
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd != -1) {
+		void *data = MAP_FAILED;
+		struct stat fileStat;
+		if ((fstat(fd, &fileStat) == 0) && (fileStat.st_size > 0)) {
+			data = mmap(0, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		}
+		close(fd);
+		if (data != MAP_FAILED) {
+			return shared_ptr<BookModelCacheData>(new BookModelCacheData((char*)data, fileStat.st_size, true));
+		}
+	}
+#endif
+	shared_ptr<ZLInputStream> stream = ZLFile(fileName).inputStream();
+	if (!stream || !stream->open()) {
+		return shared_ptr<BookModelCacheData>();
+	}
+	const size_t size = stream->sizeOfOpened();
+	char *data = new char[size];
+	if (stream->read(data, size) != size) {
+		delete[] data;
+		return shared_ptr<BookModelCacheData>();
+	}
+	return shared_ptr<BookModelCacheData>(new BookModelCacheData(data, size, false));
+}
+
+static void writeNumber(std::string &buffer, unsigned int number) {
+	buffer.append((const char*)&number, sizeof(unsigned int));
+}
+
+static void writeString(std::string &buffer, const std::string &str) {
+	writeNumber(buffer, str.length());
+	buffer.append(str);
+}
+
+static bool readNumber(char *&data, const char *end, unsigned int &number) {
+	if (end - data < (int)sizeof(unsigned int)) {
+		return false;
+	}
+	memcpy(&number, data, sizeof(unsigned int));
+	data += sizeof(unsigned int);
+	return true;
+}
+
+static bool readString(char *&data, const char *end, std::string &str) {
+	unsigned int length;
+	if (!readNumber(data, end, length) || ((size_t)(end - data) < length)) {
+		return false;
+	}
+	str.assign(data, length);
+	data += length;
+	return true;
+}
+
+static shared_ptr<const ZLImage> createImage(const std::string &mimeType, const ZLSingleImage::FileReference &reference) {
+	ZLImage *image = 0;
+	if (reference.Kind == ZLFileImage::KIND) {
+		image = new ZLFileImage(mimeType, reference.Path, reference.Offset, reference.Size);
+	} else if (reference.Kind == Base64EncodedImage::KIND) {
+		image = new Base64EncodedImage(mimeType, reference.Path, reference.Offset, reference.Size);
+	} else if (reference.Kind == RtfImage::KIND) {
+		image = new RtfImage(mimeType, reference.Path, reference.Offset, reference.Size);
+	} else if (reference.Kind == ZCompressedFileImage::KIND) {
+		image = new ZCompressedFileImage(mimeType, reference.Path, reference.Offset, reference.Size);
+	} else if (reference.Kind == DocCompressedFileImage::KIND) {
+		image = new DocCompressedFileImage(mimeType, reference.Path, reference.Offset, reference.Size);
+	}
+	return shared_ptr<const ZLImage>(image);
+}
+
+std::string BookModelCache::directoryName() {
+	const char *home = getenv("HOME");
+	return
+		std::string((home != 0) ? home : ".") + ZLibrary::FileNameDelimiter +
+		ZLibrary::ApplicationName() + ZLibrary::FileNameDelimiter + "cache";
+}
+
+std::string BookModelCache::fileName(const std::string &bookFileName) {
+	unsigned int hash = 2166136261U;
+	for (std::string::const_iterator it = bookFileName.begin(); it != bookFileName.end(); ++it) {
+		hash = (hash ^ (unsigned char)*it) * 16777619U;
+	}
+	std::string name = directoryName() + ZLibrary::FileNameDelimiter;
+	ZLStringUtil::appendNumber(name, hash);
+	return name + '.' + CACHE_EXTENSION;
+}
+
+bool BookModelCache::load(BookModel &model) {
+	const std::string &bookFileName = model.fileName();
+	const std::string cacheFileName = fileName(bookFileName);
+	if (!ZLFile(cacheFileName).exists()) {
+		return false;
+	}
+	shared_ptr<BookModelCacheData> cache = openCacheFile(cacheFileName);
+	if (!cache || (cache->size() < 2 * sizeof(CACHE_MAGIC) + sizeof(unsigned int))) {
+		return false;
+	}
+
+	char *data = cache->data();
+	char *end = data + cache->size() - sizeof(CACHE_MAGIC) - sizeof(unsigned int);
+	unsigned int tableOffset;
+	memcpy(&tableOffset, end, sizeof(unsigned int));
+	if ((memcmp(data, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) ||
+			(memcmp(end + sizeof(unsigned int), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) ||
+			(tableOffset > (size_t)(end - data))) {
+		return false;
+	}
+	data += sizeof(CACHE_MAGIC);
+
+	const ZLFile bookFile(bookFileName);
+	unsigned int version;
+	unsigned int layout;
+	std::string snapshotFormat;
+	std::string path;
+	unsigned int size;
+	unsigned int mTime;
+	std::string encoding;
+	if (!readNumber(data, end, version) || (version != CACHE_VERSION) ||
+			!readNumber(data, end, layout) || (layout != CACHE_LAYOUT) ||
+			!readString(data, end, snapshotFormat) || (snapshotFormat != ZLTextModel::snapshotFormat()) ||
+			!readString(data, end, path) || (path != bookFileName) ||
+			!readNumber(data, end, size) || (size != (unsigned int)bookFile.size()) ||
+			!readNumber(data, end, mTime) || (mTime != (unsigned int)bookFile.mTime()) ||
+			!readString(data, end, encoding) || (encoding != model.description()->encoding())) {
+		return false;
+	}
+
+	shared_ptr<ZLTextModel> bookTextModel(new ZLTextPlainModel(102400));
+	shared_ptr<ZLTextModel> contentsModel(new ContentsModel());
+	if (!bookTextModel->readSnapshot(data, end, model.myImages, cache) ||
+			!contentsModel->readSnapshot(data, end, model.myImages, cache)) {
+		return false;
+	}
+
+	unsigned int referencesNumber;
+	if (!readNumber(data, end, referencesNumber) || (referencesNumber != contentsModel->paragraphsNumber())) {
+		return false;
+	}
+	for (unsigned int i = 0; i < referencesNumber; ++i) {
+		unsigned int reference;
+		if (!readNumber(data, end, reference)) {
+			return false;
+		}
+		if ((int)reference != -1) {
+			((ContentsModel&)*contentsModel).setReference((const ZLTextTreeParagraph*)(*contentsModel)[i], (int)reference);
+		}
+	}
+
+	std::map<std::string,shared_ptr<ZLTextModel> > footnotes;
+	std::vector<shared_ptr<ZLTextModel> > models;
+	models.push_back(bookTextModel);
+	unsigned int footnotesNumber;
+	if (!readNumber(data, end, footnotesNumber)) {
+		return false;
+	}
+	for (unsigned int i = 0; i < footnotesNumber; ++i) {
+		std::string id;
+		shared_ptr<ZLTextModel> footnoteModel(new ZLTextPlainModel(8192));
+		if (!readString(data, end, id) || !footnoteModel->readSnapshot(data, end, model.myImages, cache)) {
+			return false;
+		}
+		footnotes.insert(std::pair<std::string,shared_ptr<ZLTextModel> >(id, footnoteModel));
+		models.push_back(footnoteModel);
+	}
+
+	std::map<std::string,BookModel::Label> hyperlinks;
+	unsigned int hyperlinksNumber;
+	if (!readNumber(data, end, hyperlinksNumber)) {
+		return false;
+	}
+	for (unsigned int i = 0; i < hyperlinksNumber; ++i) {
+		std::string label;
+		unsigned int modelNumber;
+		unsigned int paragraphNumber;
+		if (!readString(data, end, label) ||
+				!readNumber(data, end, modelNumber) || (modelNumber >= models.size()) ||
+				!readNumber(data, end, paragraphNumber)) {
+			return false;
+		}
+		hyperlinks.insert(std::pair<std::string,BookModel::Label>(
+			label, BookModel::Label(models[modelNumber], (int)paragraphNumber)
+		));
+	}
+
+	ZLImageMap images;
+	data = cache->data() + tableOffset;
+	unsigned int imagesNumber;
+	if (!readNumber(data, end, imagesNumber)) {
+		return false;
+	}
+	for (unsigned int i = 0; i < imagesNumber; ++i) {
+		std::string id;
+		std::string mimeType;
+		ZLSingleImage::FileReference reference;
+		unsigned int offset;
+		unsigned int imageSize;
+		if (!readString(data, end, id) || !readString(data, end, mimeType) ||
+				!readString(data, end, reference.Kind) || !readString(data, end, reference.Path) ||
+				!readNumber(data, end, offset) || !readNumber(data, end, imageSize)) {
+			return false;
+		}
+		if (reference.Path.empty()) {
+			if ((imageSize == 0) || (offset > tableOffset) || (imageSize > tableOffset - offset)) {
+				return false;
+			}
+			reference.Path = cacheFileName;
+		}
+		reference.Offset = offset;
+		reference.Size = imageSize;
+		shared_ptr<const ZLImage> image = createImage(mimeType, reference);
+		if (!image) {
+			return false;
+		}
+		images[id] = image;
+	}
+
+	model.myBookTextModel = bookTextModel;
+	model.myContentsModel = contentsModel;
+	model.myFootnotes.swap(footnotes);
+	model.myInternalHyperlinks.swap(hyperlinks);
+	// image entries refer to this map, so it is filled in place
+	model.myImages.swap(images);
+
+#ifndef _WINDOWS
+	// modification time of the cache file is used as last access time
+	utime(cacheFileName.c_str(), 0);
+#endif
+	return true;
+}
+
+void BookModelCache::save(const BookModel &model) {
+	// decrypted text of a DRM book must not be stored
+	if (model.drm()) {
+		return;
+	}
+	for (ZLImageMap::const_iterator it = model.myImages.begin(); it != model.myImages.end(); ++it) {
+		if (it->second && !it->second->isSingle()) {
+			return;
+		}
+	}
+
+	const std::string &bookFileName = model.fileName();
+	const ZLFile bookFile(bookFileName);
+	std::string buffer;
+	buffer.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writeNumber(buffer, CACHE_VERSION);
+	writeNumber(buffer, CACHE_LAYOUT);
+	writeString(buffer, ZLTextModel::snapshotFormat());
+	writeString(buffer, bookFileName);
+	writeNumber(buffer, bookFile.size());
+	writeNumber(buffer, bookFile.mTime());
+	writeString(buffer, model.description()->encoding());
+
+	if (!model.myBookTextModel->writeSnapshot(buffer) || !model.myContentsModel->writeSnapshot(buffer)) {
+		return;
+	}
+
+	const ContentsModel &contentsModel = (const ContentsModel&)*model.myContentsModel;
+	writeNumber(buffer, contentsModel.paragraphsNumber());
+	for (size_t i = 0; i < contentsModel.paragraphsNumber(); ++i) {
+		writeNumber(buffer, contentsModel.reference((const ZLTextTreeParagraph*)contentsModel[i]));
+	}
+
+	std::map<const ZLTextModel*,unsigned int> modelNumbers;
+	modelNumbers[model.myBookTextModel.get()] = 0;
+	writeNumber(buffer, model.myFootnotes.size());
+	for (std::map<std::string,shared_ptr<ZLTextModel> >::const_iterator it = model.myFootnotes.begin(); it != model.myFootnotes.end(); ++it) {
+		writeString(buffer, it->first);
+		if (!it->second->writeSnapshot(buffer)) {
+			return;
+		}
+		const unsigned int number = modelNumbers.size();
+		modelNumbers[it->second.get()] = number;
+	}
+
+	std::string hyperlinks;
+	unsigned int hyperlinksNumber = 0;
+	for (std::map<std::string,BookModel::Label>::const_iterator it = model.myInternalHyperlinks.begin(); it != model.myInternalHyperlinks.end(); ++it) {
+		std::map<const ZLTextModel*,unsigned int>::const_iterator jt = modelNumbers.find(it->second.Model.get());
+		if (jt != modelNumbers.end()) {
+			writeString(hyperlinks, it->first);
+			writeNumber(hyperlinks, jt->second);
+			writeNumber(hyperlinks, it->second.ParagraphNumber);
+			++hyperlinksNumber;
+		}
+	}
+	writeNumber(buffer, hyperlinksNumber);
+	buffer.append(hyperlinks);
+
+	const std::string directory = directoryName();
+	ZLFile(directory.substr(0, directory.rfind(ZLibrary::FileNameDelimiter))).directory(true);
+	if (!ZLFile(directory).directory(true)) {
+		return;
+	}
+	const std::string cacheFileName = fileName(bookFileName);
+	shared_ptr<ZLOutputStream> stream = ZLFile(cacheFileName).outputStream();
+	if (!stream || !stream->open()) {
+		return;
+	}
+	stream->write(buffer);
+
+	// images read from a file on demand are stored as references, so they
+	// are not decoded here; data of other images goes straight to the file,
+	// so only one image is in memory
+	size_t offset = buffer.length();
+	std::string table;
+	unsigned int imagesNumber = 0;
+	for (ZLImageMap::const_iterator it = model.myImages.begin(); it != model.myImages.end(); ++it) {
+		if (!it->second) {
+			continue;
+		}
+		const ZLSingleImage &image = (const ZLSingleImage&)*it->second;
+		ZLSingleImage::FileReference reference;
+		if (image.fileReference(reference)) {
+			writeString(table, it->first);
+			writeString(table, image.mimeType());
+			writeString(table, reference.Kind);
+			writeString(table, reference.Path);
+			writeNumber(table, reference.Offset);
+			writeNumber(table, reference.Size);
+			++imagesNumber;
+			continue;
+		}
+		shared_ptr<std::string> data = image.stringData();
+		if (!data || data->empty()) {
+			continue;
+		}
+		stream->write(*data);
+		writeString(table, it->first);
+		writeString(table, image.mimeType());
+		writeString(table, ZLFileImage::KIND);
+		writeString(table, std::string());
+		writeNumber(table, offset);
+		writeNumber(table, data->length());
+		offset += data->length();
+		++imagesNumber;
+	}
+
+	buffer.erase();
+	writeNumber(buffer, imagesNumber);
+	buffer.append(table);
+	writeNumber(buffer, offset);
+	buffer.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	stream->write(buffer);
+	stream->close();
+
+	removeOldFiles(cacheFileName);
+}
+
+void BookModelCache::removeOldFiles(const std::string &currentFileName) {
+	shared_ptr<ZLDir> dir = ZLFile(directoryName()).directory();
+	if (!dir) {
+		return;
+	}
+	std::vector<std::string> names;
+	dir->collectFiles(names, false);
+	std::multimap<unsigned long,std::string> filesByTime;
+	size_t totalSize = ZLFile(currentFileName).size();
+	for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+		const ZLFile file(dir->itemPath(*it));
+		if ((file.extension() == CACHE_EXTENSION) && (file.path() != currentFileName)) {
+			filesByTime.insert(std::pair<unsigned long,std::string>(file.mTime(), file.path()));
+			totalSize += file.size();
+		}
+	}
+	size_t filesNumber = filesByTime.size() + 1;
+	for (std::multimap<unsigned long,std::string>::const_iterator it = filesByTime.begin(); it != filesByTime.end(); ++it) {
+		if ((filesNumber <= BOOK_MODEL_CACHE_SIZE) && (totalSize <= BOOK_MODEL_CACHE_MAX_SIZE)) {
+			break;
+		}
+		const ZLFile file(it->second);
+		totalSize -= file.size();
+		file.remove();
+		--filesNumber;
+	}
+}
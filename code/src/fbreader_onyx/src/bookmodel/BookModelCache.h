@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2004-2009 Geometer Plus <contact@geometerplus.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __BOOKMODELCACHE_H__
+#define __BOOKMODELCACHE_H__
+
+#include <string>
+
+class BookModel;
+
+// Keeps models of recently opened books on disk, so reopening a book does
+// not need to parse it again. Cache file is keyed by book file path, size,
+// modification time and encoding; text models are mapped into memory from
+// the cache file as is, images are read from it on demand.
+class BookModelCache {
+
+public:
+	static bool load(BookModel &model);
+	static void save(const BookModel &model);
+
+private:
+	static std::string directoryName();
+	static std::string fileName(const std::string &bookFileName);
+	static void removeOldFiles(const std::string &currentFileName);
+
+private:
+	BookModelCache();
+};
+
+#endif /* __BOOKMODELCACHE_H__ */
@@ -17,27 +17,57 @@
  * 02110-1301, USA.
  */
 
-#include <ZLStringUtil.h>
+#include <list>
+#include <algorithm>
+
+#include <ZLFile.h>
+#include <ZLInputStream.h>
 
 #include "Base64EncodedImage.h"
 
-void Base64EncodedImage::addData(const std::vector<std::string> &text) {
-	ZLStringUtil::append(myEncodedData, text);
-}
+#ifndef BASE64_IMAGE_CACHE_SIZE
+#define BASE64_IMAGE_CACHE_SIZE 4
+#endif
+
+const std::string Base64EncodedImage::KIND = "base64";
+
+typedef std::list<std::pair<const Base64EncodedImage*,shared_ptr<std::string> > > DecodedImageList;
+
+// most recently used first
+static DecodedImageList ourDecodedImages;
 
-void Base64EncodedImage::decode() const {
-	if ((myEncodedData.empty()) || myData) {
-		return;
+Base64EncodedImage::~Base64EncodedImage() {
+	for (DecodedImageList::iterator it = ourDecodedImages.begin(); it != ourDecodedImages.end(); ++it) {
+		if (it->first == this) {
+			ourDecodedImages.erase(it);
+			break;
+		}
 	}
+}
 
-	size_t dataLength = myEncodedData.length();
+shared_ptr<std::string> Base64EncodedImage::decode() const {
+	shared_ptr<std::string> data(new std::string());
+	shared_ptr<ZLInputStream> stream = ZLFile(myFileName).inputStream();
+	if (!stream || !stream->open()) {
+		return data;
+	}
+	stream->seek(myOffset, false);
 
-	myData.reset(new std::string());
-	myData->reserve(dataLength / 4 * 3);
-	for (size_t pos = 0, dataPos = 0; pos < dataLength; dataPos += 3) {
-		unsigned int sum = 0;
-		for (int i = 0; (i < 4) && (pos < dataLength); ++pos) {
-			char encodedByte = myEncodedData[pos];
+	data->reserve(mySize / 4 * 3);
+	const size_t BUFFER_SIZE = 8192;
+	char buffer[BUFFER_SIZE];
+	unsigned int sum = 0;
+	int i = 0;
+	bool tripleStarted = false;
+	for (size_t left = mySize; left > 0;) {
+		const size_t length = stream->read(buffer, std::min(left, BUFFER_SIZE));
+		if (length == 0) {
+			break;
+		}
+		left -= length;
+		for (const char *ptr = buffer; ptr < buffer + length; ++ptr) {
+			tripleStarted = true;
+			const char encodedByte = *ptr;
 			unsigned int number = 0;
 			if (('A' <= encodedByte) && (encodedByte <= 'Z')) {
 				number = encodedByte - 'A';
@@ -55,19 +85,43 @@ void Base64EncodedImage::decode() const {
 				continue;
 			}
 			sum += number << (6 * (3 - i));
-			++i;
-		}
-		char triple[3];
-		for (int j = 2; j >= 0; --j) {
-			triple[j] = sum & 0xff;
-			sum >>= 8;
+			if (++i == 4) {
+				const char triple[3] = { (char)(sum >> 16), (char)(sum >> 8), (char)sum };
+				data->append(triple, 3);
+				sum = 0;
+				i = 0;
+				tripleStarted = false;
+			}
 		}
-		myData->append(triple, 3);
 	}
-	std::string().swap(myEncodedData);
+	if (tripleStarted) {
+		const char triple[3] = { (char)(sum >> 16), (char)(sum >> 8), (char)sum };
+		data->append(triple, 3);
+	}
+	stream->close();
+	return data;
 }
 
 const shared_ptr<std::string> Base64EncodedImage::stringData() const {
-	decode();
-	return myData;
+	for (DecodedImageList::iterator it = ourDecodedImages.begin(); it != ourDecodedImages.end(); ++it) {
+		if (it->first == this) {
+			ourDecodedImages.splice(ourDecodedImages.begin(), ourDecodedImages, it);
+			return it->second;
+		}
+	}
+
+	shared_ptr<std::string> data = decode();
+	ourDecodedImages.push_front(std::make_pair(this, data));
+	if (ourDecodedImages.size() > BASE64_IMAGE_CACHE_SIZE) {
+		ourDecodedImages.pop_back();
+	}
+	return data;
+}
+
+bool Base64EncodedImage::fileReference(FileReference &reference) const {
+	reference.Kind = KIND;
+	reference.Path = myFileName;
+	reference.Offset = myOffset;
+	reference.Size = mySize;
+	return true;
 }
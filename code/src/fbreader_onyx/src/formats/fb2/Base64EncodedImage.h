@@ -20,27 +20,32 @@
 #ifndef __BASE64ENCODEDIMAGE_H__
 #define __BASE64ENCODEDIMAGE_H__
 
-#include <vector>
+#include <string>
 
 #include <ZLImage.h>
 
+// Image stored as base64 text in a part of a file; it is read and decoded
+// on demand, a few recently decoded images are kept in memory.
 class Base64EncodedImage : public ZLSingleImage {
 
 public:
-	Base64EncodedImage(const std::string &mimeType);
+	static const std::string KIND;
+
+public:
+	Base64EncodedImage(const std::string &mimeType, const std::string &fileName, size_t offset, size_t size);
 	~Base64EncodedImage();
-	void addData(const std::vector<std::string> &text);
 	const shared_ptr<std::string> stringData() const;
+	bool fileReference(FileReference &reference) const;
 
 private:
-	void decode() const;
+	shared_ptr<std::string> decode() const;
 
 private:
-	mutable std::string myEncodedData;
-	mutable shared_ptr<std::string> myData;
+	const std::string myFileName;
+	const size_t myOffset;
+	const size_t mySize;
 };
 
-inline Base64EncodedImage::Base64EncodedImage(const std::string &mimeType) : ZLSingleImage(mimeType) {}
-inline Base64EncodedImage::~Base64EncodedImage() {}
+inline Base64EncodedImage::Base64EncodedImage(const std::string &mimeType, const std::string &fileName, size_t offset, size_t size) : ZLSingleImage(mimeType), myFileName(fileName), myOffset(offset), mySize(size) {}
 
 #endif /* __BASE64ENCODEDIMAGE_H__ */
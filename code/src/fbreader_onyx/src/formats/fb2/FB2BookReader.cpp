@@ -37,22 +37,19 @@ FB2BookReader::FB2BookReader(BookModel &model) : myModelReader(model) {
 	mySectionDepth = 0;
 	myBodyCounter = 0;
 	myReadMainText = false;
-	myCurrentImage = 0;
+	myCurrentImageOffset = 0;
 	myProcessingImage = false;
 	mySectionStarted = false;
 	myInsideTitle = false;
 }
 
 void FB2BookReader::characterDataHandler(const char *text, size_t len) {
-	if ((len > 0) && (myProcessingImage || myModelReader.paragraphIsOpen())) {
+	// binary content is not copied, images read it from the file on demand
+	if ((len > 0) && !myProcessingImage && myModelReader.paragraphIsOpen()) {
 		std::string str(text, len);
-		if (myProcessingImage) {
-			myImageBuffer.push_back(str);
-		} else {
-			myModelReader.addData(str);
-			if (myInsideTitle) {
-				myModelReader.addContentsData(str);
-			}
+		myModelReader.addData(str);
+		if (myInsideTitle) {
+			myModelReader.addContentsData(str);
 		}
 	}
 }
@@ -199,8 +196,9 @@ void FB2BookReader::startElementHandler(int tag, const char **xmlattributes) {
 		{
 			const char *contentType = attributeValue(xmlattributes, "content-type");
 			if ((contentType != 0) && (id != 0)) {
-				myCurrentImage = new Base64EncodedImage(contentType);
-				myModelReader.addImage(id, shared_ptr<const ZLImage>(myCurrentImage));
+				myCurrentImageId = id;
+				myCurrentImageType = contentType;
+				myCurrentImageOffset = currentByteOffset() + currentByteCount();
 				myProcessingImage = true;
 			}
 			break;
@@ -299,10 +297,13 @@ void FB2BookReader::endElementHandler(int tag) {
 			myModelReader.addControl(myHyperlinkType, false);
 			break;
 		case _BINARY:
-			if (!myImageBuffer.empty() && (myCurrentImage != 0)) {
-				myCurrentImage->addData(myImageBuffer);
-				myImageBuffer.clear();
-				myCurrentImage = 0;
+			if (myProcessingImage) {
+				const size_t endOffset = currentByteOffset();
+				if (endOffset > myCurrentImageOffset) {
+					myModelReader.addImage(myCurrentImageId, shared_ptr<const ZLImage>(
+						new Base64EncodedImage(myCurrentImageType, myFileName, myCurrentImageOffset, endOffset - myCurrentImageOffset)
+					));
+				}
 			}
 			myProcessingImage = false;
 			break;
@@ -333,5 +334,6 @@ void FB2BookReader::namespaceListChangedHandler() {
 
 bool FB2BookReader::readBook(const std::string &fileName) {
 	myHrefAttributeName = "";
+	myFileName = fileName;
 	return readDocument(fileName);
 }
@@ -24,7 +24,6 @@
 #include "../../bookmodel/BookReader.h"
 
 class BookModel;
-class Base64EncodedImage;
 
 class FB2BookReader : public FB2Reader {
 
@@ -49,9 +48,11 @@ private:
 	bool myInsidePoem;
 	BookReader myModelReader;
 
-	Base64EncodedImage *myCurrentImage;
+	std::string myFileName;
+	std::string myCurrentImageId;
+	std::string myCurrentImageType;
+	size_t myCurrentImageOffset;
 	bool myProcessingImage;
-	std::vector<std::string> myImageBuffer;
 
 	bool mySectionStarted;
 	bool myInsideTitle;
@@ -25,6 +25,9 @@
 #include "PluckerImages.h"
 #include "DocDecompressor.h"
 
+const std::string ZCompressedFileImage::KIND = "zcompressed";
+const std::string DocCompressedFileImage::KIND = "doccompressed";
+
 const shared_ptr<std::string> ZCompressedFileImage::stringData() const {
 	shared_ptr<ZLInputStream> stream = ZLFile(myPath).inputStream();
 
@@ -54,6 +57,14 @@ const shared_ptr<std::string> ZCompressedFileImage::stringData() const {
 	return imageData;
 }
 
+bool ZCompressedFileImage::fileReference(FileReference &reference) const {
+	reference.Kind = KIND;
+	reference.Path = myPath;
+	reference.Offset = myOffset;
+	reference.Size = myCompressedSize;
+	return true;
+}
+
 const shared_ptr<std::string> DocCompressedFileImage::stringData() const {
 	shared_ptr<ZLInputStream> stream = ZLFile(myPath).inputStream();
 
@@ -70,6 +81,14 @@ const shared_ptr<std::string> DocCompressedFileImage::stringData() const {
 	return imageData;
 }
 
+bool DocCompressedFileImage::fileReference(FileReference &reference) const {
+	reference.Kind = KIND;
+	reference.Path = myPath;
+	reference.Offset = myOffset;
+	reference.Size = myCompressedSize;
+	return true;
+}
+
 shared_ptr<const ZLImage> PluckerMultiImage::subImage(unsigned int row, unsigned int column) const {
 	unsigned int index = row * myColumns + column;
 	if (index >= myIds.size()) {
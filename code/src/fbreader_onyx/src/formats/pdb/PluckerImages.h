@@ -27,9 +27,13 @@
 
 class ZCompressedFileImage : public ZLSingleImage {
 
+public:
+	static const std::string KIND;
+
 public:
 	ZCompressedFileImage(const std::string &mimeType, const std::string &path, size_t offset, size_t size);
 	const shared_ptr<std::string> stringData() const;
+	bool fileReference(FileReference &reference) const;
 
 private:
 	std::string myPath;
@@ -39,9 +43,13 @@ private:
 
 class DocCompressedFileImage : public ZLSingleImage {
 
+public:
+	static const std::string KIND;
+
 public:
 	DocCompressedFileImage(const std::string &mimeType, const std::string &path, size_t offset, size_t compressedSize);
 	const shared_ptr<std::string> stringData() const;
+	bool fileReference(FileReference &reference) const;
 
 private:
 	std::string myPath;
@@ -23,6 +23,8 @@
 
 #include "RtfImage.h"
 
+const std::string RtfImage::KIND = "rtf";
+
 inline static char convertXDigit(char d) {
 	if (isdigit(d)) {
 		return d - '0';
@@ -61,3 +63,11 @@ const shared_ptr<std::string> RtfImage::stringData() const {
 	}
 	return myData;
 }
+
+bool RtfImage::fileReference(FileReference &reference) const {
+	reference.Kind = KIND;
+	reference.Path = myFileName;
+	reference.Offset = myStartOffset;
+	reference.Size = myLength;
+	return true;
+}
@@ -26,10 +26,14 @@
 
 class RtfImage : public ZLSingleImage {
 
+public:
+	static const std::string KIND;
+
 public:
 	RtfImage(const std::string &mimeType, const std::string &fileName, size_t startOffset, size_t length);
 	~RtfImage();
 	const shared_ptr<std::string> stringData() const;
+	bool fileReference(FileReference &reference) const;
 
 private:
 	void read() const;
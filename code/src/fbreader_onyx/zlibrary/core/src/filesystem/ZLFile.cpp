@@ -114,7 +114,7 @@ shared_ptr<ZLInputStream> ZLFile::inputStream() const {
 		    std::string entryName = myPath.substr(index + 1);
 			if (baseFile.myArchiveType & ZIP) {
 			    ZLZipInputStream *zipInputStream = new ZLZipInputStream(base,
-			            entryName);
+			            baseFile.path(), entryName);
 			    if (ZLStringUtil::stringEndsWith(entryName, ".html")
 			            && !ZLStringUtil::stringEndsWith(entryName, "cover.html"))
 			    {
@@ -173,12 +173,17 @@ void ZLFile::fillInfo() const {
 				myInfo = archive.myInfo;
 				myInfo.IsDirectory = false;
 				myInfo.Exists = false;
-				std::vector<std::string> items;
-				dir->collectFiles(items, true);
-				for (std::vector<std::string>::const_iterator it = items.begin(); it != items.end(); ++it) {
-					if (*it == itemName) {
-						myInfo.Exists = true;
-						break;
+				if (!archive.myInfo.IsDirectory && (archive.myArchiveType & ZIP)) {
+					shared_ptr<ZLInputStream> stream = archive.inputStream();
+					myInfo.Exists = ZLZipEntryCache::cache(archive.path(), *stream)->info(itemName).HeaderOffset != -1;
+				} else {
+					std::vector<std::string> items;
+					dir->collectFiles(items, true);
+					for (std::vector<std::string>::const_iterator it = items.begin(); it != items.end(); ++it) {
+						if (*it == itemName) {
+							myInfo.Exists = true;
+							break;
+						}
 					}
 				}
 			} else {
@@ -240,6 +245,13 @@ size_t ZLFile::size() const {
 	return myInfo.Size;
 }
 
+unsigned long ZLFile::mTime() const {
+	if (!myInfoIsFilled) {
+		fillInfo();
+	}
+	return myInfo.MTime;
+}
+
 bool ZLFile::isDirectory() const {
 	if (!myInfoIsFilled) {
 		fillInfo();
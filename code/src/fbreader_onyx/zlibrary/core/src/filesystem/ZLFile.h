@@ -62,6 +62,7 @@ public:
 
 	bool exists() const;
 	size_t size() const;	
+	unsigned long mTime() const;
 
 	void forceArchiveType(ArchiveType type);
 
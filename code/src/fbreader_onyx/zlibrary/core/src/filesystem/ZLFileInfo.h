@@ -24,6 +24,7 @@ struct ZLFileInfo {
 	bool Exists;
 	bool IsDirectory;
 	unsigned long Size;
+	unsigned long MTime;
 };
 
 #endif /* __ZLFILEINFO_H__ */
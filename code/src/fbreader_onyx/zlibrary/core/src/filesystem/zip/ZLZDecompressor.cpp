@@ -52,6 +52,18 @@ ZLZDecompressor::ZLZDecompressor(size_t size) : myAvailableSize(size) {
 	myOutBuffer = new char[OUT_BUFFER_SIZE];
 }
 
+ZLZDecompressor::ZLZDecompressor(const ZLZDecompressor &decompressor) : myAvailableSize(decompressor.myAvailableSize), myBuffer(decompressor.myBuffer), plainBuffer(decompressor.plainBuffer) {
+	myZStream = new z_stream;
+	memset(myZStream, 0, sizeof(z_stream));
+	inflateCopy(myZStream, decompressor.myZStream);
+	// input buffer is always consumed when decompress() returns
+	myZStream->next_in = 0;
+	myZStream->avail_in = 0;
+
+	myInBuffer = new char[IN_BUFFER_SIZE];
+	myOutBuffer = new char[OUT_BUFFER_SIZE];
+}
+
 ZLZDecompressor::~ZLZDecompressor() {
 	delete[] myInBuffer;
 	delete[] myOutBuffer;
@@ -30,6 +30,9 @@ class ZLZDecompressor {
 
 public:
 	ZLZDecompressor(size_t size);
+	// copies inflate state, so that decompression can be continued from
+	// the same position later
+	ZLZDecompressor(const ZLZDecompressor &decompressor);
 	~ZLZDecompressor();
 
 	size_t decompress(ZLInputStream &stream, char *buffer, size_t maxSize,
@@ -49,6 +52,9 @@ private:
 	char *myOutBuffer;
 	std::string myBuffer;
 	std::string plainBuffer;
+
+private:
+	const ZLZDecompressor &operator = (const ZLZDecompressor&);
 };
 
 #endif /* __ZLZDECOMPRESSOR_H__ */
@@ -21,6 +21,8 @@
 #define __ZLZIP_H__
 
 #include <map>
+#include <vector>
+#include <string>
 
 #include <shared_ptr.h>
 
@@ -30,34 +32,56 @@
 class ZLZDecompressor;
 class ZLFile;
 
-class ZLZipEntryCache : public ZLUserData {
+class ZLZipEntryCache {
 
 public:
-	static const ZLZipEntryCache &cache(ZLInputStream &baseStream);
+	static shared_ptr<ZLZipEntryCache> cache(const std::string &fileName, ZLInputStream &baseStream);
 
 public:
 	struct Info {
 		Info();
 
-		int Offset;
+		int HeaderOffset;
 		int CompressionMethod;
 		int CompressedSize;
 		int UncompressedSize;
 	};
 
+	// inflate state at a position of deflated entry, see ZLZipInputStream::seek()
+	struct SeekPoint {
+		size_t Offset;
+		size_t BaseOffset;
+		shared_ptr<ZLZDecompressor> Decompressor;
+	};
+
+private:
+	ZLZipEntryCache(const std::string &fileName, ZLInputStream &baseStream);
+	bool readCentralDirectory(ZLInputStream &baseStream, std::map<std::string,Info> &infoMap);
+	void readLocalHeaders(ZLInputStream &baseStream, std::map<std::string,Info> &infoMap);
+
 public:
-	ZLZipEntryCache(ZLInputStream &baseStream);
 	Info info(const std::string &entryName) const;
 	void collectFileNames(std::vector<std::string> &names) const;
+	// sorted by offset, shared by all streams of the entry
+	std::vector<SeekPoint> &seekPoints(const std::string &entryName);
 
 private:
-	std::map<std::string,Info> myInfoMap;
+	const std::string myFileName;
+	size_t myFileSize;
+	unsigned long myMTime;
+
+	// sorted by name; myIndex is an open addressing hash table of indices
+	std::vector<std::string> myNames;
+	std::vector<Info> myInfos;
+	std::vector<int> myIndex;
+
+	std::map<std::string,std::vector<SeekPoint> > mySeekPoints;
 };
 
 class ZLZipInputStream : public ZLInputStream {
 
 private:
-	ZLZipInputStream(shared_ptr<ZLInputStream> &base, const std::string &entryName);
+	ZLZipInputStream(shared_ptr<ZLInputStream> &base, const std::string &baseName, const std::string &entryName);
 
 public:
 	~ZLZipInputStream();
@@ -71,9 +95,17 @@ public:
 
 	virtual void setAESKey(const std::string &aesKey);
 
+private:
+	bool isIndexed() const;
+	bool restoreSeekPoint(size_t offset);
+	void addSeekPoint();
+	void skip(size_t size);
+
 private:
 	shared_ptr<ZLInputStream> myBaseStream;
+	std::string myBaseName;
 	std::string myEntryName;
+	shared_ptr<ZLZipEntryCache> myEntryCache;
 	bool myIsDeflated;
 
 	size_t myUncompressedSize;
@@ -23,8 +23,7 @@
 
 void ZLZipDir::collectFiles(std::vector<std::string> &names, bool) {
 	shared_ptr<ZLInputStream> stream = ZLFile(path()).inputStream();
-	const ZLZipEntryCache &cache = ZLZipEntryCache::cache(*stream);
-	cache.collectFileNames(names);
+	ZLZipEntryCache::cache(path(), *stream)->collectFileNames(names);
 }
 
 std::string ZLZipDir::delimiter() const {
@@ -17,49 +17,221 @@
  * 02110-1301, USA.
  */
 
+#include <algorithm>
+
 #include "ZLZip.h"
 #include "ZLZipHeader.h"
+#include "../ZLFile.h"
+
+#ifndef ZIP_ENTRY_CACHE_SIZE
+#define ZIP_ENTRY_CACHE_SIZE 5
+#endif
+
+static const unsigned long END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054B50;
+static const unsigned long CENTRAL_DIRECTORY_HEADER_SIGNATURE = 0x02014B50;
+static const size_t END_OF_CENTRAL_DIRECTORY_SIZE = 22;
+static const size_t CENTRAL_DIRECTORY_HEADER_SIZE = 46;
+static const size_t MAX_COMMENT_LENGTH = 0xFFFF;
+
+static shared_ptr<ZLZipEntryCache> ourStoredCaches[ZIP_ENTRY_CACHE_SIZE];
+static int ourStoredCacheIndex = 0;
+
+static unsigned short readShort(const char *data) {
+	return ((((unsigned short)data[1]) & 0xFF) << 8) + ((unsigned short)data[0] & 0xFF);
+}
+
+static unsigned long readLong(const char *data) {
+	return
+		((((unsigned long)data[3]) & 0xFF) << 24) +
+		((((unsigned long)data[2]) & 0xFF) << 16) +
+		((((unsigned long)data[1]) & 0xFF) << 8) +
+		((unsigned long)data[0] & 0xFF);
+}
+
+static size_t nameHash(const std::string &name) {
+	size_t hash = 2166136261U;
+	for (std::string::const_iterator it = name.begin(); it != name.end(); ++it) {
+		hash = (hash ^ (unsigned char)*it) * 16777619U;
+	}
+	return hash;
+}
+
+// reads last tailSize bytes of the stream into tail and returns position
+// of the end of central directory record in it, or -1
+static int findEndOfCentralDirectory(ZLInputStream &stream, size_t fileSize, size_t tailSize, std::string &tail) {
+	tailSize = std::min(tailSize, fileSize);
+	tail.assign(tailSize, '\0');
+	stream.seek(fileSize - tailSize, true);
+	if (stream.read((char*)tail.data(), tailSize) != tailSize) {
+		return -1;
+	}
+	for (int i = tailSize - END_OF_CENTRAL_DIRECTORY_SIZE; i >= 0; --i) {
+		const char *record = tail.data() + i;
+		if ((readLong(record) == END_OF_CENTRAL_DIRECTORY_SIGNATURE) &&
+				(i + END_OF_CENTRAL_DIRECTORY_SIZE + readShort(record + 20) <= tailSize)) {
+			return i;
+		}
+	}
+	return -1;
+}
 
-ZLZipEntryCache::Info::Info() : Offset(-1) {
+ZLZipEntryCache::Info::Info() : HeaderOffset(-1) {
 }
 
-const ZLZipEntryCache &ZLZipEntryCache::cache(ZLInputStream &stream) {
-	static const std::string zipEntryMapKey = "zipEntryMap";
-	shared_ptr<ZLUserData> data = stream.getUserData(zipEntryMapKey);
-	if (!data) {
-          data.reset(new ZLZipEntryCache(stream));
-		stream.addUserData(zipEntryMapKey, data);
+shared_ptr<ZLZipEntryCache> ZLZipEntryCache::cache(const std::string &fileName, ZLInputStream &baseStream) {
+	const ZLFile file(fileName);
+	const size_t fileSize = file.size();
+	const unsigned long mTime = file.mTime();
+
+	for (int i = 0; i < ZIP_ENTRY_CACHE_SIZE; ++i) {
+		shared_ptr<ZLZipEntryCache> stored = ourStoredCaches[i];
+		if (stored && (stored->myFileName == fileName)) {
+			if ((stored->myFileSize == fileSize) && (stored->myMTime == mTime)) {
+				return stored;
+			}
+			ourStoredCaches[i].reset();
+		}
+	}
+
+	shared_ptr<ZLZipEntryCache> cache(new ZLZipEntryCache(fileName, baseStream));
+	cache->myFileSize = fileSize;
+	cache->myMTime = mTime;
+	// archive that could not be read is not remembered
+	if (!cache->myNames.empty()) {
+		ourStoredCaches[ourStoredCacheIndex] = cache;
+		ourStoredCacheIndex = (ourStoredCacheIndex + 1) % ZIP_ENTRY_CACHE_SIZE;
 	}
-	return (const ZLZipEntryCache&)*data;
+	return cache;
 }
 
-ZLZipEntryCache::ZLZipEntryCache(ZLInputStream &baseStream) {
+ZLZipEntryCache::ZLZipEntryCache(const std::string &fileName, ZLInputStream &baseStream) : myFileName(fileName), myFileSize(0), myMTime(0) {
 	if (!baseStream.open()) {
 		return;
 	}
 
+	std::map<std::string,Info> infoMap;
+	if (!readCentralDirectory(baseStream, infoMap)) {
+		infoMap.clear();
+		readLocalHeaders(baseStream, infoMap);
+	}
+	baseStream.close();
+
+	myNames.reserve(infoMap.size());
+	myInfos.reserve(infoMap.size());
+	for (std::map<std::string,Info>::const_iterator it = infoMap.begin(); it != infoMap.end(); ++it) {
+		myNames.push_back(it->first);
+		myInfos.push_back(it->second);
+	}
+
+	size_t indexSize = 16;
+	while (indexSize < 2 * myNames.size()) {
+		indexSize <<= 1;
+	}
+	myIndex.assign(indexSize, -1);
+	for (size_t i = 0; i < myNames.size(); ++i) {
+		size_t position = nameHash(myNames[i]) & (indexSize - 1);
+		while (myIndex[position] != -1) {
+			position = (position + 1) & (indexSize - 1);
+		}
+		myIndex[position] = i;
+	}
+}
+
+bool ZLZipEntryCache::readCentralDirectory(ZLInputStream &baseStream, std::map<std::string,Info> &infoMap) {
+	const size_t fileSize = baseStream.sizeOfOpened();
+	if (fileSize < END_OF_CENTRAL_DIRECTORY_SIZE) {
+		return false;
+	}
+
+	// the record is the last one in the file unless the archive has a comment
+	std::string tail;
+	int recordIndex = findEndOfCentralDirectory(baseStream, fileSize, END_OF_CENTRAL_DIRECTORY_SIZE, tail);
+	if ((recordIndex == -1) && (fileSize > END_OF_CENTRAL_DIRECTORY_SIZE)) {
+		recordIndex = findEndOfCentralDirectory(baseStream, fileSize, END_OF_CENTRAL_DIRECTORY_SIZE + MAX_COMMENT_LENGTH, tail);
+	}
+	if (recordIndex == -1) {
+		return false;
+	}
+
+	const char *record = tail.data() + recordIndex;
+	const size_t recordOffset = fileSize - tail.length() + recordIndex;
+	const unsigned short diskNumber = readShort(record + 4);
+	const unsigned short directoryDiskNumber = readShort(record + 6);
+	const size_t directorySize = readLong(record + 12);
+	const size_t directoryOffset = readLong(record + 16);
+	// multi-volume and zip64 archives are left to the linear scan
+	if ((diskNumber != 0) || (directoryDiskNumber != 0) ||
+			(directorySize > recordOffset) || (directoryOffset > recordOffset - directorySize)) {
+		return false;
+	}
+	// non-zero if some data (e.g. self-extractor) is prepended to the archive
+	const size_t shift = recordOffset - directorySize - directoryOffset;
+
+	std::string directory(directorySize, '\0');
+	baseStream.seek(recordOffset - directorySize, true);
+	if (baseStream.read((char*)directory.data(), directorySize) != directorySize) {
+		return false;
+	}
+
+	const char *ptr = directory.data();
+	const char *end = ptr + directorySize;
+	while (ptr != end) {
+		if (((size_t)(end - ptr) < CENTRAL_DIRECTORY_HEADER_SIZE) ||
+				(readLong(ptr) != CENTRAL_DIRECTORY_HEADER_SIGNATURE)) {
+			return false;
+		}
+		const unsigned short nameLength = readShort(ptr + 28);
+		const size_t recordSize = CENTRAL_DIRECTORY_HEADER_SIZE + nameLength + readShort(ptr + 30) + readShort(ptr + 32);
+		if ((size_t)(end - ptr) < recordSize) {
+			return false;
+		}
+		if (nameLength != 0) {
+			Info &info = infoMap[std::string(ptr + CENTRAL_DIRECTORY_HEADER_SIZE, nameLength)];
+			info.HeaderOffset = readLong(ptr + 42) + shift;
+			info.CompressionMethod = readShort(ptr + 10);
+			info.CompressedSize = readLong(ptr + 20);
+			info.UncompressedSize = readLong(ptr + 24);
+		}
+		ptr += recordSize;
+	}
+	return true;
+}
+
+void ZLZipEntryCache::readLocalHeaders(ZLInputStream &baseStream, std::map<std::string,Info> &infoMap) {
+	baseStream.seek(0, true);
 	ZLZipHeader header;
+	size_t headerOffset = baseStream.offset();
 	while (header.readFrom(baseStream)) {
 		std::string entryName(header.NameLength, '\0');
 		if ((unsigned int)baseStream.read((char*)entryName.data(), header.NameLength) == header.NameLength) {
-			Info &info = myInfoMap[entryName];
-			info.Offset = baseStream.offset() + header.ExtraLength;
+			Info &info = infoMap[entryName];
+			info.HeaderOffset = headerOffset;
 			info.CompressionMethod = header.CompressionMethod;
 			info.CompressedSize = header.CompressedSize;
 			info.UncompressedSize = header.UncompressedSize;
 		}
 		ZLZipHeader::skipEntry(baseStream, header);
+		headerOffset = baseStream.offset();
 	}
-	baseStream.close();
 }
 
 ZLZipEntryCache::Info ZLZipEntryCache::info(const std::string &entryName) const {
-	std::map<std::string,Info>::const_iterator it = myInfoMap.find(entryName);
-	return (it != myInfoMap.end()) ? it->second : Info();
+	if (myIndex.empty()) {
+		return Info();
+	}
+	const size_t mask = myIndex.size() - 1;
+	for (size_t position = nameHash(entryName) & mask; myIndex[position] != -1; position = (position + 1) & mask) {
+		if (myNames[myIndex[position]] == entryName) {
+			return myInfos[myIndex[position]];
+		}
+	}
+	return Info();
 }
 
 void ZLZipEntryCache::collectFileNames(std::vector<std::string> &names) const {
-	for (std::map<std::string,Info>::const_iterator it = myInfoMap.begin(); it != myInfoMap.end(); ++it) {
-		names.push_back(it->first);
-	}
+	names.insert(names.end(), myNames.begin(), myNames.end());
+}
+
+std::vector<ZLZipEntryCache::SeekPoint> &ZLZipEntryCache::seekPoints(const std::string &entryName) {
+	return mySeekPoints[entryName];
 }
@@ -24,9 +24,24 @@
 #include "ZLZDecompressor.h"
 #include "../ZLFSManager.h"
 
+// distance between inflate state snapshots kept for large deflated entries,
+// so that seeking back doesn't decompress the entry from its start
+#ifndef ZIP_SEEK_INDEX_SPAN
+#define ZIP_SEEK_INDEX_SPAN 0x100000
+#endif
+
+// minimal unpacked size of entry to keep snapshots for
+#ifndef ZIP_SEEK_INDEX_MIN_SIZE
+#define ZIP_SEEK_INDEX_MIN_SIZE 0x200000
+#endif
+
+// skipped data is decompressed by parts of this size
+static const size_t SKIP_SIZE = 0x8000;
+
 ZLZipInputStream::ZLZipInputStream(shared_ptr<ZLInputStream> &base,
-        const std::string &entryName)
+        const std::string &baseName, const std::string &entryName)
     : myBaseStream(new ZLInputStreamDecorator(base))
+    , myBaseName(baseName)
     , myEntryName(entryName)
     , myUncompressedSize(0)
 {
@@ -39,18 +54,24 @@ ZLZipInputStream::~ZLZipInputStream() {
 bool ZLZipInputStream::open() {
 	close();
 
-	const ZLZipEntryCache &cache = ZLZipEntryCache::cache(*myBaseStream);
-	ZLZipEntryCache::Info info = cache.info(myEntryName);
+	myEntryCache = ZLZipEntryCache::cache(myBaseName, *myBaseStream);
+	ZLZipEntryCache::Info info = myEntryCache->info(myEntryName);
 
 	if (!myBaseStream->open()) {
 		return false;
 	}
 
-	if (info.Offset == -1) {
+	if (info.HeaderOffset == -1) {
+		close();
+		return false;
+	}
+	myBaseStream->seek(info.HeaderOffset, true);
+	ZLZipHeader header;
+	if (!header.readFrom(*myBaseStream)) {
 		close();
 		return false;
 	}
-	myBaseStream->seek(info.Offset, true);
+	myBaseStream->seek(header.NameLength + header.ExtraLength, false);
 
 	if (info.CompressionMethod == 0) {
 		myIsDeflated = false;
@@ -96,16 +117,79 @@ void ZLZipInputStream::close() {
 }
 
 void ZLZipInputStream::seek(int offset, bool absoluteOffset) {
-	if (absoluteOffset) {
-		offset -= this->offset();
-	}
-	if (offset > 0) {
-		read(0, offset);
-	} else if (offset < 0) {
+	if (!absoluteOffset) {
 		offset += this->offset();
+	}
+	if (offset < 0) {
 		open();
-		if (offset >= 0) {
-			read(0, offset);
+		return;
+	}
+	if (!restoreSeekPoint(offset) && ((size_t)offset < myOffset)) {
+		open();
+	}
+	skip(offset - myOffset);
+}
+
+bool ZLZipInputStream::isIndexed() const {
+	return
+		(ZIP_SEEK_INDEX_SPAN > 0) && myIsDeflated && myDecompressor &&
+		(myUncompressedSize >= ZIP_SEEK_INDEX_MIN_SIZE) && getAESKey().empty();
+}
+
+static bool isBefore(size_t offset, const ZLZipEntryCache::SeekPoint &point) {
+	return offset < point.Offset;
+}
+
+// continues decompression from the last snapshot before offset, if it is
+// closer to offset than current position
+bool ZLZipInputStream::restoreSeekPoint(size_t offset) {
+	if (!isIndexed()) {
+		return false;
+	}
+	const std::vector<ZLZipEntryCache::SeekPoint> &points = myEntryCache->seekPoints(myEntryName);
+	std::vector<ZLZipEntryCache::SeekPoint>::const_iterator it = std::upper_bound(points.begin(), points.end(), offset, isBefore);
+	if (it == points.begin()) {
+		return false;
+	}
+	--it;
+	if ((it->Offset <= myOffset) && (myOffset <= offset)) {
+		return false;
+	}
+	myDecompressor.reset(new ZLZDecompressor(*it->Decompressor));
+	myBaseStream->seek(it->BaseOffset, true);
+	myOffset = it->Offset;
+	return true;
+}
+
+void ZLZipInputStream::addSeekPoint() {
+	std::vector<ZLZipEntryCache::SeekPoint> &points = myEntryCache->seekPoints(myEntryName);
+	std::vector<ZLZipEntryCache::SeekPoint>::iterator it = std::upper_bound(points.begin(), points.end(), myOffset, isBefore);
+	if ((it != points.begin()) && ((it - 1)->Offset == myOffset)) {
+		return;
+	}
+	ZLZipEntryCache::SeekPoint point;
+	point.Offset = myOffset;
+	point.BaseOffset = myBaseStream->offset();
+	point.Decompressor.reset(new ZLZDecompressor(*myDecompressor));
+	points.insert(it, point);
+}
+
+// snapshots are taken while skipping, so they are kept only for entries
+// which are read with seeks, and only for the parts that were skipped
+void ZLZipInputStream::skip(size_t size) {
+	const bool indexed = isIndexed();
+	while (size > 0) {
+		size_t length = myIsDeflated ? std::min(size, SKIP_SIZE) : size;
+		if (indexed) {
+			length = std::min(length, ZIP_SEEK_INDEX_SPAN - myOffset % ZIP_SEEK_INDEX_SPAN);
+		}
+		const size_t skipped = read(0, length);
+		if (skipped == 0) {
+			break;
+		}
+		size -= skipped;
+		if (indexed && (myOffset % ZIP_SEEK_INDEX_SPAN == 0)) {
+			addSeekPoint();
 		}
 	}
 }
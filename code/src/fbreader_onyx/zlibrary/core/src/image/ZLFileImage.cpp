@@ -21,6 +21,16 @@
 
 #include "ZLFileImage.h"
 
+const std::string ZLFileImage::KIND = "file";
+
 shared_ptr<ZLInputStream> ZLFileImage::inputStream() const {
 	return ZLFile(myPath).inputStream();
 }
+
+bool ZLFileImage::fileReference(FileReference &reference) const {
+	reference.Kind = KIND;
+	reference.Path = myPath;
+	reference.Offset = offset();
+	reference.Size = size();
+	return true;
+}
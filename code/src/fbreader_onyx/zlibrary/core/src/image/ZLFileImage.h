@@ -24,8 +24,12 @@
 
 class ZLFileImage : public ZLStreamImage {
 
+public:
+	static const std::string KIND;
+
 public:
 	ZLFileImage(const std::string &mimeType, const std::string &path, size_t offset, size_t size = 0);
+	bool fileReference(FileReference &reference) const;
 
 protected:
 	shared_ptr<ZLInputStream> inputStream() const;
@@ -40,11 +40,24 @@ protected:
 	ZLSingleImage(const std::string &mimeType);
 	virtual ~ZLSingleImage();
 
+public:
+	// Part of a file image data are read from; Kind tells how they are
+	// stored there.
+	struct FileReference {
+		std::string Kind;
+		std::string Path;
+		size_t Offset;
+		size_t Size;
+	};
+
 public:
 	bool isSingle() const { return true; }
 	const std::string &mimeType() const;
 	virtual const shared_ptr<std::string> stringData() const = 0;
-	
+	// Images reading their data from a file on demand return where it is,
+	// so the reference can be kept instead of the data.
+	virtual bool fileReference(FileReference &reference) const;
+
 private:
 	std::string myMimeType;
 };
@@ -68,6 +81,7 @@ inline ZLImage::~ZLImage() {}
 inline ZLSingleImage::ZLSingleImage(const std::string &mimeType) : myMimeType(mimeType) {}
 inline ZLSingleImage::~ZLSingleImage() {}
 inline const std::string &ZLSingleImage::mimeType() const { return myMimeType; }
+inline bool ZLSingleImage::fileReference(FileReference&) const { return false; }
 
 inline ZLMultiImage::ZLMultiImage() : ZLImage() {}
 inline ZLMultiImage::~ZLMultiImage() {}
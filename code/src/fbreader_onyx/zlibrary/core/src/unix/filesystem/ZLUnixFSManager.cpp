@@ -49,6 +49,7 @@ ZLFileInfo ZLUnixFSManager::fileInfo(const std::string &path) const {
 	info.Exists = stat(path.c_str(), &fileStat) == 0;
     if (info.Exists) {
 		info.Size = fileStat.st_size;
+		info.MTime = fileStat.st_mtime;
 #ifndef _WINDOWS
 		info.IsDirectory = S_ISDIR(fileStat.st_mode);
 #endif
@@ -0,0 +1,361 @@
+// generated by generateUnicodeTables.py from data/unicode.xml.gz, do not edit
+
+static const ZLUnicodeUtil::Ucs4Char UNICODE_TABLE_LIMIT = 0x1D800;
+static const int UNICODE_BLOCK_BITS = 8;
+
+static const ZLUnicodeData UNICODE_PROPERTIES[98] = {
+	{ ZLUnicodeData::UNKNOWN, 0, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 32, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -32 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 743 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 121 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 1, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -1 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -199, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -232 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -121, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -300 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 210, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 206, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 205, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 79, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 202, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 203, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 207, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 97 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 211, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 209, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 163 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 213, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 130 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 214, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 218, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 217, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 219, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 56 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 2, 1 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -79 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -97, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -56, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -130, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 0, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -163, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 83, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -210 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -206 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -205 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -202 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -203 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -207 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -209 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -211 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -213 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -214 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -218 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -217 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -219 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -83 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 38, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 37, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 64, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 63, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -38 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -37 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -31 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -64 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -63 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -62 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -57 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -47 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -54 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -86 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -80 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 7 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -60, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -96 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -7, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 80, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 48, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -48 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 7264, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -59 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 8 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -8, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 74 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 86 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 100 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 128 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 112 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 126 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, 9 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -74, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -7205 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -86, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -100, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -112, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -128, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -126, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -7517, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -8383, 0 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, -8262, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -7264 },
+	{ ZLUnicodeData::LETTER_UPPERCASE, 40, 0 },
+	{ ZLUnicodeData::LETTER_LOWERCASE, 0, -40 },
+};
+
+static const unsigned char UNICODE_BLOCK_INDEX[472] = {
+	0, 1, 2, 3, 4, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	7, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 8, 9, 10,
+	11, 12, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 13, 14, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 15, 6, 6, 6, 16,
+	6, 6, 6, 6, 17, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	6, 6, 6, 6, 18, 19, 20, 21,
+};
+
+static const unsigned char UNICODE_BLOCKS[22][256] = {
+	{
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,
+		0,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,3,0,0,0,0,0,0,0,0,0,0,4,0,0,0,0,3,0,0,0,0,0,
+		1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,1,1,1,1,1,1,1,3,
+		2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,0,2,2,2,2,2,2,2,5,
+	},
+	{
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,8,9,6,7,6,7,6,7,3,6,7,6,7,6,7,6,
+		7,6,7,6,7,6,7,6,7,3,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,10,6,7,6,7,6,7,11,
+		3,12,6,7,6,7,13,6,7,14,14,6,7,3,15,16,17,6,7,14,18,19,20,21,6,7,22,3,20,23,24,25,
+		6,7,6,7,6,7,26,6,7,26,3,3,6,7,26,6,7,27,27,6,7,6,7,28,6,7,3,0,6,7,3,29,
+		0,0,0,0,30,0,7,30,0,7,30,0,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,31,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,3,30,0,7,6,7,32,33,6,7,6,7,6,7,6,7,
+	},
+	{
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		34,3,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,3,3,3,3,3,3,35,6,7,36,35,3,
+		3,37,0,0,0,0,0,0,0,0,0,0,0,0,0,0,3,3,3,38,39,3,40,40,3,41,3,42,3,3,3,3,
+		40,3,3,43,3,3,3,3,44,45,3,3,3,3,3,45,3,3,46,3,3,47,3,3,3,3,3,3,3,3,3,3,
+		48,3,3,48,3,3,3,3,48,3,49,49,3,3,3,3,3,3,50,3,51,3,3,3,3,3,3,3,3,3,3,3,
+		3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,52,0,53,53,53,0,54,0,55,55,3,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+		1,1,0,1,1,1,1,1,1,1,1,1,56,57,57,57,3,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+		2,2,58,2,2,2,2,2,2,2,2,2,59,60,60,0,61,62,35,35,35,63,64,3,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,65,66,67,3,68,69,0,6,7,70,6,7,3,35,35,35,
+	},
+	{
+		71,71,71,71,71,71,71,71,71,71,71,71,71,71,71,71,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+		1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+		2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,0,0,0,0,0,0,0,0,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		35,6,7,6,7,6,7,6,7,6,7,6,7,6,7,0,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,0,0,0,0,0,0,
+	},
+	{
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,
+		72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,0,0,0,0,0,0,0,0,0,
+		0,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,
+		73,73,73,73,73,73,73,3,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,74,
+		74,74,74,74,74,74,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
+		3,3,3,3,3,3,3,3,3,3,3,3,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,0,3,3,3,3,3,3,3,
+		3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,3,3,3,3,3,75,0,0,0,0,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,0,0,0,0,0,0,
+	},
+	{
+		76,76,76,76,76,76,76,76,77,77,77,77,77,77,77,77,76,76,76,76,76,76,0,0,77,77,77,77,77,77,0,0,
+		76,76,76,76,76,76,76,76,77,77,77,77,77,77,77,77,76,76,76,76,76,76,76,76,77,77,77,77,77,77,77,77,
+		76,76,76,76,76,76,0,0,77,77,77,77,77,77,0,0,3,76,3,76,3,76,3,76,0,77,0,77,0,77,0,77,
+		76,76,76,76,76,76,76,76,77,77,77,77,77,77,77,77,78,78,79,79,79,79,80,80,81,81,82,82,83,83,0,0,
+		76,76,76,76,76,76,76,76,0,0,0,0,0,0,0,0,76,76,76,76,76,76,76,76,0,0,0,0,0,0,0,0,
+		76,76,76,76,76,76,76,76,0,0,0,0,0,0,0,0,76,76,3,84,3,0,3,3,77,77,85,85,0,0,86,0,
+		0,0,3,84,3,0,3,3,87,87,87,87,0,0,0,0,76,76,3,3,0,0,3,3,77,77,88,88,0,0,0,0,
+		76,76,3,3,3,67,3,3,77,77,89,89,70,0,0,0,0,0,3,84,3,0,3,3,90,90,91,91,0,0,0,0,
+	},
+	{
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,3,0,0,0,0,0,0,0,0,0,0,0,0,0,3,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		0,0,35,0,0,0,0,35,0,0,3,35,35,35,3,3,35,35,35,3,0,35,0,0,0,35,35,35,35,35,0,0,
+		0,0,0,0,35,0,92,0,35,0,93,94,35,35,0,3,35,35,0,35,3,0,0,0,0,3,0,0,3,3,35,35,
+		0,0,0,0,0,35,3,3,3,3,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,
+		72,72,72,72,72,72,72,72,72,72,72,72,72,72,72,0,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,
+		73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,73,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,6,7,
+		6,7,6,7,3,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,95,
+		95,95,95,95,95,95,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		3,3,3,3,3,3,3,0,0,0,0,0,0,0,0,0,0,0,0,3,3,3,3,3,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,
+		0,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,96,
+		96,96,96,96,96,96,96,96,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,
+		97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,97,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+	{
+		35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,3,3,3,3,3,3,
+		3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,35,35,35,35,35,35,35,35,35,35,35,35,
+		35,35,35,35,35,35,35,35,35,35,35,35,35,35,3,3,3,3,3,3,3,0,3,3,3,3,3,3,3,3,3,3,
+		3,3,3,3,3,3,3,3,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,
+		35,35,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,35,0,35,35,
+		0,0,35,0,0,35,35,0,0,35,35,35,35,0,35,35,35,35,35,35,35,35,3,3,3,3,0,3,0,3,3,3,
+		3,3,3,3,0,3,3,3,3,3,3,3,3,3,3,3,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,
+		35,35,35,35,35,35,35,35,35,35,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
+	},
+	{
+		3,3,3,3,35,35,0,35,35,35,35,0,0,35,35,35,35,35,35,35,35,0,35,35,35,35,35,35,35,0,3,3,
+		3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,35,35,0,35,35,35,35,0,
+		35,35,35,35,35,0,35,0,0,0,35,35,35,35,35,35,35,0,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
+		3,3,3,3,3,3,3,3,3,3,3,3,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,
+		35,35,35,35,35,35,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
+		35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,3,3,3,3,3,3,
+		3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,35,35,35,35,35,35,35,35,35,35,35,35,
+		35,35,35,35,35,35,35,35,35,35,35,35,35,35,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
+	},
+	{
+		3,3,3,3,3,3,3,3,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,
+		35,35,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,35,35,35,35,
+		35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,3,3,3,3,3,3,3,3,3,3,
+		3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,
+		35,35,35,35,35,35,35,35,35,35,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
+		3,3,3,3,3,3,0,0,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,
+		35,0,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,0,3,3,3,3,
+		3,3,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,0,3,3,3,3,
+	},
+	{
+		3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,0,3,3,3,3,3,3,35,35,35,35,
+		35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,0,3,3,3,3,3,3,3,3,3,3,
+		3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,0,3,3,3,3,3,3,35,35,35,35,35,35,35,35,35,35,
+		35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,0,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
+		3,3,3,3,3,3,3,3,3,0,3,3,3,3,3,3,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,35,
+		35,35,35,35,35,35,35,35,35,0,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
+		3,3,3,0,3,3,3,3,3,3,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	},
+};
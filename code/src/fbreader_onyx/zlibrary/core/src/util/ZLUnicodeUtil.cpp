@@ -17,11 +17,7 @@
  * 02110-1301, USA.
  */
 
-#include <stdlib.h>
-#include <map>
-
-#include <ZLibrary.h>
-#include <ZLXMLReader.h>
+#include <string.h>
 
 #include "ZLUnicodeUtil.h"
 
@@ -32,55 +28,29 @@ struct ZLUnicodeData {
 		UNKNOWN
 	};
 
-	const SymbolType Type;
-	const ZLUnicodeUtil::Ucs4Char LowerCase;
-	const ZLUnicodeUtil::Ucs4Char UpperCase;
-
-	ZLUnicodeData(const SymbolType type, ZLUnicodeUtil::Ucs4Char lowerCase, ZLUnicodeUtil::Ucs4Char upperCase);
+	SymbolType Type;
+	int LowerCaseDelta;
+	int UpperCaseDelta;
 };
 
-ZLUnicodeData::ZLUnicodeData(const SymbolType type, ZLUnicodeUtil::Ucs4Char lowerCase, ZLUnicodeUtil::Ucs4Char upperCase) : Type(type), LowerCase(lowerCase), UpperCase(upperCase) {
-}
-
-static std::map<ZLUnicodeUtil::Ucs4Char,ZLUnicodeData> UNICODE_TABLE;
-
-class ZLUnicodeTableReader : public ZLXMLReader {
-
-private:
-	void startElementHandler(const char *tag, const char **attributes);
-};
+#include "ZLUnicodeTables.h"
 
-void ZLUnicodeTableReader::startElementHandler(const char *tag, const char **attributes) {
-	static std::string SYMBOL_TAG = "symbol";
-	static std::string LETTER_LOWERCASE_TYPE = "Ll";
-	static std::string LETTER_UPPERCASE_TYPE = "Lu";
-
-	if (SYMBOL_TAG == tag) {
-		const char *codeS = attributeValue(attributes, "code");
-		const ZLUnicodeUtil::Ucs4Char code = strtol(codeS, 0, 16);
-		const char *typeS = attributeValue(attributes, "type");
-		ZLUnicodeData::SymbolType type = ZLUnicodeData::UNKNOWN;
-		if (LETTER_LOWERCASE_TYPE == typeS) {
-			type = ZLUnicodeData::LETTER_LOWERCASE;
-		} else if (LETTER_UPPERCASE_TYPE == typeS) {
-			type = ZLUnicodeData::LETTER_UPPERCASE;
-		}
-		const char *lowerS = attributeValue(attributes, "lower");
-		const ZLUnicodeUtil::Ucs4Char lower = (lowerS != 0) ? strtol(lowerS, 0, 16) : code;
-		const char *upperS = attributeValue(attributes, "upper");
-		const ZLUnicodeUtil::Ucs4Char upper = (upperS != 0) ? strtol(upperS, 0, 16) : code;
-		UNICODE_TABLE.insert(std::pair<ZLUnicodeUtil::Ucs4Char,ZLUnicodeData>(code, ZLUnicodeData(type, lower, upper)));
+static inline const ZLUnicodeData &unicodeData(ZLUnicodeUtil::Ucs4Char ch) {
+	if (ch >= UNICODE_TABLE_LIMIT) {
+		return UNICODE_PROPERTIES[0];
 	}
+	const unsigned char *block = UNICODE_BLOCKS[UNICODE_BLOCK_INDEX[ch >> UNICODE_BLOCK_BITS]];
+	return UNICODE_PROPERTIES[block[ch & ((1 << UNICODE_BLOCK_BITS) - 1)]];
 }
 
-static void initUnicodeTable() {
-	static bool inProgress = false;
-	if (!inProgress && UNICODE_TABLE.empty()) {
-		inProgress = true;
-		ZLUnicodeTableReader reader;
-		reader.readDocument(ZLibrary::ZLibraryDirectory() + ZLibrary::FileNameDelimiter + "unicode.xml.gz");
-		inProgress = false;
-	}
+// word-at-a-time helpers for ASCII runs
+static const unsigned long ONES = ~0UL / 0xFF;
+static const unsigned long HIGH_BITS = ONES * 0x80;
+
+static inline unsigned long loadWord(const char *ptr) {
+	unsigned long word;
+	memcpy(&word, ptr, sizeof(word));
+	return word;
 }
 
 bool ZLUnicodeUtil::isUtf8String(const char *str, int len) {
@@ -117,16 +87,22 @@ int ZLUnicodeUtil::utf8Length(const char *str, int len) {
 	const char *last = str + len;
 	int counter = 0;
 	while (str < last) {
-		if ((*str & 0x80) == 0) {
+		if ((last - str >= (int)sizeof(unsigned long)) && ((loadWord(str) & HIGH_BITS) == 0)) {
+			str += sizeof(unsigned long);
+			counter += sizeof(unsigned long);
+		} else if ((*str & 0x80) == 0) {
 			++str;
-		} else if ((*str & 0x20) == 0) {
-			str += 2;
-		} else if ((*str & 0x10) == 0) {
-			str += 3;
+			++counter;
 		} else {
-			str += 4;
+			if ((*str & 0x20) == 0) {
+				str += 2;
+			} else if ((*str & 0x10) == 0) {
+				str += 3;
+			} else {
+				str += 4;
+			}
+			++counter;
 		}
-		++counter;
 	}
 	return counter;
 }
@@ -309,18 +285,7 @@ void ZLUnicodeUtil::ucs2ToUtf8(std::string &to, const Ucs2String &from, int toLe
 }
 
 bool ZLUnicodeUtil::isLetter(Ucs4Char ch) {
-	initUnicodeTable();
-	std::map<ZLUnicodeUtil::Ucs4Char,ZLUnicodeData>::const_iterator it = UNICODE_TABLE.find(ch);
-	if (it == UNICODE_TABLE.end()) {
-		return false;
-	}
-	switch (it->second.Type) {
-		case ZLUnicodeData::LETTER_LOWERCASE:
-		case ZLUnicodeData::LETTER_UPPERCASE:
-			return true;
-		default:
-			return false;
-	}
+	return unicodeData(ch).Type != ZLUnicodeData::UNKNOWN;
 }
 
 bool ZLUnicodeUtil::isSpace(Ucs4Char ch) {
@@ -394,9 +359,7 @@ ZLUnicodeUtil::Breakable ZLUnicodeUtil::isBreakable(Ucs4Char c) {
 }
 
 ZLUnicodeUtil::Ucs4Char ZLUnicodeUtil::toLower(Ucs4Char ch) {
-	initUnicodeTable();
-	std::map<ZLUnicodeUtil::Ucs4Char,ZLUnicodeData>::const_iterator it = UNICODE_TABLE.find(ch);
-	return (it != UNICODE_TABLE.end()) ? it->second.LowerCase : ch;
+	return ch + unicodeData(ch).LowerCaseDelta;
 }
 
 void ZLUnicodeUtil::toLower(Ucs4String &str) {
@@ -406,20 +369,48 @@ void ZLUnicodeUtil::toLower(Ucs4String &str) {
 }
 
 std::string ZLUnicodeUtil::toLower(const std::string &utf8String) {
+	std::string result(utf8String);
+	const size_t length = result.length();
+	char *data = (char*)result.data();
+
+	// ASCII part is converted in place, a word at a time
+	size_t index = 0;
+	for (; index + sizeof(unsigned long) <= length; index += sizeof(unsigned long)) {
+		const unsigned long word = loadWord(data + index);
+		if ((word & HIGH_BITS) != 0) {
+			break;
+		}
+		const unsigned long aboveZ = word + ONES * (0x7F - 'Z');
+		const unsigned long fromA = word + ONES * (0x80 - 'A');
+		const unsigned long upper = fromA & ~aboveZ & HIGH_BITS;
+		const unsigned long lower = word | (upper >> 2);
+		memcpy(data + index, &lower, sizeof(lower));
+	}
+	for (; index < length; ++index) {
+		if ((data[index] & 0x80) != 0) {
+			break;
+		}
+		if ((data[index] >= 'A') && (data[index] <= 'Z')) {
+			data[index] += 'a' - 'A';
+		}
+	}
+	if (index == length) {
+		return result;
+	}
+
 	Ucs4String ucs4String;
-	utf8ToUcs4(ucs4String, utf8String);
+	utf8ToUcs4(ucs4String, utf8String.data() + index, length - index);
 
 	toLower(ucs4String);
 
-	std::string result;
-	ucs4ToUtf8(result, ucs4String, utf8String.length());
+	std::string tail;
+	ucs4ToUtf8(tail, ucs4String, length - index);
+	result.replace(index, std::string::npos, tail);
 	return result;
 }
 
 ZLUnicodeUtil::Ucs4Char ZLUnicodeUtil::toUpper(Ucs4Char ch) {
-	initUnicodeTable();
-	std::map<ZLUnicodeUtil::Ucs4Char,ZLUnicodeData>::const_iterator it = UNICODE_TABLE.find(ch);
-	return (it != UNICODE_TABLE.end()) ? it->second.UpperCase : ch;
+	return ch + unicodeData(ch).UpperCaseDelta;
 }
 
 void ZLUnicodeUtil::toUpper(Ucs4String &str) {
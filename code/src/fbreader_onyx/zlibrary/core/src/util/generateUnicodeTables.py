@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+
+# Generates ZLUnicodeTables.h from data/unicode.xml.gz.
+# Usage: python3 generateUnicodeTables.py [../../data/unicode.xml.gz] [ZLUnicodeTables.h]
+#
+# Each symbol gets an index into UNICODE_PROPERTIES (type and case deltas);
+# indices are stored in 256-symbol blocks, equal blocks are stored once and
+# UNICODE_BLOCK_INDEX maps (code >> 8) to a block.
+
+import gzip
+import os
+import re
+import sys
+
+BLOCK_BITS = 8
+BLOCK_SIZE = 1 << BLOCK_BITS
+
+TYPES = { 'Ll': 'LETTER_LOWERCASE', 'Lu': 'LETTER_UPPERCASE' }
+
+def main():
+	here = os.path.dirname(os.path.abspath(__file__))
+	source = sys.argv[1] if len(sys.argv) > 1 else os.path.join(here, '..', '..', 'data', 'unicode.xml.gz')
+	target = sys.argv[2] if len(sys.argv) > 2 else os.path.join(here, 'ZLUnicodeTables.h')
+
+	symbols = {}
+	with gzip.open(source, 'rt') as xml:
+		for line in xml:
+			if '<symbol ' not in line:
+				continue
+			attributes = dict(re.findall(r'(\w+)="([^"]*)"', line))
+			code = int(attributes['code'], 16)
+			symbols[code] = (
+				TYPES.get(attributes.get('type'), 'UNKNOWN'),
+				int(attributes.get('lower', attributes['code']), 16) - code,
+				int(attributes.get('upper', attributes['code']), 16) - code
+			)
+
+	properties = [('UNKNOWN', 0, 0)]
+	propertyIndex = { properties[0]: 0 }
+	for code in sorted(symbols):
+		if symbols[code] not in propertyIndex:
+			propertyIndex[symbols[code]] = len(properties)
+			properties.append(symbols[code])
+	assert len(properties) <= 256
+
+	limit = (max(symbols) // BLOCK_SIZE + 1) * BLOCK_SIZE
+	blocks = []
+	blockIndex = {}
+	blockNumbers = []
+	for start in range(0, limit, BLOCK_SIZE):
+		block = tuple(propertyIndex[symbols.get(code, properties[0])] for code in range(start, start + BLOCK_SIZE))
+		if block not in blockIndex:
+			blockIndex[block] = len(blocks)
+			blocks.append(block)
+		blockNumbers.append(blockIndex[block])
+
+	assert len(blocks) <= 256
+
+	out = []
+	out.append('// generated by generateUnicodeTables.py from data/unicode.xml.gz, do not edit')
+	out.append('')
+	out.append('static const ZLUnicodeUtil::Ucs4Char UNICODE_TABLE_LIMIT = 0x%X;' % limit)
+	out.append('static const int UNICODE_BLOCK_BITS = %d;' % BLOCK_BITS)
+	out.append('')
+	out.append('static const ZLUnicodeData UNICODE_PROPERTIES[%d] = {' % len(properties))
+	for type, lower, upper in properties:
+		out.append('\t{ ZLUnicodeData::%s, %d, %d },' % (type, lower, upper))
+	out.append('};')
+	out.append('')
+	out.append('static const unsigned char UNICODE_BLOCK_INDEX[%d] = {' % len(blockNumbers))
+	for i in range(0, len(blockNumbers), 16):
+		out.append('\t' + ' '.join('%d,' % n for n in blockNumbers[i:i + 16]))
+	out.append('};')
+	out.append('')
+	out.append('static const unsigned char UNICODE_BLOCKS[%d][%d] = {' % (len(blocks), BLOCK_SIZE))
+	for block in blocks:
+		out.append('\t{')
+		for i in range(0, BLOCK_SIZE, 32):
+			out.append('\t\t' + ','.join('%d' % n for n in block[i:i + 32]) + ',')
+		out.append('\t},')
+	out.append('};')
+
+	with open(target, 'w') as header:
+		header.write('\n'.join(out) + '\n')
+
+if __name__ == '__main__':
+	main()
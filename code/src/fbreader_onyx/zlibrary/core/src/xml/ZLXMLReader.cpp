@@ -120,6 +120,14 @@ bool ZLXMLReader::readFromBuffer(const char *data, int len) {
 	return myInternalReader->parseBuffer(data, len);
 }
 
+size_t ZLXMLReader::currentByteOffset() const {
+	return myInternalReader->currentByteOffset();
+}
+
+size_t ZLXMLReader::currentByteCount() const {
+	return myInternalReader->currentByteCount();
+}
+
 bool ZLXMLReader::processNamespaces() const {
 	return false;
 }
@@ -59,6 +59,11 @@ protected:
 
 	bool isInterrupted() const;
 
+	// position and length in bytes of the currently processed markup
+	// (e.g. start tag) in the parsed stream; valid inside handlers only
+	size_t currentByteOffset() const;
+	size_t currentByteCount() const;
+
 protected:
 	void interrupt();
 
@@ -141,3 +141,11 @@ void ZLXMLReaderInternal::init(const char *encoding) {
 bool ZLXMLReaderInternal::parseBuffer(const char *buffer, size_t len) {
 	return XML_Parse(myParser, buffer, len, 0) != XML_STATUS_ERROR;
 }
+
+size_t ZLXMLReaderInternal::currentByteOffset() const {
+	return XML_GetCurrentByteIndex(myParser);
+}
+
+size_t ZLXMLReaderInternal::currentByteCount() const {
+	return XML_GetCurrentByteCount(myParser);
+}
@@ -38,6 +38,8 @@ public:
 	~ZLXMLReaderInternal();
 	void init(const char *encoding = 0);
 	bool parseBuffer(const char *buffer, size_t len);
+	size_t currentByteOffset() const;
+	size_t currentByteCount() const;
 
 private:
 	ZLXMLReader &myReader;
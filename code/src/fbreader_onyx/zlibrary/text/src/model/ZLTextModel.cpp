@@ -20,11 +20,13 @@
 #include <string.h>
 
 #include <algorithm>
+#include <map>
 
-#include <ZLSearchUtil.h>
+#include <ZLStringUtil.h>
 
 #include "ZLTextModel.h"
 #include "ZLTextParagraph.h"
+#include "ZLTextSearchIndex.h"
 
 ZLTextModel::ZLTextModel(const size_t rowSize) : myAllocator(rowSize), myLastEntryStart(0) {
 }
@@ -36,27 +38,16 @@ ZLTextModel::~ZLTextModel() {
 }
 
 void ZLTextModel::search(const std::string &text, size_t startIndex, size_t endIndex, bool ignoreCase) const {
-	ZLSearchPattern pattern(text, ignoreCase);
-	myMarks.clear();
-
-	std::vector<ZLTextParagraph*>::const_iterator start =
-		(startIndex < myParagraphs.size()) ? myParagraphs.begin() + startIndex : myParagraphs.end();
-	std::vector<ZLTextParagraph*>::const_iterator end =
-		(endIndex < myParagraphs.size()) ? myParagraphs.begin() + endIndex : myParagraphs.end();
-	for (std::vector<ZLTextParagraph*>::const_iterator it = start; it < end; ++it) {
-		int offset = 0;
-		for (ZLTextParagraph::Iterator jt = **it; !jt.isEnd(); jt.next()) {
-			if (jt.entryKind() == ZLTextParagraphEntry::TEXT_ENTRY) {
-				const ZLTextEntry& textEntry = (ZLTextEntry&)*jt.entry();
-				const char *str = textEntry.data();
-				const size_t len = textEntry.dataLength();
-				for (int pos = ZLSearchUtil::find(str, len, pattern); pos != -1; pos = ZLSearchUtil::find(str, len, pattern, pos + 1)) {
-					myMarks.push_back(ZLTextMark(it - myParagraphs.begin(), offset + pos, pattern.length()));
-				}
-				offset += len;
-			}
-		}
+	if (!mySearchIndex) {
+		mySearchIndex.reset(new ZLTextSearchIndex(myParagraphs));
 	}
+	mySearchIndex->search(text, startIndex, endIndex, ignoreCase, myMarks);
+}
+
+void ZLTextModel::removeAllMarks() {
+	myMarks.clear();
+	// index keeps a copy of the whole text, so it lives only while searching
+	mySearchIndex.reset();
 }
 
 void ZLTextModel::selectParagraph(size_t index) const {
@@ -107,11 +98,13 @@ ZLTextTreeModel::~ZLTextTreeModel() {
 void ZLTextModel::addParagraphInternal(ZLTextParagraph *paragraph) {
 	myParagraphs.push_back(paragraph);
 	myLastEntryStart = 0;
+	mySearchIndex.reset();
 }
 
 void ZLTextModel::removeParagraphInternal(int index) {
 	if ((index >= 0) && (index < (int)myParagraphs.size())) {
 		myParagraphs.erase(myParagraphs.begin() + index);
+		mySearchIndex.reset();
 	}
 }
 
@@ -154,6 +147,7 @@ void ZLTextPlainModel::createParagraph(ZLTextParagraph::Kind kind) {
 }
 
 void ZLTextModel::addText(const std::string &text) {
+	mySearchIndex.reset();
 	size_t len = text.length();
 	if ((myLastEntryStart != 0) && (*myLastEntryStart == ZLTextParagraphEntry::TEXT_ENTRY)) {
 		size_t oldLen = 0;
@@ -172,6 +166,7 @@ void ZLTextModel::addText(const std::string &text) {
 }
 
 void ZLTextModel::addText(const std::vector<std::string> &text) {
+	mySearchIndex.reset();
 	if (text.size() == 0) {
 		return;
 	}
@@ -277,3 +272,256 @@ void ZLTextModel::addBidiReset() {
 	*myLastEntryStart = ZLTextParagraphEntry::RESET_BIDI_ENTRY;
 	myParagraphs.back()->addEntry(myLastEntryStart);
 }
+
+// Bump SNAPSHOT_VERSION whenever encoding of paragraph entries changes;
+// sizes and kind values the encoding depends on are added to the format by
+// snapshotFormat(), so snapshots written for another layout are not read.
+#define SNAPSHOT_VERSION 1
+
+const std::string &ZLTextModel::snapshotFormat() {
+	static std::string format;
+	if (format.empty()) {
+		const unsigned int layout[] = {
+			SNAPSHOT_VERSION,
+			sizeof(size_t),
+			sizeof(char*),
+			sizeof(short),
+			sizeof(int),
+			ZLTextStyleEntry::NUMBER_OF_LENGTHS,
+			ZLTextParagraphEntry::TEXT_ENTRY,
+			ZLTextParagraphEntry::IMAGE_ENTRY,
+			ZLTextParagraphEntry::CONTROL_ENTRY,
+			ZLTextParagraphEntry::HYPERLINK_CONTROL_ENTRY,
+			ZLTextParagraphEntry::STYLE_ENTRY,
+			ZLTextParagraphEntry::FIXED_HSPACE_ENTRY,
+			ZLTextParagraphEntry::RESET_BIDI_ENTRY,
+		};
+		for (size_t i = 0; i < sizeof(layout) / sizeof(layout[0]); ++i) {
+			if (i > 0) {
+				format += '.';
+			}
+			ZLStringUtil::appendNumber(format, layout[i]);
+		}
+	}
+	return format;
+}
+
+static void writeNumber(std::string &buffer, unsigned int number) {
+	buffer.append((const char*)&number, sizeof(unsigned int));
+}
+
+static bool readNumber(char *&data, const char *end, unsigned int &number) {
+	if (end - data < (int)sizeof(unsigned int)) {
+		return false;
+	}
+	memcpy(&number, data, sizeof(unsigned int));
+	data += sizeof(unsigned int);
+	return true;
+}
+
+bool ZLTextModel::writeSnapshot(std::string &buffer) const {
+	std::map<const ZLTextParagraph*,unsigned int> treeIndices;
+	std::vector<unsigned int> imageOffsets;
+	std::string data;
+
+	writeNumber(buffer, myParagraphs.size());
+	for (size_t i = 0; i < myParagraphs.size(); ++i) {
+		const ZLTextParagraph &paragraph = *myParagraphs[i];
+		writeNumber(buffer, paragraph.kind());
+		if (paragraph.kind() == ZLTextParagraph::TREE_PARAGRAPH) {
+			const ZLTextTreeParagraph &treeParagraph = (const ZLTextTreeParagraph&)paragraph;
+			unsigned int parentNumber = 0;
+			if (treeParagraph.depth() > 1) {
+				std::map<const ZLTextParagraph*,unsigned int>::const_iterator it = treeIndices.find(treeParagraph.parent());
+				if (it == treeIndices.end()) {
+					return false;
+				}
+				parentNumber = it->second + 1;
+			}
+			writeNumber(buffer, parentNumber);
+			writeNumber(buffer, treeParagraph.isOpen() ? 1 : 0);
+			treeIndices[&paragraph] = i;
+		}
+
+		const size_t start = data.length();
+		const char *ptr = paragraph.myFirstEntryAddress;
+		for (size_t j = 0; j < paragraph.myEntryNumber; ++j) {
+			while (*ptr == 0) {
+				memcpy(&ptr, ptr + 1, sizeof(char*));
+			}
+			if (*ptr == ZLTextParagraphEntry::IMAGE_ENTRY) {
+				imageOffsets.push_back(data.length() + 1);
+			}
+			const size_t size = ZLTextParagraph::entrySize(ptr);
+			data.append(ptr, size);
+			ptr += size;
+		}
+		writeNumber(buffer, paragraph.myEntryNumber);
+		writeNumber(buffer, data.length() - start);
+	}
+
+	writeNumber(buffer, imageOffsets.size());
+	for (std::vector<unsigned int>::const_iterator it = imageOffsets.begin(); it != imageOffsets.end(); ++it) {
+		writeNumber(buffer, *it);
+	}
+	writeNumber(buffer, data.length());
+	buffer.append(data);
+	return true;
+}
+
+// Checks that entry at address ends before end, so that
+// ZLTextParagraph::entrySize() doesn't read past it.
+static bool isCompleteEntry(const char *address, const char *end) {
+	const char *ptr = address + 1;
+	int strings = 0;
+	switch (*address) {
+		case ZLTextParagraphEntry::TEXT_ENTRY:
+		{
+			size_t len;
+			if ((size_t)(end - ptr) < sizeof(size_t)) {
+				return false;
+			}
+			memcpy(&len, ptr, sizeof(size_t));
+			return len <= (size_t)(end - ptr) - sizeof(size_t);
+		}
+		case ZLTextParagraphEntry::CONTROL_ENTRY:
+		case ZLTextParagraphEntry::FIXED_HSPACE_ENTRY:
+			return ptr < end;
+		case ZLTextParagraphEntry::RESET_BIDI_ENTRY:
+			return true;
+		case ZLTextParagraphEntry::HYPERLINK_CONTROL_ENTRY:
+			ptr += 1;
+			strings = 2;
+			break;
+		case ZLTextParagraphEntry::IMAGE_ENTRY:
+			ptr += sizeof(const ZLImageMap*) + sizeof(short);
+			strings = 1;
+			break;
+		case ZLTextParagraphEntry::STYLE_ENTRY:
+		{
+			int mask;
+			if ((size_t)(end - ptr) < sizeof(int)) {
+				return false;
+			}
+			memcpy(&mask, ptr, sizeof(int));
+			ptr += sizeof(int) + ZLTextStyleEntry::NUMBER_OF_LENGTHS * (sizeof(short) + 1) + 4;
+			strings = (mask & ZLTextStyleEntry::SUPPORT_FONT_FAMILY) ? 1 : 0;
+			break;
+		}
+		default:
+			return false;
+	}
+	for (; strings > 0; --strings) {
+		if (ptr >= end) {
+			return false;
+		}
+		ptr = (const char*)memchr(ptr, '\0', end - ptr);
+		if (ptr == 0) {
+			return false;
+		}
+		++ptr;
+	}
+	return ptr <= end;
+}
+
+bool ZLTextModel::readSnapshot(char *&data, const char *end, const ZLImageMap &imageMap, shared_ptr<ZLUserData> storage) {
+	unsigned int paragraphsNumber;
+	if (!myParagraphs.empty() || !readNumber(data, end, paragraphsNumber)) {
+		return false;
+	}
+
+	std::vector<unsigned int> entryNumbers;
+	std::vector<unsigned int> dataLengths;
+	size_t fullLength = 0;
+	for (unsigned int i = 0; i < paragraphsNumber; ++i) {
+		unsigned int kind;
+		if (!readNumber(data, end, kind)) {
+			return false;
+		}
+		if (kind == ZLTextParagraph::TREE_PARAGRAPH) {
+			unsigned int parentNumber;
+			unsigned int isOpen;
+			if ((this->kind() != TREE_MODEL) ||
+					!readNumber(data, end, parentNumber) ||
+					!readNumber(data, end, isOpen) ||
+					(parentNumber > i)) {
+				return false;
+			}
+			ZLTextTreeParagraph *parent = (parentNumber > 0) ? (ZLTextTreeParagraph*)myParagraphs[parentNumber - 1] : 0;
+			((ZLTextTreeModel*)this)->createParagraph(parent)->open(isOpen != 0);
+		} else {
+			if ((this->kind() != PLAIN_TEXT_MODEL) || (kind > ZLTextParagraph::END_OF_TEXT_PARAGRAPH)) {
+				return false;
+			}
+			((ZLTextPlainModel*)this)->createParagraph((ZLTextParagraph::Kind)kind);
+		}
+		unsigned int entryNumber;
+		unsigned int dataLength;
+		if (!readNumber(data, end, entryNumber) || !readNumber(data, end, dataLength)) {
+			return false;
+		}
+		entryNumbers.push_back(entryNumber);
+		dataLengths.push_back(dataLength);
+		fullLength += dataLength;
+		if (fullLength > (size_t)(end - data)) {
+			return false;
+		}
+	}
+
+	unsigned int imagesNumber;
+	if (!readNumber(data, end, imagesNumber) || ((size_t)(end - data) < (size_t)imagesNumber * sizeof(unsigned int))) {
+		return false;
+	}
+	std::vector<unsigned int> imageOffsets(imagesNumber);
+	for (unsigned int i = 0; i < imagesNumber; ++i) {
+		readNumber(data, end, imageOffsets[i]);
+	}
+
+	unsigned int length;
+	if (!readNumber(data, end, length) || (length != fullLength) || ((size_t)(end - data) < fullLength)) {
+		return false;
+	}
+	char *entries = data;
+
+	// entries are used in place, so each of them must be complete and
+	// image offsets must point to image entries
+	std::vector<unsigned int>::const_iterator imageIt = imageOffsets.begin();
+	const char *ptr = entries;
+	for (unsigned int i = 0; i < paragraphsNumber; ++i) {
+		const char *paragraphEnd = ptr + dataLengths[i];
+		for (unsigned int j = 0; j < entryNumbers[i]; ++j) {
+			if ((ptr >= paragraphEnd) || !isCompleteEntry(ptr, paragraphEnd)) {
+				return false;
+			}
+			if (*ptr == ZLTextParagraphEntry::IMAGE_ENTRY) {
+				if ((imageIt == imageOffsets.end()) || (*imageIt != (unsigned int)(ptr - entries) + 1)) {
+					return false;
+				}
+				++imageIt;
+			}
+			ptr += ZLTextParagraph::entrySize(ptr);
+		}
+		if (ptr != paragraphEnd) {
+			return false;
+		}
+	}
+	if (imageIt != imageOffsets.end()) {
+		return false;
+	}
+	data += fullLength;
+
+	const ZLImageMap *imageMapAddress = &imageMap;
+	for (std::vector<unsigned int>::const_iterator it = imageOffsets.begin(); it != imageOffsets.end(); ++it) {
+		memcpy(entries + *it, &imageMapAddress, sizeof(const ZLImageMap*));
+	}
+
+	for (unsigned int i = 0; i < paragraphsNumber; ++i) {
+		ZLTextParagraph &paragraph = *myParagraphs[i];
+		paragraph.myFirstEntryAddress = entries;
+		paragraph.myEntryNumber = entryNumbers[i];
+		entries += dataLengths[i];
+	}
+	myLastEntryStart = 0;
+	mySnapshotStorage = storage;
+	return true;
+}
@@ -24,6 +24,8 @@
 #include <string>
 #include <algorithm>
 
+#include <ZLUserData.h>
+
 #include <ZLTextParagraph.h>
 #include <ZLTextKind.h>
 #include <ZLTextMark.h>
@@ -33,6 +35,7 @@ using namespace std;
 
 class ZLTextParagraph;
 class ZLTextTreeParagraph;
+class ZLTextSearchIndex;
 
 class ZLTextModel {
 	
@@ -72,6 +75,15 @@ public:
 	void addFixedHSpace(unsigned char length);
 	void addBidiReset();
 
+	// Snapshot contains paragraph entries in their in-memory layout, so it
+	// can be read back only by a build with the same entry layout; store
+	// snapshotFormat() with snapshots and read them only if it matches.
+	static const std::string &snapshotFormat();
+	bool writeSnapshot(std::string &buffer) const;
+	// Reads snapshot into an empty model; paragraph entries are not copied,
+	// they are used in place and storage keeps them alive.
+	bool readSnapshot(char *&data, const char *end, const ZLImageMap &imageMap, shared_ptr<ZLUserData> storage);
+
 protected:
 	void addParagraphInternal(ZLTextParagraph *paragraph);
 	void removeParagraphInternal(int index);
@@ -79,9 +91,12 @@ protected:
 private:
 	std::vector<ZLTextParagraph*> myParagraphs;
 	mutable std::vector<ZLTextMark> myMarks;
+	// built on first search, dropped when text changes or search is closed
+	mutable shared_ptr<ZLTextSearchIndex> mySearchIndex;
 	mutable ZLTextRowMemoryAllocator myAllocator;
 
 	char *myLastEntryStart;
+	shared_ptr<ZLUserData> mySnapshotStorage;
 
 private:
 	ZLTextModel(const ZLTextModel&);
@@ -116,7 +131,6 @@ private:
 
 inline size_t ZLTextModel::paragraphsNumber() const { return myParagraphs.size(); }
 inline const std::vector<ZLTextMark> &ZLTextModel::marks() const { return myMarks; }
-inline void ZLTextModel::removeAllMarks() { myMarks.clear(); }
 
 inline ZLTextParagraph *ZLTextModel::operator[] (size_t index) {
 	return myParagraphs[min(myParagraphs.size() - 1, index)];
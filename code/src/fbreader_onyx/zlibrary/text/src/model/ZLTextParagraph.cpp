@@ -113,63 +113,75 @@ const shared_ptr<ZLTextParagraphEntry> ZLTextParagraph::Iterator::entry() const
 	return myEntry;
 }
 
-void ZLTextParagraph::Iterator::next() {
-	++myIndex;
-	myEntry.reset();
-	if (myIndex != myEndIndex) {
-		switch (*myPointer) {
-			case ZLTextParagraphEntry::TEXT_ENTRY:
-			{
-				size_t len;
-				memcpy(&len, myPointer + 1, sizeof(size_t));
-				myPointer += len + sizeof(size_t) + 1;
-				break;
+size_t ZLTextParagraph::entrySize(const char *address) {
+	const char *ptr = address;
+	switch (*ptr) {
+		case ZLTextParagraphEntry::TEXT_ENTRY:
+		{
+			size_t len;
+			memcpy(&len, ptr + 1, sizeof(size_t));
+			ptr += len + sizeof(size_t) + 1;
+			break;
+		}
+		case ZLTextParagraphEntry::CONTROL_ENTRY:
+			ptr += 2;
+			break;
+		case ZLTextParagraphEntry::HYPERLINK_CONTROL_ENTRY:
+			ptr += 2;
+			while (*ptr != '\0') {
+				++ptr;
 			}
-			case ZLTextParagraphEntry::CONTROL_ENTRY:
-				myPointer += 2;
-				break;
-			case ZLTextParagraphEntry::HYPERLINK_CONTROL_ENTRY:
-				myPointer += 2;
-				while (*myPointer != '\0') {
-					++myPointer;
-				}
-				++myPointer;
-				while (*myPointer != '\0') {
-					++myPointer;
-				}
-				++myPointer;
-				break;
-			case ZLTextParagraphEntry::IMAGE_ENTRY:
-				myPointer += sizeof(const ZLImageMap*) + sizeof(short) + 1;
-				while (*myPointer != '\0') {
-					++myPointer;
-				}
-				++myPointer;
-				break;
-			case ZLTextParagraphEntry::STYLE_ENTRY:
-			{
-				int mask;
-				memcpy(&mask, myPointer + 1, sizeof(int));
-				bool withFontFamily = mask & ZLTextStyleEntry::SUPPORT_FONT_FAMILY;
-				myPointer += sizeof(int) + ZLTextStyleEntry::NUMBER_OF_LENGTHS * (sizeof(short) + 1) + 4;
-				if (withFontFamily) {
-					while (*myPointer != '\0') {
-						++myPointer;
-					}
-					++myPointer;
+			++ptr;
+			while (*ptr != '\0') {
+				++ptr;
+			}
+			++ptr;
+			break;
+		case ZLTextParagraphEntry::IMAGE_ENTRY:
+			ptr += sizeof(const ZLImageMap*) + sizeof(short) + 1;
+			while (*ptr != '\0') {
+				++ptr;
+			}
+			++ptr;
+			break;
+		case ZLTextParagraphEntry::STYLE_ENTRY:
+		{
+			int mask;
+			memcpy(&mask, ptr + 1, sizeof(int));
+			bool withFontFamily = mask & ZLTextStyleEntry::SUPPORT_FONT_FAMILY;
+			ptr += sizeof(int) + ZLTextStyleEntry::NUMBER_OF_LENGTHS * (sizeof(short) + 1) + 4;
+			if (withFontFamily) {
+				while (*ptr != '\0') {
+					++ptr;
 				}
-				break;
+				++ptr;
 			}
-			case ZLTextParagraphEntry::FIXED_HSPACE_ENTRY:
-				myPointer += 2;
-				break;
-			case ZLTextParagraphEntry::RESET_BIDI_ENTRY:
-				++myPointer;
-				break;
-		}
-		if (*myPointer == 0) {
-			memcpy(&myPointer, myPointer + 1, sizeof(char*));
+			break;
 		}
+		case ZLTextParagraphEntry::FIXED_HSPACE_ENTRY:
+			ptr += 2;
+			break;
+		case ZLTextParagraphEntry::RESET_BIDI_ENTRY:
+			++ptr;
+			break;
+	}
+	return ptr - address;
+}
+
+void ZLTextParagraph::Iterator::next() {
+	++myIndex;
+	myEntry.reset();
+	if (myIndex != myEndIndex) {
+		myPointer += entrySize(myPointer);
+		skipRowJumps();
+	}
+}
+
+void ZLTextParagraph::Iterator::skipRowJumps() {
+	// an entry moved to a new row by reallocateLast() leaves a jump in place
+	// of its old address, so there can be several jumps in a row
+	while (*myPointer == 0) {
+		memcpy(&myPointer, myPointer + 1, sizeof(char*));
 	}
 }
 
@@ -249,6 +249,9 @@ public:
 		const shared_ptr<ZLTextParagraphEntry> entry() const;
 		ZLTextParagraphEntry::Kind entryKind() const;
 
+	private:
+		void skipRowJumps();
+
 	private:
 		char *myPointer;
 		size_t myIndex;
@@ -280,6 +283,7 @@ public:
 
 private:
 	void addEntry(char *address);
+	static size_t entrySize(const char *address);
 
 private:
 	char *myFirstEntryAddress;
@@ -403,7 +407,7 @@ inline ZLTextParagraph::Kind ZLTextParagraph::kind() const { return TEXT_PARAGRA
 inline size_t ZLTextParagraph::entryNumber() const { return myEntryNumber; }
 inline void ZLTextParagraph::addEntry(char *address) { if (myEntryNumber == 0) myFirstEntryAddress = address; ++myEntryNumber; }
 
-inline ZLTextParagraph::Iterator::Iterator(const ZLTextParagraph &paragraph) : myPointer(paragraph.myFirstEntryAddress), myIndex(0), myEndIndex(paragraph.entryNumber()) {}
+inline ZLTextParagraph::Iterator::Iterator(const ZLTextParagraph &paragraph) : myPointer(paragraph.myFirstEntryAddress), myIndex(0), myEndIndex(paragraph.entryNumber()) { if (myEndIndex != 0) skipRowJumps(); }
 inline ZLTextParagraph::Iterator::~Iterator() {}
 inline bool ZLTextParagraph::Iterator::isEnd() const { return myIndex == myEndIndex; }
 inline ZLTextParagraphEntry::Kind ZLTextParagraph::Iterator::entryKind() const { return (ZLTextParagraphEntry::Kind)*myPointer; }
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2004-2009 Geometer Plus <contact@geometerplus.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <ZLUnicodeUtil.h>
+
+#include "ZLTextSearchIndex.h"
+#include "ZLTextParagraph.h"
+
+ZLTextSearchIndex::ZLTextSearchIndex(const std::vector<ZLTextParagraph*> &paragraphs) : myParagraphs(paragraphs), myLastStartIndex(0), myLastEndIndex(0), myLastIgnoreCase(false), myCachedParagraphIndex((size_t)-1) {
+	myParagraphOffsets.reserve(paragraphs.size());
+	for (std::vector<ZLTextParagraph*>::const_iterator it = paragraphs.begin(); it != paragraphs.end(); ++it) {
+		myParagraphOffsets.push_back(myText.length());
+		for (ZLTextParagraph::Iterator jt = **it; !jt.isEnd(); jt.next()) {
+			if (jt.entryKind() == ZLTextParagraphEntry::TEXT_ENTRY) {
+				const ZLTextEntry &textEntry = (ZLTextEntry&)*jt.entry();
+				appendFolded(myText, textEntry.data(), textEntry.dataLength());
+			}
+		}
+		myText += '\0';
+	}
+}
+
+void ZLTextSearchIndex::appendFolded(std::string &to, const char *from, size_t length) {
+	const char *end = from + length;
+	while (from < end) {
+		const unsigned char byte = *from;
+		if (byte < 0x80) {
+			to += ((byte >= 'A') && (byte <= 'Z')) ? (char)(byte + 'a' - 'A') : (char)byte;
+			++from;
+			continue;
+		}
+
+		size_t charLength = (byte < 0xC0) ? 1 : (byte < 0xE0) ? 2 : (byte < 0xF0) ? 3 : 4;
+		charLength = std::min(charLength, (size_t)(end - from));
+		if ((charLength == 2) || (charLength == 3)) {
+			ZLUnicodeUtil::Ucs4Char ch;
+			ZLUnicodeUtil::firstChar(ch, from);
+			char buffer[3];
+			if ((size_t)ZLUnicodeUtil::ucs4ToUtf8(buffer, ZLUnicodeUtil::toLower(ch)) == charLength) {
+				to.append(buffer, charLength);
+				from += charLength;
+				continue;
+			}
+		}
+		// symbols changing length with case are compared as is
+		to.append(from, charLength);
+		from += charLength;
+	}
+}
+
+void ZLTextSearchIndex::appendText(std::string &to, const ZLTextParagraph &paragraph) {
+	for (ZLTextParagraph::Iterator it = paragraph; !it.isEnd(); it.next()) {
+		if (it.entryKind() == ZLTextParagraphEntry::TEXT_ENTRY) {
+			const ZLTextEntry &textEntry = (ZLTextEntry&)*it.entry();
+			to.append(textEntry.data(), textEntry.dataLength());
+		}
+	}
+}
+
+void ZLTextSearchIndex::search(const std::string &text, size_t startIndex, size_t endIndex, bool ignoreCase, std::vector<ZLTextMark> &marks) {
+	marks.clear();
+	endIndex = std::min(endIndex, myParagraphOffsets.size());
+
+	std::string pattern;
+	appendFolded(pattern, text.data(), text.length());
+
+	const bool extendsLastQuery =
+		!myLastText.empty() &&
+		(ignoreCase == myLastIgnoreCase) &&
+		(startIndex == myLastStartIndex) &&
+		(endIndex == myLastEndIndex) &&
+		(text.compare(0, myLastText.length(), myLastText) == 0) &&
+		(pattern.compare(0, myLastPattern.length(), myLastPattern) == 0);
+
+	if (pattern.empty() || (startIndex >= endIndex)) {
+		myHits.clear();
+	} else if (extendsLastQuery) {
+		refine(pattern);
+	} else {
+		myHits.clear();
+		const size_t to = (endIndex < myParagraphOffsets.size()) ? myParagraphOffsets[endIndex] : myText.length();
+		find(pattern, myParagraphOffsets[startIndex], to);
+	}
+
+	if (!ignoreCase && !myHits.empty()) {
+		std::vector<size_t>::iterator last = myHits.begin();
+		for (std::vector<size_t>::const_iterator it = myHits.begin(); it != myHits.end(); ++it) {
+			if (matchesCase(*it, text)) {
+				*last++ = *it;
+			}
+		}
+		myHits.erase(last, myHits.end());
+	}
+
+	myLastText = text;
+	myLastPattern = pattern;
+	myLastStartIndex = startIndex;
+	myLastEndIndex = endIndex;
+	myLastIgnoreCase = ignoreCase;
+
+	marks.reserve(myHits.size());
+	size_t index = startIndex;
+	for (std::vector<size_t>::const_iterator it = myHits.begin(); it != myHits.end(); ++it) {
+		while ((index + 1 < myParagraphOffsets.size()) && (myParagraphOffsets[index + 1] <= *it)) {
+			++index;
+		}
+		marks.push_back(ZLTextMark(index, *it - myParagraphOffsets[index], pattern.length()));
+	}
+}
+
+void ZLTextSearchIndex::find(const std::string &pattern, size_t from, size_t to) {
+	const size_t length = pattern.length();
+	if (to - from < length) {
+		return;
+	}
+	const char *data = myText.data();
+	const char *ptr = data + from;
+	const char *last = data + to - length;
+	const char first = pattern[0];
+	while (ptr <= last) {
+		ptr = (const char*)memchr(ptr, first, last - ptr + 1);
+		if (ptr == 0) {
+			break;
+		}
+		if (memcmp(ptr + 1, pattern.data() + 1, length - 1) == 0) {
+			myHits.push_back(ptr - data);
+		}
+		++ptr;
+	}
+}
+
+void ZLTextSearchIndex::refine(const std::string &pattern) {
+	std::vector<size_t>::iterator last = myHits.begin();
+	for (std::vector<size_t>::const_iterator it = myHits.begin(); it != myHits.end(); ++it) {
+		if (myText.compare(*it, pattern.length(), pattern) == 0) {
+			*last++ = *it;
+		}
+	}
+	myHits.erase(last, myHits.end());
+}
+
+bool ZLTextSearchIndex::matchesCase(size_t position, const std::string &text) {
+	const size_t index = paragraphIndex(position);
+	if (index != myCachedParagraphIndex) {
+		myCachedParagraphText.erase();
+		appendText(myCachedParagraphText, *myParagraphs[index]);
+		myCachedParagraphIndex = index;
+	}
+	return myCachedParagraphText.compare(position - myParagraphOffsets[index], text.length(), text) == 0;
+}
+
+size_t ZLTextSearchIndex::paragraphIndex(size_t position) const {
+	return std::upper_bound(myParagraphOffsets.begin(), myParagraphOffsets.end(), position) - myParagraphOffsets.begin() - 1;
+}
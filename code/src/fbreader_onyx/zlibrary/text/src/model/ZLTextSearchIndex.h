@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2004-2009 Geometer Plus <contact@geometerplus.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __ZLTEXTSEARCHINDEX_H__
+#define __ZLTEXTSEARCHINDEX_H__
+
+#include <vector>
+#include <string>
+
+#include <ZLTextMark.h>
+
+class ZLTextParagraph;
+
+// Text of all paragraphs in one buffer, lower-cased symbol by symbol where
+// that keeps UTF-8 length, so offsets in the buffer are offsets in the
+// paragraph text and matches are not limited to one text entry. The last
+// query hits are kept: a query extending it checks those hits only.
+class ZLTextSearchIndex {
+
+public:
+	ZLTextSearchIndex(const std::vector<ZLTextParagraph*> &paragraphs);
+
+	void search(const std::string &text, size_t startIndex, size_t endIndex, bool ignoreCase, std::vector<ZLTextMark> &marks);
+
+private:
+	static void appendFolded(std::string &to, const char *from, size_t length);
+	static void appendText(std::string &to, const ZLTextParagraph &paragraph);
+
+	void find(const std::string &pattern, size_t from, size_t to);
+	void refine(const std::string &pattern);
+	bool matchesCase(size_t position, const std::string &text);
+	size_t paragraphIndex(size_t position) const;
+
+private:
+	const std::vector<ZLTextParagraph*> &myParagraphs;
+	// paragraphs are separated by '\0', so matches never cross them
+	std::string myText;
+	std::vector<size_t> myParagraphOffsets;
+
+	std::string myLastText;
+	std::string myLastPattern;
+	size_t myLastStartIndex;
+	size_t myLastEndIndex;
+	bool myLastIgnoreCase;
+	std::vector<size_t> myHits;
+
+	size_t myCachedParagraphIndex;
+	std::string myCachedParagraphText;
+
+private:
+	ZLTextSearchIndex(const ZLTextSearchIndex&);
+	const ZLTextSearchIndex &operator = (const ZLTextSearchIndex&);
+};
+
+#endif /* __ZLTEXTSEARCHINDEX_H__ */
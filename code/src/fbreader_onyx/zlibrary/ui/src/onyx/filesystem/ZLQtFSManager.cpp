@@ -66,6 +66,7 @@ ZLFileInfo ZLQtFSManager::fileInfo(const std::string &path) const
     result.Exists = info.exists();
     result.IsDirectory = info.isDir();
     result.Size = info.size();
+    result.MTime = info.lastModified().toTime_t();
     return result;
 }
 